@@ -1,132 +1,486 @@
+#pragma once
+
 #include <string>
 #include <memory>
 #include <vector>
-#include <unordered_map>
+#include <array>
+#include <cstdint>
+
+#include <json.hpp>
+#include <variableStore.hpp>
 
-enum class NodeType {
-  // Assignment //
+// Programs are lowered from `Json` into a tree of typed nodes once at load time.
+// Execution switches on `NodeType` and follows pre-resolved child pointers instead of string comparisons and map lookups.
+
+enum class NodeType : uint8_t {
+  NONE, // an empty slot left by the editor; throws when evaluated
+  // Variables //
   DEFINITION,
-  ASSIGN,
-  ADD_ASSIGN,
-  SUBTRACT_ASSIGN,
-  MULTIPLY_ASSIGN,
-  DIVIDE_ASSIGN,
-  MODULO_ASSIGN,
-  POWER_ASSIGN,
+  ASSIGNMENT,
+  INCREMENT,
+  DECREMENT,
+  // Control Flow //
+  BRANCH,
+  REPEAT,
+  WHILE,
+  FOREACH,
+  FOREVER,
+  PARALLEL,
+  JUMP,
+  CONDITIONAL_JUMP,
+  EXIT,
+  COMMENT,
+  // Procedures //
+  PROCEDURE,
+  CALL,
+  RETURN,
+  // Scripts //
+  SCRIPT,
+  YIELD,
+  WAIT,
+  WAIT_FRAME,
+  // Lists //
+  APPEND,
+  REMOVE,
+  // Rendering //
+  DRAW_LINE,
+  DRAW_RECT,
+  DRAW_PIXEL,
+  CLEAR_SCREEN,
+  // I/O //
+  PRINT,
+  CLEAR_OUTPUT,
   // Values //
   VARIABLE,
   LITERAL,
   LIST,
-  // Loops //
-  WHILE,
-  FOR,
-  REPEAT,
-  FOR_EACH,
-  // Lists //
-  APPEND,
   SUBSCRIPT,
-  REMOVE,
-  SIZE_OF,
-  // Functions //
+  SIZE,
+  RANGE,
+  // Unary Operations //
+  SIN,
+  COS,
+  TAN,
+  ASIN,
+  ACOS,
+  ATAN,
+  LOG,
+  LOG10,
+  LOG2,
+  SQRT,
+  CBRT,
+  ABS,
+  ROUND,
+  CEIL,
+  FLOOR,
+  // Binary Operations //
   ADD,
   SUBTRACT,
   MULTIPLY,
   DIVIDE,
   MODULO,
-  POWER,
-  // Comparisons //
-  BRANCH,
-  EQUAL,
-  NOT_EQUAL,
-  LESS_THAN,
-  LESS_THAN_EQUAL,
-  GREATER_THAN,
-  GREATER_THAN_EQUAL,
-  // Boolean //
+  EXPONENT,
+  MIN,
+  MAX,
+  RANDOM,
+  // Conditions //
   AND,
   OR,
-  NOT,
   XOR,
-  // Flow //
-  BREAK,
-  CONTINUE,
-  JUMP,
-  JUMP_IF,
-  // Rendering //
-  DRAW_LINE,
-  DRAW_RECTANGLE,
-  DRAW_CIRCLE,
-  DRAW_TEXT,
-  DRAW_IMAGE,
-  DRAW_PIXEL,
-  DRAW_CLEAR,
-  DRAW_SPRITE,
-  // I/O //
-  PRINT,
-  INPUT,
+  NOT,
+  EQ,
+  NE,
+  GT,
+  GE,
+  LT,
+  LE,
 };
 
-class Node {
-private:
-  std::string key;
-  NodeType node; 
-public:
-  Node(NodeType node, std::string key) : node{node}, key{key} { }
-  [[nodiscard]] inline NodeType getType() const { return node; }
-  [[nodiscard]] inline std::string getKey() const { return key; }
+[[nodiscard]] constexpr inline bool IsUnaryOperation(const NodeType type) { return type >= NodeType::SIN && type <= NodeType::FLOOR; }
+[[nodiscard]] constexpr inline bool IsOperation(const NodeType type) { return type >= NodeType::SIN && type <= NodeType::RANDOM; }
+[[nodiscard]] constexpr inline bool IsCondition(const NodeType type) { return type >= NodeType::AND && type <= NodeType::LE; }
+[[nodiscard]] constexpr inline bool IsComparison(const NodeType type) { return type >= NodeType::EQ && type <= NodeType::LE; }
+
+// The comparison that holds exactly when `type` does not
+[[nodiscard]] constexpr inline NodeType InvertComparison(const NodeType type) {
+  switch (type) {
+    case NodeType::EQ:  return NodeType::NE;
+    case NodeType::NE:  return NodeType::EQ;
+    case NodeType::GT:  return NodeType::LE;
+    case NodeType::GE:  return NodeType::LT;
+    case NodeType::LT:  return NodeType::GE;
+    case NodeType::LE:  return NodeType::GT;
+    default:            return type;
+  }
+}
+
+// The type an expression is proven to produce, inferred at load time; `ANY` is only known at runtime
+enum class ValueType : uint8_t {
+  NONE, // not yet inferred
+  INTEGER,
+  DOUBLE,
+  BOOLEAN,
+  STRING,
+  LIST,
+  ANY,
+};
+
+[[nodiscard]] ValueType GetValueType(const Value& value);
+[[nodiscard]] std::string GetNodeName(const NodeType type); // the `type` of the block in a program
+
+struct Node {
+  NodeType type;
+  ValueType valueType = ValueType::ANY;
+  std::string key; // the editor's block id, kept for diagnostics
+
+  Node(NodeType type, std::string key) : type{type}, key{std::move(key)} { }
 };
 
 typedef std::shared_ptr<Node> NodePtr;
 typedef std::vector<NodePtr> Nodes;
 
-class AbstractSyntaxTree final {
-private:
-  Nodes tree;
-public:
-  AbstractSyntaxTree() : tree{} { }
-  AbstractSyntaxTree(Nodes tree) : tree{tree} { }
+template<typename T>
+[[nodiscard]] inline const T& GetNode(const Node& node) { return static_cast<const T&>(node); }
 
-  inline void walk() {
-    for (const auto& node : tree)
-      std::cout << (int)node->getType() << std::endl;
-  }
+// Nodes are namespaced to keep them apart from their runtime counterparts ( `::Variable`... )
+namespace Ast {
+
+// Values //
+
+struct Literal final : Node {
+  Value value;
+  Literal(std::string key, Value value) : Node{NodeType::LITERAL, std::move(key)}, value{std::move(value)} { valueType = GetValueType(Literal::value); }
 };
 
-// typedef std::variant<int, float, double, std::string, bool> Any;
-constexpr int DEFAULT_LITERAL = 0;
-class Literal final : public Node {
-private:
-  Any value;
-public:
-  Literal(std::string key, Any value = DEFAULT_LITERAL) : Node{NodeType::LITERAL, key}, value{value} { }
-  [[nodiscard]] inline Any getValue() const { return value; }
+constexpr int UNRESOLVED = -1;
+
+struct Variable final : Node {
+  std::string definitionId;
+  int slot; // index into the `VariableStore`, resolved from `definitionId` at load time
+  Variable(std::string key, std::string definitionId, int slot = UNRESOLVED)
+  : Node{NodeType::VARIABLE, std::move(key)}, definitionId{std::move(definitionId)}, slot{slot} { }
 };
 
-class Print final : public Node {
-private:
-  NodePtr value;
-public:
-  Print(std::string key, NodePtr value) : Node{NodeType::PRINT, key}, value{value} { }
-  [[nodiscard]] inline NodePtr getValue() const { return value; }
+struct List final : Node {
+  Nodes elements;
+  NodePtr reserve; // `nullptr` when the list is not reserved
+  NodePtr fill;
+  bool uniform = false; // the fill draws no random numbers, so one evaluation fills every element
+  List(std::string key, Nodes elements, NodePtr reserve, NodePtr fill)
+  : Node{NodeType::LIST, std::move(key)}, elements{std::move(elements)}, reserve{std::move(reserve)}, fill{std::move(fill)} { }
+};
+
+// The integers from `start` up to, but excluding, `end`
+struct Range final : Node {
+  NodePtr start;
+  NodePtr end;
+  Range(std::string key, NodePtr start, NodePtr end) : Node{NodeType::RANGE, std::move(key)}, start{std::move(start)}, end{std::move(end)} { }
 };
 
+struct Subscript final : Node {
+  NodePtr list;
+  NodePtr index;
+  bool bounded = false; // the list is proven a list and the index within it, so neither is checked
+  Subscript(std::string key, NodePtr list, NodePtr index) : Node{NodeType::SUBSCRIPT, std::move(key)}, list{std::move(list)}, index{std::move(index)} { }
+};
+
+struct Size final : Node {
+  NodePtr list;
+  Size(std::string key, NodePtr list) : Node{NodeType::SIZE, std::move(key)}, list{std::move(list)} { }
+};
+
+// Arithmetic and boolean operations; `right` is `nullptr` for unary operations
+struct Operation final : Node {
+  NodePtr left;
+  NodePtr right;
+  ValueType operands = ValueType::ANY; // comparisons compare their operands as this type, inferred at load time
+  Operation(NodeType type, std::string key, NodePtr left, NodePtr right = nullptr)
+  : Node{type, std::move(key)}, left{std::move(left)}, right{std::move(right)} { }
+};
+
+// Statements //
+
+struct Definition final : Node {
+  std::string name;
+  Primitive primitive;
+  NodePtr expression;
+  int slot = UNRESOLVED;
+  Definition(std::string key, std::string name, Primitive primitive, NodePtr expression)
+  : Node{NodeType::DEFINITION, std::move(key)}, name{std::move(name)}, primitive{primitive}, expression{std::move(expression)} { }
+};
+
+struct Assignment final : Node {
+  std::shared_ptr<Variable> lvalue;
+  NodePtr rvalue;
+  Assignment(std::string key, std::shared_ptr<Variable> lvalue, NodePtr rvalue)
+  : Node{NodeType::ASSIGNMENT, std::move(key)}, lvalue{std::move(lvalue)}, rvalue{std::move(rvalue)} { }
+};
+
+// `increment` and `decrement`
+struct Increment final : Node {
+  std::shared_ptr<Variable> variable;
+  Increment(NodeType type, std::string key, std::shared_ptr<Variable> variable) : Node{type, std::move(key)}, variable{std::move(variable)} { }
+};
+
+struct Branch final : Node {
+  NodePtr condition;
+  Nodes consequent;
+  Nodes alternative; // empty when there is no `else` branch
+  Branch(std::string key, NodePtr condition, Nodes consequent, Nodes alternative)
+  : Node{NodeType::BRANCH, std::move(key)}, condition{std::move(condition)}, consequent{std::move(consequent)}, alternative{std::move(alternative)} { }
+};
+
+// `repeat`, `while`, `foreach`, and `forever`; `expression` is the repetition, condition, or list respectively
+struct Loop final : Node {
+  NodePtr expression;
+  Nodes components;
+  std::shared_ptr<Variable> element; // assigned each element of a `foreach` list, `nullptr` for other loops
+  Loop(NodeType type, std::string key, NodePtr expression, Nodes components, std::shared_ptr<Variable> element = nullptr)
+  : Node{type, std::move(key)}, expression{std::move(expression)}, components{std::move(components)}, element{std::move(element)} { }
+};
+
+// Runs its body for each element of `list` at once, across threads; the element each iteration ends with replaces it in the list once every iteration has finished.
+// The body is checked at load time to write only its element and its own definitions, which each iteration holds apart from the others.
+struct Parallel final : Node {
+  std::shared_ptr<Variable> list;
+  std::shared_ptr<Variable> element;
+  Nodes components;
+  std::vector<int> locals; // the slots each iteration holds apart: its element, then the definitions of its body
+  Parallel(std::string key, std::shared_ptr<Variable> list, std::shared_ptr<Variable> element, Nodes components)
+  : Node{NodeType::PARALLEL, std::move(key)}, list{std::move(list)}, element{std::move(element)}, components{std::move(components)} { }
+};
+
+// `jump` and `conditional_jump`; `condition` is `nullptr` for an unconditional jump
+struct Jump final : Node {
+  NodePtr expression;
+  NodePtr condition;
+  Jump(std::string key, NodePtr expression, NodePtr condition = nullptr)
+  : Node{condition ? NodeType::CONDITIONAL_JUMP : NodeType::JUMP, std::move(key)}, expression{std::move(expression)}, condition{std::move(condition)} { }
+};
+
+struct Append final : Node {
+  NodePtr list;
+  NodePtr item;
+  Append(std::string key, NodePtr list, NodePtr item) : Node{NodeType::APPEND, std::move(key)}, list{std::move(list)}, item{std::move(item)} { }
+};
+
+struct Remove final : Node {
+  NodePtr list;
+  NodePtr index;
+  Remove(std::string key, NodePtr list, NodePtr index) : Node{NodeType::REMOVE, std::move(key)}, list{std::move(list)}, index{std::move(index)} { }
+};
+
+// `draw_line` ( x1, y1, x2, y2 ), `draw_rect` ( x, y, w, h ), and `draw_pixel` ( x, y )
+struct Draw final : Node {
+  static constexpr int MAX_OPERANDS = 4;
+  std::array<NodePtr, MAX_OPERANDS> operands;
+  Draw(NodeType type, std::string key, std::array<NodePtr, MAX_OPERANDS> operands) : Node{type, std::move(key)}, operands{std::move(operands)} { }
+};
+
+struct Print final : Node {
+  NodePtr expression;
+  Print(std::string key, NodePtr expression) : Node{NodeType::PRINT, std::move(key)}, expression{std::move(expression)} { }
+};
+
+// Procedures //
+
+// Defined once at the top level, so it can be called before its definition; running the definition does nothing
+struct Procedure final : Node {
+  std::string name;
+  std::vector<std::shared_ptr<Definition>> parameters; // bound to the arguments of each call, in order
+  Nodes components;
+  std::vector<int> locals; // the slots of its parameters, definitions, and temporaries, in the order of their frame offsets
+  int index = 0; // among the procedures of the program
+  Procedure(std::string key, std::string name, std::vector<std::shared_ptr<Definition>> parameters, Nodes components)
+  : Node{NodeType::PROCEDURE, std::move(key)}, name{std::move(name)}, parameters{std::move(parameters)}, components{std::move(components)} { }
+};
+
+struct Call final : Node {
+  std::string procedureId;
+  Nodes arguments;
+  std::shared_ptr<Variable> result; // assigned the returned value, `nullptr` when it is discarded
+  Procedure* procedure = nullptr; // resolved from `procedureId` at load time, `nullptr` fails when called
+  bool tail = false; // the caller returns what the call does, so the call may replace the caller's frame
+  Call(std::string key, std::string procedureId, Nodes arguments, std::shared_ptr<Variable> result)
+  : Node{NodeType::CALL, std::move(key)}, procedureId{std::move(procedureId)}, arguments{std::move(arguments)}, result{std::move(result)} { }
+};
+
+struct Return final : Node {
+  NodePtr expression; // `nullptr` when no value is returned
+  Return(std::string key, NodePtr expression) : Node{NodeType::RETURN, std::move(key)}, expression{std::move(expression)} { }
+};
+
+// Scripts //
+
+// Defined once at the top level and started with the program, running beside its components; running the definition does nothing
+struct Script final : Node {
+  static constexpr int MIN_PRIORITY = 1;
+  static constexpr int MAX_PRIORITY = 8; // quanta run for each one of a script of the lowest priority
+  std::string name;
+  int priority;
+  Nodes components;
+  int index = 0; // among the scripts of the program, the program's own components being the first
+  Script(std::string key, std::string name, const int priority, Nodes components)
+  : Node{NodeType::SCRIPT, std::move(key)}, name{std::move(name)}, priority{priority}, components{std::move(components)} { }
+};
+
+// Suspends the running script for `duration` milliseconds, during which its engine may sleep
+struct Wait final : Node {
+  NodePtr duration;
+  Wait(std::string key, NodePtr duration) : Node{NodeType::WAIT, std::move(key)}, duration{std::move(duration)} { }
+};
+
+} // namespace Ast
+
 template<typename T>
-GetNode(NodePtr node) { return static_cast<T>(node); }
+[[nodiscard]] inline T& GetNode(Node& node) { return static_cast<T&>(node); }
 
-AbstractSyntaxTree buildTree(Json& json) {
-  AbstractSyntaxTree tree;
+// Traversal //
 
-  for (auto& [key, value] : json.items()) {
-    const auto type = value["type"].get<std::string>();
-    if (type == "print") {
-      nodes.push_back(std::make_shared<Print>(key, BuildNodes(value)));
+// Call `expression` with each child expression and `block` with each child body of `node`.
+// Assignment, increment, `foreach`, `parallel`, and call result targets are passed as copies: they may be modified, but not replaced.
+template<typename E, typename B>
+void VisitChildren(Node& node, E&& expression, B&& block) {
+  using namespace Ast;
+  switch (node.type) {
+    case NodeType::LIST: {
+      auto& list = GetNode<List>(node);
+      for (auto& element : list.elements) expression(element);
+      if (list.reserve) expression(list.reserve);
+      if (list.fill) expression(list.fill);
+      break;
+    }
+    case NodeType::SUBSCRIPT:
+      expression(GetNode<Subscript>(node).list);
+      expression(GetNode<Subscript>(node).index);
+      break;
+    case NodeType::SIZE:        expression(GetNode<Size>(node).list); break;
+    case NodeType::RANGE:
+      expression(GetNode<Range>(node).start);
+      expression(GetNode<Range>(node).end);
+      break;
+    case NodeType::DEFINITION:  expression(GetNode<Definition>(node).expression); break;
+    case NodeType::ASSIGNMENT: {
+      auto& assignment = GetNode<Assignment>(node);
+      NodePtr lvalue = assignment.lvalue;
+      expression(lvalue);
+      expression(assignment.rvalue);
+      break;
+    }
+    case NodeType::INCREMENT:
+    case NodeType::DECREMENT: {
+      NodePtr variable = GetNode<Increment>(node).variable;
+      expression(variable);
+      break;
+    }
+    case NodeType::BRANCH: {
+      auto& branch = GetNode<Branch>(node);
+      expression(branch.condition);
+      block(branch.consequent);
+      block(branch.alternative);
+      break;
     }
+    case NodeType::REPEAT:
+    case NodeType::WHILE:
+    case NodeType::FOREACH:
+    case NodeType::FOREVER: {
+      auto& loop = GetNode<Loop>(node);
+      if (loop.expression) expression(loop.expression);
+      if (loop.element) {
+        NodePtr element = loop.element;
+        expression(element);
+      }
+      block(loop.components);
+      break;
+    }
+    case NodeType::PARALLEL: {
+      auto& parallel = GetNode<Parallel>(node);
+      NodePtr list = parallel.list;
+      NodePtr element = parallel.element;
+      expression(list);
+      expression(element);
+      block(parallel.components);
+      break;
+    }
+    case NodeType::JUMP:
+    case NodeType::CONDITIONAL_JUMP: {
+      auto& jump = GetNode<Jump>(node);
+      expression(jump.expression);
+      if (jump.condition) expression(jump.condition);
+      break;
+    }
+    case NodeType::APPEND:
+      expression(GetNode<Append>(node).list);
+      expression(GetNode<Append>(node).item);
+      break;
+    case NodeType::REMOVE:
+      expression(GetNode<Remove>(node).list);
+      expression(GetNode<Remove>(node).index);
+      break;
+    case NodeType::DRAW_LINE:
+    case NodeType::DRAW_RECT:
+    case NodeType::DRAW_PIXEL:
+      for (auto& operand : GetNode<Draw>(node).operands) if (operand) expression(operand);
+      break;
+    case NodeType::PRINT: expression(GetNode<Print>(node).expression); break;
+    case NodeType::PROCEDURE: block(GetNode<Procedure>(node).components); break;
+    case NodeType::CALL: {
+      auto& call = GetNode<Call>(node);
+      for (auto& argument : call.arguments) expression(argument);
+      if (call.result) {
+        NodePtr result = call.result;
+        expression(result);
+      }
+      break;
+    }
+    case NodeType::RETURN:
+      if (auto& value = GetNode<Return>(node).expression) expression(value);
+      break;
+    case NodeType::SCRIPT: block(GetNode<Script>(node).components); break;
+    case NodeType::WAIT: expression(GetNode<Wait>(node).duration); break;
+    default:
+      if (IsOperation(node.type) || IsCondition(node.type)) {
+        auto& operation = GetNode<Operation>(node);
+        expression(operation.left);
+        if (operation.right) expression(operation.right);
+      }
+      break;
+  }
+}
+
+// Tree //
+
+class AbstractSyntaxTree final {
+private:
+  Nodes tree;
+  std::vector<std::string> slots; // the `definitionId` held by each variable slot
+  std::vector<int> offsets; // where each slot is found in the frame of its procedure, `VariableStore::GLOBAL` outside of one
+public:
+  AbstractSyntaxTree() : tree{}, slots{} { }
+  explicit AbstractSyntaxTree(Nodes tree, std::vector<std::string> slots = {}, std::vector<int> offsets = {})
+  : tree{std::move(tree)}, slots{std::move(slots)}, offsets{std::move(offsets)} { this->offsets.resize(this->slots.size(), VariableStore::GLOBAL); }
 
-    else if (type == "literal")
-      nodes.push_back(std::make_shared<Literal>(key, BuildNodes(value)));
+  [[nodiscard]] inline const Nodes& GetTree() const { return tree; }
+  [[nodiscard]] inline Nodes& GetTree() { return tree; }
+  [[nodiscard]] inline const std::vector<std::string>& GetSlots() const { return slots; }
+  [[nodiscard]] inline const std::vector<int>& GetOffsets() const { return offsets; }
+  [[nodiscard]] inline bool IsLocal(const int slot) const { return slot >= 0 && slot < (int)offsets.size() && offsets[slot] != VariableStore::GLOBAL; }
 
-    else throw std::runtime_error("Unknown node type: " + type);
+  // A variable introduced by a pass, local to `procedure` when it is introduced within its body
+  inline int AddSlot(std::string key, Ast::Procedure* procedure = nullptr) {
+    slots.push_back(std::move(key));
+    offsets.push_back(procedure ? (int)procedure->locals.size() : VariableStore::GLOBAL);
+    if (procedure) procedure->locals.push_back(slots.size() - 1);
+    return slots.size() - 1;
   }
+  [[nodiscard]] inline bool Empty() const { return tree.empty(); }
+};
+
+// Copy `node` and everything beneath it, so the copy can be rewritten apart from the original
+[[nodiscard]] NodePtr Clone(const Node& node);
+
+// Lower a program (an array of blocks) into typed nodes and resolve its variables to slots; throws `std::invalid_argument` on malformed blocks
+[[nodiscard]] AbstractSyntaxTree BuildTree(Json& program);
 
-  return tree
-}
\ No newline at end of file
+// Parse and lower a serialized program
+[[nodiscard]] AbstractSyntaxTree ParseProgram(const std::string& source);
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <ast.hpp>
+#include <variableStore.hpp>
+
+// Flat register-based instruction stream executed by the `VirtualMachine`.
+// Operands `a`, `b`, and `c` are register indices, variable slots, pool indices, or absolute jump targets depending on the opcode.
+// Arithmetic opcodes read integers unchecked, the compiler only emits them for operands proven to be integers; `REAL` reads doubles unchecked, with integer operands promoted first; anything else uses `NUMERIC`.
+
+enum class Opcode : uint8_t {
+  // Values //
+  LOAD_CONSTANT,      // r[a] = constants[b]
+  LOAD,               // r[a] = store[b]
+  STORE,              // store[a] = r[b]
+  DEFINE,             // define definitions[a] with r[b]
+  DEFINE_DEFAULT,     // define definitions[a] with the default of its primitive
+  INCREMENT,          // ++store[a]
+  DECREMENT,          // --store[a]
+  INCREMENT_INTEGER,  // store[a] += b, where store[a] is proven an integer
+  // Lists //
+  NEW_LIST,           // r[a] = []
+  PUSH,               // r[a].push(r[b])
+  RESERVE,            // range check r[a] as a list reserve, leaving an integer
+  FILL,               // r[a] = r[c] copies of r[b], where r[c] is a checked reserve
+  RANGE,              // r[a] = the integers from r[b] up to r[c]
+  INDEX,              // r[a] = r[b][r[c]]
+  ELEMENT,            // r[a] = r[b][r[c]], where r[b] is proven a list and r[c] an integer within it
+  ITERATE,            // check r[a] is a list to iterate, r[b] = its size
+  APPEND,             // store[a].push(r[b])
+  REMOVE,             // store[a].erase(r[b])
+  SIZE,               // r[a] = size of r[b]
+  // Arithmetic //
+  ADD,                // r[a] = r[b] + r[c]
+  SUBTRACT,
+  MULTIPLY,
+  DIVIDE,
+  MODULO,
+  EXPONENT,
+  MIN,
+  MAX,
+  RANDOM,
+  MATH,               // r[a] = operation( r[b] )
+  NUMERIC,            // r[a] = operation( r[b], r[c] ) of any numbers
+  REAL,               // r[a] = operation( r[b], r[c] ) of proven doubles
+  PROMOTE,            // r[a] = r[a] as a double, where r[a] is proven an integer
+  // Conditions //
+  EQ,                 // r[a] = r[b] == r[c]
+  NE,
+  GT,
+  GE,
+  LT,
+  LE,
+  AND,
+  OR,
+  XOR,
+  NOT,                // r[a] = !r[b]
+  COMPARE_INTEGER,    // r[a] = r[b] operation r[c], proven integers
+  // Control Flow //
+  JUMP,               // pc = a
+  JUMP_IF,            // if (r[a]) pc = b
+  JUMP_UNLESS,        // if (!r[a]) pc = b
+  JUMP_COMPARE,       // if (r[a] operation r[b]) pc = c
+  JUMP_COMPARE_INTEGER, // if (r[a] operation r[b]) pc = c, proven integers
+  REPEAT,             // range check r[a] as a repeat count, leaving an integer
+  STEP,               // ++r[a]
+  PARALLEL,           // run parallels[a] across the thread pool
+  HALT,               // finish every script
+  FAIL,               // throw constants[a]
+  // Procedures //
+  CALL,               // call calls[a] with the arguments in r[b..], whose registers start its own; replacing the caller's frame when c
+  RETURN,             // return r[a] when b, otherwise no value
+  // Scripts //
+  YIELD,              // end the quantum of the running script
+  WAIT,               // suspend the running script for r[a] milliseconds
+  WAIT_FRAME,         // suspend the running script until the next frame
+  END,                // finish the running script
+  // Rendering //
+  DRAW_LINE,          // r[a..a+3]
+  DRAW_RECT,          // r[a..a+3]
+  DRAW_PIXEL,         // r[a..a+1]
+  CLEAR_SCREEN,
+  // I/O //
+  PRINT,              // print r[a]
+  CLEAR_OUTPUT,
+  // Superinstructions //
+  // fused by the `Peephole` pass over the first instruction of a sequence, which stays in place after it for jumps landing inside
+  LOOP,               // if (++r[a] < r[b]) pc = c; STEP + JUMP_COMPARE_INTEGER
+  JUMP_COMPARE_OPERANDS, // if (operand a operation operand b) pc = c; two loads + JUMP_COMPARE
+  JUMP_COMPARE_INTEGER_OPERANDS, // two loads + JUMP_COMPARE_INTEGER
+  DRAW_OPERANDS,      // draw operation with operands[a..], skipping b loads; loads + DRAW_*
+};
+
+// Superinstructions read variables and constants directly: a slot is its own operand, a constant is `-index - 1`
+[[nodiscard]] constexpr inline int ConstantOperand(const int index) { return -index - 1; }
+[[nodiscard]] constexpr inline bool IsConstantOperand(const int operand) { return operand < 0; }
+[[nodiscard]] constexpr inline int GetConstantIndex(const int operand) { return -operand - 1; }
+
+struct Instruction {
+  Opcode op;
+  NodeType operation = NodeType::NONE; // for `MATH`, `NUMERIC`, `REAL`, and comparisons
+  int a = 0;
+  int b = 0;
+  int c = 0;
+};
+
+static_assert(sizeof(Instruction) == 16, "Instructions should stay within 16 bytes");
+
+struct Bytecode {
+  std::vector<Instruction> code;
+  std::vector<const Node*> sources; // the block each instruction was compiled from, for diagnostics
+  std::vector<Value> constants;
+  std::vector<int> operands; // operand lists of superinstructions
+  std::vector<const Ast::Definition*> definitions;
+  std::vector<const Ast::Call*> calls;
+  std::vector<const Ast::Parallel*> parallels;
+  std::vector<int> entries; // the first instruction of each procedure, by index
+  std::vector<int> starts; // the first instruction of each script, by index; the program's own components start at 0
+  int registers = 0; // of a frame, each call takes its own above the arguments of its caller
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <ast.hpp>
+#include <bytecode.hpp>
+
+// Compiles a lowered program into `Bytecode`.
+// Registers are allocated as a stack: a statement releases its temporaries, loops hold their counters for the length of their body.
+// Procedure bodies follow the program, each call runs them in registers above its arguments. Script bodies follow them, each in registers of its own.
+class Compiler final {
+private:
+  Bytecode bytecode;
+  int top = 0; // next free register
+  const Node* source = nullptr; // statement being compiled
+  const Ast::Procedure* procedure = nullptr; // whose body is being compiled
+
+  int Emit(const Opcode op, const int a = 0, const int b = 0, const int c = 0);
+  int EmitOperation(const Opcode op, const NodeType operation, const int a, const int b, const int c);
+  void EmitStep(const Ast::Variable& variable, const int amount); // `increment` and `decrement`
+  inline int Here() const { return bytecode.code.size(); }
+  void Patch(const int at, const int target); // point a jump at `target`
+
+  int Allocate();
+  int Constant(Value value);
+  void Fail(const std::string& message);
+
+  void CompileComponents(const Nodes& components);
+  void CompileComponent(const Node& component);
+  void CompileExpression(const Node& expression, const int target);
+  [[nodiscard]] std::vector<int> CompileJump(const Node& condition, const bool when);
+
+  void CompileList(const Ast::List& list, const int target);
+  void CompileBranch(const Ast::Branch& branch);
+  void CompileRepeat(const Ast::Loop& repeat);
+  void CompileWhile(const Ast::Loop& loop);
+  void CompileForeach(const Ast::Loop& foreach);
+  void CompileForever(const Ast::Loop& forever);
+  void CompileCall(const Ast::Call& call);
+  void CompileReturn(const Ast::Return& ret);
+  void CompileDraw(const Ast::Draw& draw, const Opcode op, const int operands);
+public:
+  [[nodiscard]] Bytecode Compile(const AbstractSyntaxTree& program);
+};
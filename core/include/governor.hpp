@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <cstdint>
+#include <exception>
+
+#include <time.hpp>
+
+// Holds a program to the quotas its host sets, so one runaway program can not starve the others; a quota of 0 is unlimited.
+// The `Runtime` charges the instructions each batch ran, and measures time, memory, and output once a frame, so checks cost little beside the work they limit.
+// The engines stop a list or the output from growing past its quota themselves, as one frame can append or print thousands of values.
+// A tripped quota stops the program with its `Reason` rather than an exception.
+class Governor final {
+public:
+  // Why the program was stopped
+  enum class Reason : uint8_t { NONE, CANCELLED, INSTRUCTIONS, TIME, MEMORY, LIST, OUTPUT };
+
+  struct Quotas {
+    long long instructions = 0; // run, compiled loops included
+    Time::milliseconds time{0}; // of wall time since the program started, waits included
+    long long memory = 0; // bytes held by variables, locals included, see `VariableStore::Measure`
+    int list = 0; // elements of any list a variable holds
+    long long output = 0; // values printed
+  };
+
+  // Thrown by an engine that would grow what a quota limits past it
+  class Exceeded final : public std::exception {
+  public:
+    const Reason reason;
+    explicit Exceeded(const Reason reason) : reason{reason} { }
+    [[nodiscard]] inline const char* what() const noexcept override { return GetReasonName(reason); }
+  };
+private:
+  Quotas quotas;
+  std::atomic<bool> cancelled = false;
+  Reason reason = Reason::NONE;
+  Time::steady_clock::time_point start;
+
+  [[nodiscard]] static inline bool Over(const long long used, const long long quota) { return quota > 0 && used > quota; }
+public:
+  inline void SetQuotas(const Quotas& quotas) { Governor::quotas = quotas; }
+  [[nodiscard]] inline const Quotas& GetQuotas() const { return quotas; }
+
+  // Whether memory and list lengths are limited, which is the only time variables are measured
+  [[nodiscard]] inline bool Measures() const { return quotas.memory > 0 || quotas.list > 0; }
+
+  // Stop the running program at its next batch, or before its first when it has not started; safe to call from any thread
+  inline void Cancel() { cancelled.store(true, std::memory_order_relaxed); }
+
+  // Forget a cancel meant for the previous program, as another is loaded
+  inline void Reset() { cancelled.store(false, std::memory_order_relaxed); }
+
+  // Start timing a program, keeping any cancel already pending
+  inline void Start() {
+    reason = Reason::NONE;
+    start = Time::Now();
+  }
+
+  // Record why the program must stop; returns false to be returned by the checks
+  inline bool Trip(const Reason reason) {
+    Governor::reason = reason;
+    return false;
+  }
+
+  // Charge the instructions `executed` since the program was loaded; false once the program must stop
+  [[nodiscard]] inline bool Charge(const long long executed) {
+    if (cancelled.load(std::memory_order_relaxed)) return Trip(Reason::CANCELLED);
+    return !Over(executed, quotas.instructions) || Trip(Reason::INSTRUCTIONS);
+  }
+
+  // Check the time taken, what variables hold, and the values printed, once a frame; false once the program must stop
+  [[nodiscard]] inline bool Check(const long long memory, const int longest, const long long output) {
+    if (cancelled.load(std::memory_order_relaxed)) return Trip(Reason::CANCELLED);
+    if (quotas.time.count() > 0 && Time::Elapsed(start, quotas.time)) return Trip(Reason::TIME);
+    if (Over(memory, quotas.memory)) return Trip(Reason::MEMORY);
+    if (Over(longest, quotas.list)) return Trip(Reason::LIST);
+    if (Over(output, quotas.output)) return Trip(Reason::OUTPUT);
+    return true;
+  }
+
+  [[nodiscard]] inline Reason GetReason() const { return reason; }
+
+  [[nodiscard]] static inline const char* GetReasonName(const Reason reason) {
+    switch (reason) {
+      case Reason::NONE:          return "none";
+      case Reason::CANCELLED:     return "cancelled";
+      case Reason::INSTRUCTIONS:  return "instructions";
+      case Reason::TIME:          return "time";
+      case Reason::MEMORY:        return "memory";
+      case Reason::LIST:          return "list";
+      case Reason::OUTPUT:        return "output";
+    }
+    return "none";
+  }
+
+  // What the program was stopped for, to print
+  [[nodiscard]] inline std::string Describe() const {
+    using std::to_string;
+    switch (reason) {
+      case Reason::CANCELLED:     return "the program was cancelled";
+      case Reason::INSTRUCTIONS:  return "the program ran more than its quota of " + to_string(quotas.instructions) + " instructions";
+      case Reason::TIME:          return "the program ran longer than its quota of " + to_string(quotas.time.count()) + "ms";
+      case Reason::MEMORY:        return "the program's variables held more than its quota of " + to_string(quotas.memory) + " bytes";
+      case Reason::LIST:          return "a list grew past the program's quota of " + to_string(quotas.list) + " elements";
+      case Reason::OUTPUT:        return "the program printed more than its quota of " + to_string(quotas.output) + " values";
+      default:                    return "";
+    }
+  }
+};
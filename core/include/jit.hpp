@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <bytecode.hpp>
+#include <variableStore.hpp>
+
+// Loops are compiled to machine code on x86-64 Linux, elsewhere the `VirtualMachine` only interprets
+#if defined(__x86_64__) && defined(__linux__) && !defined(__EMSCRIPTEN__)
+#define __JIT__ 1
+#else
+#define __JIT__ 0
+#endif // __x86_64__ && __linux__
+
+// Compiles hot loops of `Bytecode` to x86-64 machine code.
+// Integer arithmetic, comparisons, booleans, variable access, and control flow are compiled natively; other supported instructions call back into the interpreter one at a time.
+// Compiled code leaves to the interpreter at the instruction it can not run: on a type mismatch, an unsupported instruction, an error, or once its budget is spent.
+class Jit final {
+public:
+  typedef void* MachinePtr;
+  typedef int (*Helper)(MachinePtr machine, int at); // run the instruction `at`, returning the next pc or `FAILED`
+  typedef int (*Entry)(Value* registers, int64_t* fuel); // returns the pc to resume interpreting at
+
+  static constexpr int FAILED = -1;
+  static constexpr int HOT_LOOP = 64; // back-edges taken before a loop is compiled
+
+  struct Trace final {
+    Entry entry = nullptr;
+    void* memory = nullptr;
+    size_t size = 0;
+    std::vector<int> registers; // accessed by the compiled code, which copies them without reference counting
+    std::vector<int> slots;
+    int refusals = 0; // consecutive entries refused
+
+    Trace() = default;
+    Trace(const Trace&) = delete;
+    Trace& operator=(const Trace&) = delete;
+    ~Trace();
+  };
+private:
+  static constexpr int COLD = -1; // the loop can not be compiled
+  static constexpr int MAX_REFUSALS = 1024; // entries refused before a trace is discarded
+
+  std::vector<int> heat; // back-edges taken to each instruction
+  std::vector<std::unique_ptr<Trace>> traces; // by loop head
+public:
+  // Forget every trace, ready for a program of `instructions`
+  void Reset(const int instructions);
+
+  [[nodiscard]] inline Trace* Find(const int head) { return traces[head].get(); }
+
+  // Count a back-edge to `head`; true once the loop is hot and should be compiled
+  [[nodiscard]] inline bool Heat(const int head) { return heat[head] != COLD && ++heat[head] >= HOT_LOOP; }
+
+  // Compile the loop at `head`, up to the last instruction jumping back to it; `nullptr` when it can not be compiled yet
+  [[nodiscard]] Trace* Compile(const Bytecode& bytecode, const int head, VariableStore& store, Helper helper, MachinePtr machine);
+
+  // Compiled code copies values without reference counting, so it only runs while the values it accesses hold no strings or lists
+  [[nodiscard]] bool Enter(const int head, const Value* registers, const VariableStore& store);
+};
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+
+#include <ast.hpp>
+#include <random.hpp>
+
+// Arithmetic and comparisons shared by the execution engines
+namespace Kernel {
+  template<typename T>
+  [[nodiscard]] inline T Unary(const NodeType type, const T value) {
+    switch (type) {
+      case NodeType::SIN:         return std::sin(value);
+      case NodeType::COS:         return std::cos(value);
+      case NodeType::TAN:         return std::tan(value);
+      case NodeType::ASIN:        return std::asin(value);
+      case NodeType::ACOS:        return std::acos(value);
+      case NodeType::ATAN:        return std::atan(value);
+
+      case NodeType::LOG:         return std::log(value);
+      case NodeType::LOG10:       return std::log10(value);
+      case NodeType::LOG2:        return std::log2(value);
+
+      case NodeType::SQRT:        return std::sqrt(value);
+      case NodeType::CBRT:        return std::cbrt(value);
+
+      case NodeType::ABS:         return std::abs(value);
+      case NodeType::ROUND:       return std::round(value);
+      case NodeType::CEIL:        return std::ceil(value);
+      case NodeType::FLOOR:       return std::floor(value);
+
+      default: throw std::invalid_argument("Invalid operation TYPE provided!");
+    }
+  }
+
+  template<typename T>
+  [[nodiscard]] inline T Binary(const NodeType type, const T lvalue, const T rvalue) {
+    switch (type) {
+      case NodeType::ADD:         return lvalue + rvalue;
+      case NodeType::SUBTRACT:    return lvalue - rvalue;
+      case NodeType::MULTIPLY:    return lvalue * rvalue;
+      case NodeType::DIVIDE:      return lvalue / rvalue;
+      case NodeType::MODULO:      return (int)lvalue % (int)rvalue; // only integers can be modded
+      case NodeType::EXPONENT:    return std::pow(lvalue, rvalue);
+
+      case NodeType::MIN:         return std::min(lvalue, rvalue);
+      case NodeType::MAX:         return std::max(lvalue, rvalue);
+
+      case NodeType::RANDOM:      return Random::generate(lvalue, rvalue);
+
+      default: throw std::invalid_argument("Invalid operation TYPE provided!");
+    }
+  }
+
+  // Apply an operation to values whose types are only known at runtime: integers use integer math, any double promotes both operands
+  [[nodiscard]] inline Value Arithmetic(const NodeType type, const Value& lvalue, const Value& rvalue) {
+    const bool unary = IsUnaryOperation(type);
+    if (lvalue.Is<int>() && (unary || rvalue.Is<int>()))
+      return unary ? Unary<int>(type, lvalue.As<int>()) : Binary<int>(type, lvalue.As<int>(), rvalue.As<int>());
+
+    const auto left = lvalue.GetNumber<double>();
+    return unary ? Unary<double>(type, left) : Binary<double>(type, left, rvalue.GetNumber<double>());
+  } // throws `std::bad_variant_access`
+
+  template<typename T>
+  [[nodiscard]] inline bool Compare(const NodeType type, const T& lvalue, const T& rvalue) {
+    switch (type) {
+      case NodeType::EQ:  return lvalue == rvalue;
+      case NodeType::NE:  return lvalue != rvalue;
+      case NodeType::GT:  return lvalue > rvalue;
+      case NodeType::GE:  return lvalue >= rvalue;
+      case NodeType::LT:  return lvalue < rvalue;
+      case NodeType::LE:  return lvalue <= rvalue;
+      default: throw std::invalid_argument("Invalid TYPE for a BINARY conditional expression");
+    }
+  }
+}
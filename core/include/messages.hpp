@@ -0,0 +1,12 @@
+#pragma once
+
+// Messages printed to the client by the runtime and by transpiled programs
+
+constexpr auto startMessageStart = "<span style=\"color:var(--colors-text2);\">program started at ";
+constexpr auto startMessageEnd = "</span><br/><br/>";
+constexpr auto doneMessageStart = "<span style=\"color:var(--colors-text2);\">program completed in "; 
+constexpr auto doneMessageEnd = "</span><br/><br/>";
+constexpr auto errorMessageStart = "<div style=\"color:var(--colors-onError);background-color:var(--colors-error);border-radius:8px;padding:8px\"><strong>Component</strong> encountered an error:<div style=\"padding:8px;\">";
+constexpr auto errorMessageEnd = "</div></div><br/><br/>";
+constexpr auto stopMessageStart = "<div style=\"color:var(--colors-onError);background-color:var(--colors-error);border-radius:8px;padding:8px\"><strong>Component</strong> stopped:<div style=\"padding:8px;\">";
+constexpr auto stopMessageEnd = "</div></div><br/><br/>";
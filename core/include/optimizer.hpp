@@ -0,0 +1,121 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include <ast.hpp>
+
+// Rewrites a lowered program before execution: folds constant operations and conditions, removes branches with constant conditions, and drops comments and empty bodies.
+// Calls of small procedures that call nothing are replaced by their body.
+// Loops then have invariant expressions hoisted before them and multiplications of their induction variables reduced to additions, where types are proven.
+// Index loops over a list they do not edit read its elements without bounds checks.
+// Finally structurally identical expressions share one node, and a block evaluates a repeated expression once while the variables it reads are unchanged.
+// Statements are only moved within bodies whose jumps can be re-targeted, so the program behaves exactly as written.
+// Scripts run beside each other, so a variable another script writes is never assumed unchanged between two statements.
+// The bodies of `parallel` blocks are given no temporaries of their own, as their iterations only hold the variables checked at load time.
+class Optimizer final {
+public:
+  struct Report {
+    int folded = 0; // operations and conditions replaced by a literal
+    int branches = 0; // branches replaced by the body they always take
+    int comments = 0;
+    int bodies = 0; // statements with nothing to execute
+    int hoisted = 0; // loop invariant expressions evaluated once before their loop
+    int reduced = 0; // multiplications of an induction variable replaced by an addition each iteration
+    int shared = 0; // expressions replaced by a structurally identical node
+    int reused = 0; // evaluations of a repeated expression replaced by reading its earlier result
+    int bounded = 0; // subscripts of an index loop proven within their list
+    int inlined = 0; // calls replaced by the body of their procedure
+
+    [[nodiscard]] std::string ToString() const;
+  };
+private:
+  // What is known about a loop being optimized
+  struct Hoisting {
+    const Nodes* body;
+    std::vector<int> writes; // statements in the loop writing each slot
+    std::vector<bool> defined; // slots defined before the loop is entered
+    std::vector<int> inductions; // the body statement stepping each integer induction variable, or `NOT_INDUCTION`
+    std::vector<Nodes> steps; // statements to run after each statement of the body
+    Nodes preheader; // statements to run before the loop
+  };
+  static constexpr int NOT_INDUCTION = -1;
+  static constexpr int ANY_SCRIPT = -1; // a procedure body, run by whichever scripts call it
+
+  // A repeated expression within a block
+  struct Subexpression {
+    NodePtr expression;
+    std::vector<int> reads; // slots whose writes end its reuse
+    int first; // the statement evaluating it first
+    int last; // the last statement reusing it
+    int uses = 1;
+  };
+  typedef std::unordered_map<const Node*, std::shared_ptr<Ast::Variable>> Temporaries; // the variable holding each repeated expression
+
+  struct Elimination {
+    Hoisting scope; // the variables defined before the statement, for `IsHoistable`
+    std::vector<Subexpression> subexpressions;
+    std::unordered_map<const Node*, int> live; // subexpressions whose reads are unchanged
+    bool safe = true; // nothing the statement has evaluated so far can fail
+  };
+
+  Report report;
+  AbstractSyntaxTree* program = nullptr; // owns the slots of temporaries
+  Ast::Procedure* procedure = nullptr; // whose body is being optimized, its temporaries are locals of its frame
+  std::unordered_map<std::string, NodePtr> interned; // canonical expressions by structure
+  std::vector<int> definitions; // the definitions of each slot in the program
+  std::vector<std::vector<int>> scripts; // the writes of each script and the procedures it calls, by index
+  std::vector<int> concurrent; // the writes of the scripts running beside the body being optimized, which may land between any two of its statements
+
+  [[nodiscard]] static bool IsLiteral(const NodePtr& expression);
+  [[nodiscard]] static const Value& GetLiteral(const NodePtr& expression) { return GetNode<Ast::Literal>(*expression).value; }
+
+  void OptimizeExpression(NodePtr& expression);
+  void OptimizeComponents(Nodes& components);
+  [[nodiscard]] bool Fold(NodePtr& expression);
+
+  // The statements that replace `component` in its body: itself, nothing, or the body of a constant branch
+  [[nodiscard]] const Nodes* Inline(const NodePtr& component);
+  [[nodiscard]] bool IsEmpty(const Node& component);
+
+  // Inlining //
+
+  [[nodiscard]] bool InlineCalls(Nodes& components); // true when a call was inlined
+  [[nodiscard]] bool IsExpandable(const Node& component) const;
+  void Expand(const Ast::Call& call, Nodes& laid); // lay out the statements replacing `call`
+
+  // Scripts //
+
+  void Interleave(int script); // the body of `script` is being optimized next
+  void Interleaved(std::vector<int>& writes) const; // count concurrent writes in `writes`
+
+  // Loops //
+
+  void OptimizeLoops(Nodes& components, std::vector<bool> defined, bool once); // `defined` holds the slots defined before `components`, which run `once` per program
+  [[nodiscard]] Nodes OptimizeLoop(Ast::Loop& loop, const std::vector<bool>& defined); // returns the preheader
+  [[nodiscard]] static bool IsHoistable(const Node& expression, const Hoisting& hoisting);
+  void HoistComponents(Nodes& components, Hoisting& hoisting);
+  void HoistExpression(NodePtr& expression, Hoisting& hoisting);
+  void ReduceComponents(Nodes& components, Hoisting& hoisting);
+  void ReduceExpression(NodePtr& expression, Hoisting& hoisting);
+  [[nodiscard]] std::shared_ptr<Ast::Variable> Hoist(NodePtr expression, Hoisting& hoisting); // store `expression` in a temporary assigned in the preheader
+  [[nodiscard]] std::shared_ptr<Ast::Variable> Temporary(NodePtr expression, const std::string& key, Nodes& statements); // define and assign a new variable
+
+  // Bounds Checks //
+
+  void BoundSubscripts(const Node& initializer, Ast::Loop& repeat, bool once);
+  void BoundComponents(Nodes::iterator begin, Nodes::iterator end, int list, int index);
+  void BoundExpression(NodePtr& expression, int list, int index); // mark subscripts of `list` by `index` as within the list
+
+  // Common Subexpressions //
+
+  void Intern(NodePtr& expression); // replace `expression` and its children with their canonical node
+  void InternComponents(Nodes& components);
+  [[nodiscard]] std::vector<NodePtr*> GetOperands(Node& component) const;
+  [[nodiscard]] static bool Substitute(NodePtr& expression, const Temporaries& temporaries);
+  static void CollectSubexpressions(NodePtr& expression, bool certain, int statement, Elimination& elimination);
+  void EliminateComponents(Nodes& components, std::vector<bool> defined);
+public:
+  Report Optimize(AbstractSyntaxTree& program);
+};
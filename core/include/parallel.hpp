@@ -0,0 +1,9 @@
+#pragma once
+
+#include <ast.hpp>
+#include <variableStore.hpp>
+
+// Run a `parallel` block for the engines, sharing its iterations out across the `ThreadPool`.
+// Each iteration holds its element and the body's definitions itself and reads everything else from `store`, which none of them write, so they never observe each other.
+// The elements are written back to the list in order once every iteration has finished; a failure is the one of the first failing iteration, whichever thread reached it.
+void RunParallel(const Ast::Parallel& parallel, VariableStore& store); // throws what the body does
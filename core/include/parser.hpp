@@ -1,293 +1,302 @@
 #pragma once
 
 #include <string>
+#include <vector>
 #include <type_traits>
+#include <unordered_map>
 
 #include <print.hpp>
 #include <variableStore.hpp>
 #include <stackMachine.hpp>
+#include <scheduler.hpp>
 #include <renderer.hpp>
 #include <blocks.hpp>
+#include <ast.hpp>
 #include <json.hpp>
-#include <random.hpp>
+#include <kernel.hpp>
+#include <parallel.hpp>
 
 
 class Parser final {
+public:
+    // How often memoized expressions were read from their cache
+    struct Memoization {
+        int hits = 0;
+        int misses = 0; // evaluations, the first of each expression included
+
+        [[nodiscard]] std::string ToString() const;
+    };
 private:
     static constexpr int MAX_REPEAT_LENGTH = 2048;
     static constexpr int MIN_ARRAY_SIZE = 0;
-    static constexpr int MAX_ARRAY_SIZE = 2048;
-    static constexpr int MAX_BRANCHES = 2;
-    static constexpr int LVALUE = 0;
-    static constexpr int RVALUE = 1;
+    static constexpr int MAX_ARRAY_SIZE = 65536; // uniform reserves and ranges are only stored once edited
+    static constexpr int UNEVALUATED = -1;
+    static constexpr int MAX_MEMO_MISSES = 64; // consecutive misses before an expression is no longer memoized
+
+    // The last result of a pure expression, current while the variables it reads keep their versions
+    struct Memo {
+        std::vector<int> reads; // slots read by the expression
+        std::vector<unsigned> versions; // of each read when `value` was evaluated
+        Value value;
+        int kind = UNEVALUATED; // the type `value` was extracted as, see `GetMemoKind`
+        int misses = 0; // since the last hit
+    };
 
     Renderer& renderer;
     
-    Json program;
-    StackMachine stackMachine;
+    AbstractSyntaxTree program;
+    StackMachine stackMachine; // of the running script
     VariableStore store;
 
-    std::string currentBlockId;
+    Scheduler scheduler;
+    std::vector<StackMachine> scripts; // the machine of each script while another runs
+
+    const Node* currentBlock = nullptr;
+    long long printed = 0; // values, since the program was loaded
+    long long executed = 0; // instructions, since the program was loaded
+    int listQuota = 0; // elements `append` may grow a list to, 0 for `MAX_ARRAY_SIZE` alone
+    long long outputQuota = 0; // values the program may print, 0 for unlimited
+    std::vector<Value> arguments; // of the call being made, reused between calls
+
+    bool memoize = false;
+    std::unordered_map<const Node*, Memo> memos; // shared expressions share their memo
+    Memoization memoization;
+
+    void Memoize(Nodes& components);
+    void Memoize(NodePtr& expression);
+
+    // The types an expression is memoized as; a shared expression extracted as another type is evaluated again
+    template<typename T>
+    [[nodiscard]] static constexpr int GetMemoKind() {
+        if constexpr (std::is_same_v<T, Value>) return 0;
+        else if constexpr (std::is_same_v<T, int>) return 1;
+        else if constexpr (std::is_same_v<T, double>) return 2;
+        else if constexpr (std::is_same_v<T, bool>) return 3;
+        else return UNEVALUATED;
+    }
 
-    [[nodiscard]] const Variable& ParseVariable(Json& expression) {
-        const std::string key = expression["definitionId"];
-        using namespace std::string_literals;
-        Log("Parsing variable of definition id `"s + key + "`"s);
-        return store.Get(key);
+    template<typename T>
+    [[nodiscard]] T Recall(const Node& expression) {
+        if (expression.type == NodeType::VARIABLE || expression.type == NodeType::LITERAL) return EvaluateValue<T>(expression);
+        const auto found = memos.find(&expression);
+        if (found == memos.end()) return EvaluateValue<T>(expression);
+
+        auto& memo = found->second;
+        bool current = memo.kind == GetMemoKind<T>();
+        for (int i = 0; current && i < (int)memo.reads.size(); ++i) current = store.GetVersion(memo.reads[i]) == memo.versions[i];
+        if (current) {
+            ++memoization.hits;
+            memo.misses = 0;
+            return Cast<T>(memo.value);
+        }
+
+        ++memoization.misses;
+        T result = EvaluateValue<T>(expression);
+        if (++memo.misses == MAX_MEMO_MISSES) { // its reads change too often to be worth checking
+            memos.erase(&expression);
+            return result;
+        }
+
+        memo.value = Value{result};
+        memo.kind = GetMemoKind<T>();
+        for (int i = 0; i < (int)memo.reads.size(); ++i) memo.versions[i] = store.GetVersion(memo.reads[i]);
+        return result;
+    }
+
+    [[nodiscard]] inline const Variable& ParseVariable(const Ast::Variable& expression) const {
+        return store.Get(expression.slot);
     }
 
     template<Block::ArithmeticOperation O>
-    void ParseUnaryArithmetic(Json& expression) {
-        const auto key = expression["definitionId"];
-        const auto& variable = store.Get(key);
+    void ParseUnaryArithmetic(const Ast::Variable& expression) {
+        if (expression.valueType == ValueType::INTEGER) { // proven to be a `number` holding an integer
+            auto& value = store.Edit(expression.slot);
+            value = ApplyUnaryArithmetic<O>(value.As<int>());
+            return;
+        }
+
+        const auto& variable = store.Get(expression.slot);
 
-        const auto primitive = variable.GetPrimitive();
-        if (primitive != "number")
+        if (variable.GetPrimitive() != Primitive::NUMBER)
             throw std::invalid_argument("Invalid TYPE for UNARY ARITHMETIC expression!");
 
-        ApplyUnaryArithmetic<O>(key, variable.Get<int>());
+        const auto& value = variable.Get();
+        if (value.Is<double>()) store.Set(expression.slot, ApplyUnaryArithmetic<O>(value.As<double>()));
+        else store.Set(expression.slot, ApplyUnaryArithmetic<O>(value.Get<int>()));
     }
 
     template<Block::ArithmeticOperation O, Block::Arithmetic T>
-    void ApplyUnaryArithmetic(const std::string key, const T& value) {
-        T result;
-        if constexpr (O == Block::ArithmeticOperation::INC) result = value + 1;
-        else if constexpr (O == Block::ArithmeticOperation::DEC) result = value - 1;
+    [[nodiscard]] static inline T ApplyUnaryArithmetic(const T value) {
+        if constexpr (O == Block::ArithmeticOperation::INC) return value + 1;
+        else if constexpr (O == Block::ArithmeticOperation::DEC) return value - 1;
         else throw std::invalid_argument("Invalid arithmetic operation provided!");
-
-        store.Set(key, result);
     }
 
     template<Block::Arithmetic T = int>
-    [[nodiscard]] T ParseOperation(Json& operation) {
-        const std::string type = operation["type"];
-        auto expression = operation["expression"];
-
-        const T lvalue = ExtractValue<T>(expression.is_array() ? expression[LVALUE] : expression);
-
-        if (type == "sin")          return std::sin(lvalue);
-        if (type == "cos")          return std::cos(lvalue);
-        if (type == "tan")          return std::tan(lvalue);
-        if (type == "asin")         return std::asin(lvalue);
-        if (type == "acos")         return std::acos(lvalue);
-        if (type == "atan")         return std::atan(lvalue);
-
-        if (type == "log")          return std::log(lvalue);
-        if (type == "log10")        return std::log10(lvalue);
-        if (type == "log2")         return std::log2(lvalue);
-
-        if (type == "sqrt")         return std::sqrt(lvalue);
-        if (type == "cbrt")         return std::cbrt(lvalue);
-
-        if (type == "abs")          return std::abs(lvalue);
-        if (type == "round")        return std::round(lvalue);
-        if (type == "ceil")         return std::ceil(lvalue);
-        if (type == "floor")        return std::floor(lvalue);
+    [[nodiscard]] T ParseOperation(const Ast::Operation& operation) {
+        const T lvalue = ExtractValue<T>(*operation.left);
+        if (IsUnaryOperation(operation.type)) return Kernel::Unary<T>(operation.type, lvalue);
 
-        const T rvalue = ExtractValue<T>(expression[RVALUE]);
-
-        if (type == "add")          return lvalue + rvalue;
-        if (type == "subtract")     return lvalue - rvalue;
-        if (type == "multiply")     return lvalue * rvalue;
-        if (type == "divide")       return lvalue / rvalue;
-        if (type == "modulo")       return (int)lvalue % (int)rvalue; // only integers can be modded
-        if (type == "exponent")     return std::pow(lvalue, rvalue);
+        const T rvalue = ExtractValue<T>(*operation.right);
+        return Kernel::Binary<T>(operation.type, lvalue, rvalue);
+    }
 
-        if (type == "min")          return std::min(lvalue, rvalue);
-        if (type == "max")          return std::max(lvalue, rvalue);
+    // Operations whose operand types were not proven dispatch on the values they read
+    [[nodiscard]] Value ParseArithmetic(const Ast::Operation& operation) {
+        Value left, right;
+        const auto& lvalue = ReadValue(*operation.left, left);
+        if (IsUnaryOperation(operation.type)) return Kernel::Arithmetic(operation.type, lvalue, lvalue);
 
-        if (type == "random")       return Random::generate(lvalue, rvalue);
+        return Kernel::Arithmetic(operation.type, lvalue, ReadValue(*operation.right, right));
+    } // throws `std::bad_variant_access`
 
-        throw std::invalid_argument("Invalid operation TYPE provided!");
-    }
+    template<typename T = Value>
+    [[nodiscard]] T ParseSubscript(const Ast::Subscript& subscript) {
+        if (subscript.bounded) // an index loop over a list it does not edit
+            return Cast<T>(ParseVariable(GetNode<Ast::Variable>(*subscript.list)).Get().At(ExtractValue<int>(*subscript.index)));
 
-    template<typename T = Any>
-    [[nodiscard]] T ParseSubscript(Json& subscript) {
-        Log("Parsing `subscript` component");
+        Value temporary;
+        const auto& value = ReadValue(*subscript.list, temporary);
+        if (!value.Is<Value::List>()) throw std::runtime_error("value subscription must be `list`!"); // todo: subscript string literals and variables?
 
-        const auto list = ExtractValue<Json>(subscript["list"]);
-        const auto& elements = list["expression"];
-        if (!elements.is_array()) throw std::runtime_error("value subscription must be `list`!"); // todo: subscript string literals and variables?
-
-        const int size = elements.size();
-        const auto index = (int)ExtractValue<int>(subscript["index"]); 
+        const int size = value.Size();
+        const auto index = ExtractValue<int>(*subscript.index); 
         if (std::abs(index) >= size) throw std::out_of_range("Subscript INDEX is out of range!");
 
-        auto element = index >= 0 ? elements[index] : elements[size + index];
-        return ExtractValue<T>(element);
+        return Cast<T>(value.At(index >= 0 ? index : size + index));
     }
 
-    [[nodiscard]] Json CreateLiteral(Json& expression) {
-        Log("creating literal...");
-        Log(expression.dump());
-        auto value = ExtractValue(expression);
-
-        auto literal = Json::object();
-        literal["id"] = expression["id"]; // keep things simple... use the same id
-        literal["type"] = "literal";
-
-        if (std::holds_alternative<Json>(value)) {
-            auto json = std::get<Json>(value);
-            if (json.is_array()) {
-                literal["expression"] = Json::array();
-                for (auto& element : json)
-                    literal["expression"].push_back(CreateLiteral(element));
-            } else if (json["type"] == "literal")
-                literal["expression"] = json["expression"];
-            else
-                literal["expression"] = json;
-        } else if (std::holds_alternative<int>(value)) {
-            literal["expression"] = std::get<int>(value);
-        } else if (std::holds_alternative<double>(value))
-            literal["expression"] = std::get<double>(value);
-        else if (std::holds_alternative<bool>(value))
-            literal["expression"] = std::get<bool>(value);
-        else if (std::holds_alternative<std::string>(value))
-            literal["expression"] = std::get<std::string>(value);
-        else
-            throw std::invalid_argument("Invalid value TYPE provided!");
-
-        return literal;
+    // Read an expression without copying it: variables and literals are borrowed, anything else is evaluated into `temporary`
+    [[nodiscard]] inline const Value& ReadValue(const Node& expression, Value& temporary) {
+        if (expression.type == NodeType::VARIABLE) return ParseVariable(GetNode<Ast::Variable>(expression)).Get();
+        if (expression.type == NodeType::LITERAL) return GetNode<Ast::Literal>(expression).value;
+        return temporary = ExtractValue(expression);
     }
 
-    template<typename T = Any>
-    [[nodiscard]] T ExtractValue(Json& expression) {
-        const std::string type = expression["type"];
+    // Numeric contexts accept either kind of number, integer contexts ( indices, coordinates... ) truncate doubles
+    template<typename T = Value>
+    [[nodiscard]] static inline T Cast(const Value& value) {
+        if constexpr (std::is_same_v<T, Value>) return value;
+        else if constexpr (std::is_same_v<T, int> || std::is_same_v<T, double>) return value.GetNumber<T>();
+        else return value.Get<T>();
+    } // throws `std::bad_variant_access`
+
+    template<typename T = Value>
+    [[nodiscard]] T ExtractValue(const Node& expression) {
+        if constexpr (GetMemoKind<T>() != UNEVALUATED)
+            if (memoize) [[unlikely]] return Recall<T>(expression);
+        return EvaluateValue<T>(expression);
+    }
 
-        using namespace std::string_literals;
-        Log("extracting value from type: `"s + type + "`"s);
-        
-        if (type == "variable") {
-            const auto& variable = ParseVariable(expression);
-            if constexpr (std::is_same_v<T, Any>) return variable.Get();
-            else return variable.Get<T>();
-            // todo: have some fun with `std::view`...
-        }
-        
-        if (type == "literal") {
-            if constexpr (std::is_same_v<T, Any>) {
-                auto value = expression["expression"];
-                if (value.is_null())            return ""s;
-                if (value.is_number_integer())  return value.get<int>();
-                if (value.is_number_float())    return (int)value.get<double>(); // let's keep things simple... and use integral math
-                if (value.is_boolean())         return value.get<bool>();
-                if (value.is_string())          return value.get<std::string>();
-
-                if (value.is_array())
-                    throw std::invalid_argument("Unexpected array literal outside of `list` expression");
-
-                if (value.is_object() && value["type"] == "list")
-                    return ExtractValue(value);
-
-                Log(value.dump());
-                throw std::invalid_argument("Invalid literal type provided!");
-            } else 
-                return expression["expression"].get<T>();
+    template<typename T = Value>
+    [[nodiscard]] T EvaluateValue(const Node& expression) {
+        switch (expression.type) {
+            case NodeType::VARIABLE: {
+                const auto& value = ParseVariable(GetNode<Ast::Variable>(expression)).Get();
+                if constexpr (std::is_same_v<T, int>)
+                    if (expression.valueType == ValueType::INTEGER) return value.As<int>(); // proven, skip the check
+                return Cast<T>(value);
+            }
+
+            case NodeType::LITERAL:
+                return Cast<T>(GetNode<Ast::Literal>(expression).value);
+
+            case NodeType::LIST:
+                if constexpr (std::is_same_v<T, Value>)
+                    return ParseList(GetNode<Ast::List>(expression));
+                else throw std::invalid_argument("unconstrained typename T is not a Value; Can't process list!");
+
+            case NodeType::RANGE:
+                if constexpr (std::is_same_v<T, Value>)
+                    return ParseRange(GetNode<Ast::Range>(expression));
+                else throw std::invalid_argument("unconstrained typename T is not a Value; Can't process range!");
+
+            case NodeType::SUBSCRIPT:
+                return ParseSubscript<T>(GetNode<Ast::Subscript>(expression));
+
+            case NodeType::SIZE:
+                if constexpr (std::is_same_v<T, Value> || std::is_arithmetic_v<T>)
+                    return ParseSize(GetNode<Ast::Size>(expression));
+                else throw std::invalid_argument("unconstrained typename T is not arithmetic; Can't process size!");
+
+            case NodeType::NONE:
+                throw std::invalid_argument("Expected an expression, but none was provided!");
+
+            default: break;
         }
 
-        if (IsOperation(type)) {
-            if constexpr (std::is_same_v<T, Any> || std::is_arithmetic_v<T>)
-                return ParseOperation<int>(expression);
-            else throw std::invalid_argument("unconstrained typename T is not arithmetic; Can't process operation!");
+        if (IsOperation(expression.type)) {
+            if constexpr (std::is_same_v<T, Value> || std::is_arithmetic_v<T>) {
+                const auto& operation = GetNode<Ast::Operation>(expression);
+                switch (expression.valueType) { // proven operands take the specialized kernels
+                    case ValueType::INTEGER:    return static_cast<T>(ParseOperation<int>(operation));
+                    case ValueType::DOUBLE:     return static_cast<T>(ParseOperation<double>(operation));
+                    default:                    return Cast<T>(ParseArithmetic(operation));
+                }
+            } else throw std::invalid_argument("unconstrained typename T is not arithmetic; Can't process operation!");
         } 
 
-        if (IsCondition(type)) {
-            if constexpr (std::is_same_v<T, Any> || std::is_convertible_v<T, bool>)
-                return ParseCondition(expression);
+        if (IsCondition(expression.type)) {
+            if constexpr (std::is_same_v<T, Value> || std::is_convertible_v<T, bool>)
+                return ParseCondition(GetNode<Ast::Operation>(expression));
             else throw std::invalid_argument("unconstrained typename T is not convertible to bool; Can't process condition!");
         }
 
-        if (type == "list") {
-            if constexpr (std::is_same_v<T, Json> || std::is_same_v<T, Any>)
-                return expression;
-            else throw std::invalid_argument("unconstrained typename T is not convertible to Json; Can't process list!");
-        }
-
-        if (type == "subscript") {
-            if constexpr (std::is_same_v<T, Json> || std::is_same_v<T, Any>)
-                return ParseSubscript<T>(expression);
-            else throw std::invalid_argument("unconstrained typename T is not convertible to Json; Can't process subscript!");
-        }
-
         using namespace std::string_literals;
-        throw std::runtime_error("Expected variable or literal expression: `"s + type + "` provided!"s);
-    }
-
-    [[nodiscard]] constexpr inline bool IsOperation(std::string_view type) const {
-        return type == "add" 
-            || type == "subtract"
-            || type == "multiply"
-            || type == "divide"
-            || type == "modulo"
-            || type == "exponent"
-            || type == "sin"
-            || type == "cos"
-            || type == "tan"
-            || type == "asin"
-            || type == "acos"
-            || type == "atan"
-            || type == "log"
-            || type == "log10"
-            || type == "log2"
-            || type == "sqrt"
-            || type == "cbrt"
-            || type == "abs"
-            || type == "round"
-            || type == "ceil"
-            || type == "floor"
-            || type == "min"
-            || type == "max"
-            || type == "random";
+        throw std::runtime_error("Expected variable or literal expression: `"s + expression.key + "` provided!"s);
     }
 
-    [[nodiscard]] constexpr inline bool IsCondition(std::string_view type) const {
-        return type == "and"
-            || type == "not"
-            || type == "or"
-            || type == "xor"
-            || type == "eq"
-            || type == "ne"
-            || type == "lt"
-            || type == "gt"
-            || type == "le"
-            || type == "ge";
-    }
-
-    [[nodiscard]] Json ReserveArray(Json list, const std::string elementIdSalt);
+    [[nodiscard]] Value ParseList(const Ast::List& list);
+    [[nodiscard]] Value ReserveList(const Ast::List& list);
+    [[nodiscard]] Value ParseRange(const Ast::Range& range);
 
-    void ParseDefinition(Json& definition);
-    void ParseAssignment(Json& assignment);
+    void ParseDefinition(const Ast::Definition& definition);
+    void ParseAssignment(const Ast::Assignment& assignment);
 
-    void ParseAppend(Json& push);
-    void ParseSize(Json& size);
-    void ParseRemove(Json& remove);
+    [[nodiscard]] int ListSlot(const Node& list) const;
+    void ParseAppend(const Ast::Append& append);
+    [[nodiscard]] int ParseSize(const Ast::Size& size);
+    void ParseRemove(const Ast::Remove& remove);
 
-    void ParseRepeat(Json& repeat);
-    void ParseForever(Json& forever);
-    void ParseWhile(Json& loop);
-    void ParseForeach(Json& foreach);
+    void ParseRepeat(const Ast::Loop& repeat);
+    void ParseForever(const Ast::Loop& forever);
+    void ParseWhile(const Ast::Loop& loop);
+    void ParseForeach(const Ast::Loop& foreach);
 
-    void ParseJump(Json& jump);
-    void ParseConditionJump(Json& condition);
+    void ParseJump(const Ast::Jump& jump);
+    void ParseConditionJump(const Ast::Jump& jump);
 
-    void ParseDrawLine(Json& draw);
-    void ParseDrawRect(Json& draw);
-    void ParseDrawPixel(Json& draw);
+    void ParseDrawLine(const Ast::Draw& draw);
+    void ParseDrawRect(const Ast::Draw& draw);
+    void ParseDrawPixel(const Ast::Draw& draw);
 
-    void ParsePrint(Json& print);
-    void PrintExpression(Json& expression);
+    void ParsePrint(const Ast::Print& print);
+    void PrintExpression(const Node& expression);
     void ParseClearOutput();
     void ParseClearScreen();
 
-    void ParseBranch(Json& branch);
-    [[nodiscard]] bool ParseCondition(Json& conditional);
+    void ParseCall(const Ast::Call& call);
+    void ParseReturn(const Ast::Return& ret);
+    void Return(const Node* expression);
 
-    bool ParseComponent(Json& component);
+    void ParseBranch(const Ast::Branch& branch);
+    [[nodiscard]] bool ParseCondition(const Ast::Operation& condition);
+
+    bool ParseComponent(const Node& component);
+    bool Switch(); // run the script the scheduler takes next; false when every script is waiting
 public:
     explicit Parser(Renderer& renderer);
 
-    void ParseComponents(const std::string components);
+    void ParseComponents(AbstractSyntaxTree program);
+    inline void SetMemoize(const bool memoize) { Parser::memoize = memoize; } // takes effect on the next `ParseComponents`
+    [[nodiscard]] inline const Memoization& GetMemoization() const { return memoization; }
     bool Next();
-
-    inline std::string GetCurrentBlockId() const { return currentBlockId; }
-};
+    bool Run(int instructions); // execute up to `instructions`, fewer once every script is waiting; false once the program has finished
+    [[nodiscard]] inline Scheduler& GetScheduler() { return scheduler; }
+    [[nodiscard]] inline long long GetPrinted() const { return printed; }
+    [[nodiscard]] inline long long GetExecuted() const { return executed; }
+    [[nodiscard]] std::pair<size_t, int> Measure() const; // the bytes variables hold, locals of every script included, and the longest list among them
+    inline void SetQuotas(const int list, const long long output) { listQuota = list; outputQuota = output; } // `append` or `print` past them throws `Governor::Exceeded`
+
+    inline std::string GetCurrentBlockId() const { return currentBlock ? currentBlock->key : ""; }
+};
\ No newline at end of file
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+
+#include <bytecode.hpp>
+
+// Fuses frequent instruction sequences of compiled `Bytecode` into superinstructions, saving a dispatch for each instruction they cover.
+// A superinstruction replaces the first instruction of its sequence and skips the rest, so jumps into the sequence still land on the originals.
+class Peephole final {
+public:
+  struct Report {
+    int loops = 0; // counter steps fused with their test
+    int comparisons = 0; // comparisons fused with the loads of their operands
+    int draws = 0; // draws fused with the loads of their operands
+
+    [[nodiscard]] std::string ToString() const;
+  };
+private:
+  Report report;
+
+  [[nodiscard]] bool FuseLoop(Bytecode& bytecode, const int at);
+  [[nodiscard]] bool FuseComparison(Bytecode& bytecode, const int at);
+  [[nodiscard]] bool FuseDraw(Bytecode& bytecode, const int at);
+
+  void Fused(const Bytecode& bytecode, const int at, const char* name) const; // log a fusion
+public:
+  Report Fuse(Bytecode& bytecode);
+};
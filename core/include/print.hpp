@@ -68,7 +68,10 @@ void ClientPrint(T message) {
     }
     else throw std::invalid_argument("Invalid message TYPE for CLIENT_PRINT!");
 #else 
-    //todo: native implementation of client print
-    Log(message);
+    if constexpr (std::is_same_v<T, Json>) {
+        if (message.is_string()) std::cout << message.template get<std::string>() << "\n";
+        else std::cout << message.dump() << "\n";
+    }
+    else std::cout << message << "\n";
 #endif // __EMSCRIPTEN__
 }
\ No newline at end of file
@@ -1,3 +1,5 @@
+#pragma once
+
 #include <random>
 
 template <typename T>
@@ -25,13 +27,19 @@ concept Numeric = std::is_arithmetic_v<T>;
 //   }
 // };
 
-// todo: this is a C style random number generator, but it works fine for now.
+// A linear congruential generator, whose sequence the standard fixes, so a seeded program draws the same numbers on every host.
+// Unseeded it starts from the generator's default seed, as `rand` did before.
 class Random {
 private:
   inline static constexpr bool INCLUSIVE = 1;
+  inline static std::minstd_rand engine{};
 public:
+  static void Seed(const unsigned seed) { engine.seed(seed); }
+
   template<typename T>
   static T generate(const T min, const T max) {
-    return rand() % (max - min + INCLUSIVE) + min;
+    const auto drawn = engine() - std::minstd_rand::min();
+    if constexpr (std::is_floating_point_v<T>) return min + (max - min) * ((T)drawn / (std::minstd_rand::max() - std::minstd_rand::min()));
+    else return (T)((long long)drawn % ((long long)max - min + INCLUSIVE) + min);
   }
 };
@@ -3,6 +3,8 @@
 #include <rec2.hpp>
 #include <window.hpp>
 
+#include <initializer_list>
+
 struct Color {
   static constexpr unsigned int OPAQUE = 255;
   static constexpr unsigned int TRANSPARENT = 0;
@@ -46,6 +48,7 @@ public:
 
   inline void Present() { SDL_RenderPresent(renderer); }
   inline void Clear() { 
+    if (trace) Trace("clear", {});
     ResetColor();
     if (SDL_RenderClear(renderer)) throw SDL2Exception(SDL_GetError());
   }
@@ -69,6 +72,9 @@ public:
     if (!SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, (bool)scaleQuality ? "1" : "0"))
       throw SDL2Exception(SDL_GetError());
   }
+  inline void SetTrace(const bool trace) { Renderer::trace = trace; } // print each draw, to compare engines and transpiled programs
+  inline bool GetTrace() const { return trace; }
+
   inline ScaleQuality GetScaleQuality() const {
     if (const char* hint = SDL_GetHint(SDL_HINT_RENDER_SCALE_QUALITY))
       return (ScaleQuality)std::stoi(hint);
@@ -78,6 +84,9 @@ private:
   Flags flags{};
   Window& window;
   SDL_Renderer* renderer;
+  bool trace = false;
+
+  void Trace(const char* operation, std::initializer_list<int> operands) const;
 
   [[nodiscard]] inline constexpr static unsigned int buildFlags(const Flags flags) {
     unsigned int flagsInt = 0;
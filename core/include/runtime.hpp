@@ -1,17 +1,28 @@
 #pragma once
 #include <renderer.hpp>
 #include <parser.hpp>
+#include <virtualMachine.hpp>
+#include <optimizer.hpp>
+#include <typeInference.hpp>
+#include <transpiler.hpp>
+#include <governor.hpp>
 #include <window.hpp>
 #include <time.hpp>
 #include <chrono>
 
 class Runtime final {
+public:
+  enum class Engine { tree, bytecode }; // `Parser` and `StackMachine`, or the `Compiler` and `VirtualMachine`
 private:
   typedef void* RuntimePtr;
 
   static constexpr double DEFAULT_RESOLUTION = 1024.0;
   static constexpr double DEFAULT_ASPECT_RATIO = 16.0 / 9.0;
   static constexpr std::chrono::milliseconds CLOCK_SPEED{10};
+  static constexpr int INSTRUCTIONS_PER_CLOCK_CHECK = 64; // reading the clock costs more than most instructions
+  static constexpr std::chrono::milliseconds FRAME_TIME{16}; // natively, the least a frame lasts while every script waits; about the browser's 60fps
+  static constexpr int INSTRUCTIONS_PER_FRAME = 65536; // of a deterministic frame, a multiple of `INSTRUCTIONS_PER_CLOCK_CHECK`
+  static constexpr unsigned DETERMINISTIC_SEED = 1; // `random` starts from this seed on each deterministic load
 
   #ifdef __EMSCRIPTEN__
   static constexpr int USE_BROWSER_FPS = 0;         // run as fast as the browser wants to render (usually 60fps)
@@ -23,11 +34,41 @@ private:
   Window window;
   Renderer renderer;
   Parser parser;
+  VirtualMachine machine;
+  Governor governor;
+  Engine engine = Engine::tree;
+  bool optimize = true; // run the `Optimizer` over programs as they are loaded
+  bool memoize = false; // cache pure expressions until a variable they read is written
+  bool tiered = true; // compile hot loops of the bytecode engine, unless deterministic
+  bool deterministic = false; // frames run a fixed number of instructions against a virtual clock
   bool running = false;
 
   Time::Timer runtime;
 
+  void Stop(); // stop the program for the quota its governor tripped
+  [[nodiscard]] bool Govern(); // check the quotas measured once a frame; false once the program has been stopped
+
   static inline void Cycle(RuntimePtr instance) { reinterpret_cast<Runtime*>(instance)->Cycle(); }
+
+  // Execute up to `instructions` on the selected engine; false once the program has finished
+  inline bool Step(const int instructions) {
+    return engine == Engine::bytecode ? machine.Run(instructions) : parser.Run(instructions);
+  }
+  inline std::pair<size_t, int> Measure() const {
+    return engine == Engine::bytecode ? machine.Measure() : parser.Measure();
+  }
+  inline long long GetExecuted() const {
+    return engine == Engine::bytecode ? machine.GetExecuted() : parser.GetExecuted();
+  }
+  inline long long GetPrinted() const {
+    return engine == Engine::bytecode ? machine.GetPrinted() : parser.GetPrinted();
+  }
+  inline Scheduler& GetScheduler() {
+    return engine == Engine::bytecode ? machine.GetScheduler() : parser.GetScheduler();
+  }
+  inline std::string GetCurrentBlockId() const {
+    return engine == Engine::bytecode ? machine.GetCurrentBlockId() : parser.GetCurrentBlockId();
+  }
 public:
   Runtime();
   ~Runtime();
@@ -37,6 +78,16 @@ public:
   void Terminate();
   void Load(std::string ast);
 
+  // Hold programs to `quotas`, see `Governor`; takes effect on the next `Run`
+  inline void SetQuotas(const Governor::Quotas& quotas) { governor.SetQuotas(quotas); }
+  inline const Governor::Quotas& GetQuotas() const { return governor.GetQuotas(); }
+
+  // Stop the running program before its next batch of instructions, or the loaded one before it runs; safe to call from any thread
+  inline void Cancel() { governor.Cancel(); }
+
+  // Why the last program was stopped by its governor, `NONE` when it finished, failed, or was terminated
+  inline Governor::Reason GetStopReason() const { return governor.GetReason(); }
+
   inline void SetCanvasResolution(const Vec2 size) { 
     renderer.SetSize(size);
     renderer.Clear(); // changing the resolution clears the screen to that awful #000
@@ -52,4 +103,25 @@ public:
   inline Renderer::ScaleQuality GetScaleQuality() const { return renderer.GetScaleQuality(); }
 
   inline bool IsRunning() const { return running; }
+
+  inline void SetEngine(const Engine engine) { Runtime::engine = engine; } // takes effect on the next `Load`
+  inline Engine GetEngine() const { return engine; }
+  [[nodiscard]] static Engine ParseEngine(const std::string& name); // throws `std::invalid_argument`
+
+  inline void SetOptimize(const bool optimize) { Runtime::optimize = optimize; } // takes effect on the next `Load`
+  inline bool GetOptimize() const { return optimize; }
+
+  inline void SetMemoize(const bool memoize) { Runtime::memoize = memoize; } // takes effect on the next `Load`, the tree engine memoizes
+  inline bool GetMemoize() const { return memoize; }
+
+  inline void SetTrace(const bool trace) { renderer.SetTrace(trace); } // print each draw, see `Renderer::SetTrace`
+  inline void SetTiered(const bool tiered) { Runtime::tiered = tiered; } // takes effect on the next `Load`, compile hot loops of the bytecode engine to machine code
+
+  // Run `INSTRUCTIONS_PER_FRAME` each frame instead of a slice of wall time, so frame N draws the same on any host.
+  // Waits follow a virtual clock advancing `FRAME_TIME` each frame, `random` is seeded, and the bytecode engine only interprets, as compiled loops count instructions approximately.
+  inline void SetDeterministic(const bool deterministic) { Runtime::deterministic = deterministic; } // takes effect on the next `Load`
+  inline bool GetDeterministic() const { return deterministic; }
+
+  // Translate a program into C++ to be compiled against `transpiled.hpp`; throws as `Load` would
+  [[nodiscard]] std::string Transpile(const std::string& ast) const;
 };
\ No newline at end of file
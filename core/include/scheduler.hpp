@@ -0,0 +1,145 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+#include <time.hpp>
+
+// Shares one engine between the scripts of a program, the program's own components being the first.
+// Scripts take turns round robin, each running for a quantum of instructions weighted by its priority until it spends it, yields, waits, or finishes.
+// A waiting script is passed over until its deadline or the next frame; once every script is waiting the scheduler is idle, and the engine runs nothing until one wakes.
+// Deadlines are read from the steady clock, or from a virtual clock that only advances with frames so that runs are reproducible.
+// The engine keeps the state of each script and swaps in the one `Next` names.
+class Scheduler final {
+public:
+  static constexpr int QUANTUM = 64; // instructions a script of priority 1 runs before the next takes its turn
+  typedef Time::steady_clock::time_point Deadline;
+private:
+  static constexpr Deadline AWAKE = Deadline::min();
+
+  struct Task {
+    int priority;
+    bool finished = false;
+    bool frame = false; // waiting for the next frame
+    Deadline wake = AWAKE; // waiting until
+  };
+
+  std::vector<Task> tasks;
+  int current = 0;
+  int remaining = 0; // of the quantum of the current script
+  int unfinished = 0;
+  int waiting = 0; // scripts waiting for a deadline or frame, the clock is only read while there are any
+  bool idle = false;
+  bool simulated = false; // deadlines follow `clock` rather than the steady clock
+  Deadline clock{}; // the virtual clock
+
+  [[nodiscard]] inline Deadline Now() const { return simulated ? clock : Time::Now(); }
+  [[nodiscard]] static inline bool Ready(const Task& task, const Deadline now) { return !task.finished && !task.frame && task.wake <= now; }
+public:
+  // Start a script for each priority, the first running
+  inline void Reset(const std::vector<int>& priorities) {
+    tasks.clear();
+    for (const int priority : priorities) tasks.push_back({ priority });
+    current = 0;
+    remaining = tasks.empty() ? 0 : QUANTUM * tasks.front().priority;
+    unfinished = tasks.size();
+    waiting = 0;
+    idle = false;
+    clock = {};
+  }
+
+  // Read deadlines from a virtual clock advanced by each `Frame`, or from the steady clock; set before the program starts
+  inline void SetSimulated(const bool simulated) { Scheduler::simulated = simulated; }
+
+  [[nodiscard]] inline int Current() const { return current; }
+  [[nodiscard]] inline int Remaining() const { return remaining; }
+  [[nodiscard]] inline int Size() const { return tasks.size(); }
+  [[nodiscard]] inline bool Idle() const { return idle; } // every unfinished script is waiting
+
+  // Spend `instructions` of the current quantum; false once it is spent
+  inline bool Spend(const int instructions = 1) { return (remaining -= instructions) > 0; }
+
+  // End the current quantum early, the `yield` block
+  inline void Yield() { remaining = 0; }
+
+  // The deadline of a `wait` for `milliseconds` from now
+  [[nodiscard]] inline Deadline After(const int milliseconds) const {
+    if (milliseconds < 0) throw std::range_error("Wait DURATION is less than 0!");
+    return Now() + Time::milliseconds{milliseconds};
+  } // throws `std::range_error`
+
+  // Suspend the current script until `deadline`, the `wait` block
+  inline void Sleep(const Deadline deadline) {
+    tasks[current].wake = deadline;
+    ++waiting;
+    remaining = 0;
+  }
+
+  // Suspend the current script until the next frame, the `wait_frame` block
+  inline void WaitFrame() {
+    tasks[current].frame = true;
+    ++waiting;
+    remaining = 0;
+  }
+
+  // Start a frame `length` after the last, waking the scripts waiting for it; the engine takes them up on its next `Run`
+  inline void Frame(const Time::milliseconds length) {
+    if (simulated) clock += length;
+    for (auto& task : tasks) {
+      if (!task.frame) continue;
+      task.frame = false;
+      --waiting;
+    }
+  }
+
+  // The earliest deadline a script is waiting for, `Deadline::max` when they only wait for frames
+  [[nodiscard]] inline Deadline Wakes() const {
+    auto wakes = Deadline::max();
+    for (const auto& task : tasks)
+      if (!task.finished && !task.frame && task.wake != AWAKE) wakes = std::min(wakes, task.wake);
+    return wakes;
+  }
+
+  // The current script has run out of components; false once every script has
+  inline bool Finish() {
+    if (!tasks.empty() && !tasks[current].finished) {
+      tasks[current].finished = true;
+      --unfinished;
+    }
+    return unfinished > 0;
+  }
+
+  // Finish every script, the `exit` block
+  inline void Stop() {
+    for (auto& task : tasks) task.finished = true;
+    unfinished = 0;
+  }
+
+  // Start the quantum of the next ready script after the current one, returning it; the current script runs again when it is the only one ready.
+  // When none is ready the current script is kept without a quantum, and the scheduler is idle.
+  inline int Next() {
+    const int count = tasks.size();
+    const auto now = waiting ? Now() : AWAKE;
+    idle = true;
+    for (int i = 1; i <= count; ++i) {
+      const int next = (current + i) % count;
+      if (!Ready(tasks[next], now)) continue;
+
+      current = next;
+      idle = false;
+      break;
+    }
+    if (idle) {
+      remaining = 0;
+      return current;
+    }
+
+    if (auto& task = tasks[current]; task.wake != AWAKE) {
+      task.wake = AWAKE;
+      --waiting;
+    }
+    remaining = QUANTUM * tasks[current].priority;
+    return current;
+  }
+};
@@ -1,28 +1,39 @@
 #pragma once
-#include <json.hpp>
+#include <ast.hpp>
 
+// A view over a body of the loaded program; the nodes are owned by the `AbstractSyntaxTree` and never copied
 class Stack final {
 private:
     int componentPointer;
-    Json components;
-    inline bool Check() const { return components.is_array(); }
+    const Nodes* components;
+    const Node* loop; // the loop this stack is the body of, `nullptr` for a plain block
 public:
+    int counter; // completed iterations of `loop`
+    int bound; // iterations of a `repeat` or `foreach` loop
+    Value iterable; // the list a `foreach` loop reads each element from, held so its body can not change it
+
     Stack();
-    explicit Stack(Json& components);
+    explicit Stack(const Nodes& components, const Node* loop = nullptr, const int bound = 0);
 
     // Move the instruction pointer
     void Jump(const int instructions);
 
     // Get a pointer to the next component in the stack
-    [[nodiscard]] inline Json* Next() {
+    [[nodiscard]] inline const Node* Next() {
         return componentPointer < Size() 
-            ? &(components[componentPointer++])
+            ? (*components)[componentPointer++].get()
             : nullptr;
     }
 
-    // Push a new component onto the stack
-    inline void Push(Json& component) { components.push_back(component); }
+    // Start the next iteration of the loop
+    inline void Restart() { 
+        componentPointer = 0;
+        ++counter;
+    }
+
+    [[nodiscard]] inline const Node* GetLoop() const { return loop; }
+    [[nodiscard]] inline bool Exhausted() const { return componentPointer >= (int)Size(); }
 
     // Get the number of components in the stack
-    [[nodiscard]] inline size_t Size() const { return components.size(); }
-};
\ No newline at end of file
+    [[nodiscard]] inline size_t Size() const { return components->size(); }
+};
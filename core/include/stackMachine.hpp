@@ -1,6 +1,6 @@
 #pragma once
 
-#include <stack>
+#include <vector>
 
 #include <stack.hpp>
 #include <print.hpp>
@@ -13,21 +13,59 @@ public:
   [[nodiscard]] const char* what() const noexcept override { return s; }
 };
 
+// A procedure call in progress
+struct Frame {
+  const Ast::Procedure* procedure;
+  const Ast::Variable* result; // assigned the returned value in the caller's frame, `nullptr` when it is discarded
+  bool required; // returning without a value fails
+  int depth; // stacks beneath the body of the procedure
+};
+
+// Stacks are taken from a pool that grows to the deepest nesting reached; pushing and popping only allocate when it grows.
+// Each script runs in its own machine, so a machine starts small.
 class StackMachine final {
 private:
   static constexpr int MAX_STACK_SIZE = 1024;
-  std::stack<Stack> stacks; // https://en.cppreference.com/w/cpp/container/stack
-  inline void Pop() { stacks.pop(); }
+  static constexpr int INITIAL_STACK_SIZE = 16;
+  std::vector<Stack> stacks; // the pool, `stacks[0..depth)` are in use
+  int depth = 0;
+  std::vector<Frame> frames; // innermost last
+  Locals locals;
   inline void OverflowInvariant() const { 
     if (Size() + 1 > MAX_STACK_SIZE)
       throw stack_overflow("component tree has exceeded MAX_STACK_SIZE");
   }
+  void Grow(); // make room for another stack
 public:
-  [[nodiscard]] Json* Next();
-  void Push(Json& components);
+  StackMachine();
+
+  [[nodiscard]] const Node* Next();
+  void Push(const Nodes& components, const Node* loop = nullptr, const int bound = 0);
   void Push();
-  inline void Empty() { while (!stacks.empty()) Pop(); }
-  inline void PushBlock(Json& block) { stacks.top().Push(block); } // push a new block onto the top stack 
-  inline void Jump(int instructions) { stacks.top().Jump(instructions); } // Jump `instructions` in the top stack
-  [[nodiscard]] inline int Size() const { return stacks.size(); } // Get the number of stacks in the stack machine
+  inline void Pop() { --depth; }
+  inline void Empty() {
+    depth = 0;
+    frames.clear();
+    locals.Empty();
+  }
+  [[nodiscard]] inline Stack& Top() { return stacks[depth - 1]; }
+
+  // Has the top stack finished an iteration of `loop`
+  [[nodiscard]] inline bool Iterating(const Node& loop) const { 
+    return depth && stacks[depth - 1].GetLoop() == &loop && stacks[depth - 1].Exhausted();
+  }
+
+  // Push the body of `procedure` in a frame of undefined locals, returning the locals to bind its parameters in
+  [[nodiscard]] std::optional<Variable>* Call(const Ast::Procedure& procedure, const Ast::Variable* result, const bool required);
+
+  // Pop the innermost call and its locals, returning the locals of its caller
+  [[nodiscard]] std::optional<Variable>* Return();
+
+  [[nodiscard]] inline bool InProcedure() const { return !frames.empty(); }
+  [[nodiscard]] inline const Frame& GetFrame() const { return frames.back(); }
+  [[nodiscard]] inline std::optional<Variable>* GetLocals() { return locals.Top(); } // of the innermost call, `nullptr` outside of one
+  [[nodiscard]] inline const Locals& GetFrames() const { return locals; } // the locals of every call in progress
+
+  inline void Jump(int instructions) { Top().Jump(instructions); } // Jump `instructions` in the top stack
+  [[nodiscard]] inline int Size() const { return depth; } // Get the number of stacks in the stack machine
 };
\ No newline at end of file
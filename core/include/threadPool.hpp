@@ -0,0 +1,56 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <utility>
+#include <functional>
+#include <condition_variable>
+
+// Shares ranges of indices out to worker threads, started on first use; the thread waiting on the work takes part as well.
+// Each thread owns a queue of ranges: it takes from the front of its own, then steals from the back of another's once it runs dry, so uneven ranges even out.
+// The web build has no threads, so everything runs on the calling thread there.
+class ThreadPool final {
+public:
+  typedef std::function<void(int, int)> Body; // run the indices from the first up to, but excluding, the second; must not throw
+private:
+  typedef std::pair<int, int> Range;
+
+  struct Queue {
+    std::mutex mutex;
+    std::deque<Range> ranges;
+  };
+
+  std::vector<std::thread> workers;
+  std::vector<std::unique_ptr<Queue>> queues; // of each worker, the calling thread's last
+  const Body* body = nullptr; // of the work in progress
+  std::atomic<int> pending = 0; // ranges not yet finished
+
+  std::mutex mutex; // guards `generation` and `stopping`
+  std::condition_variable wake; // workers wait here for work
+  std::condition_variable done; // the calling thread waits here for the last range
+  unsigned generation = 0; // bumped by each `For`, so each worker wakes once for it
+  bool stopping = false;
+
+  ThreadPool();
+
+  void Work(int self); // a worker's life
+  void Drain(int self); // run ranges until every queue is empty
+  [[nodiscard]] bool Take(int self, Range& range);
+public:
+  ~ThreadPool();
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  // The pool shared by every engine
+  [[nodiscard]] static ThreadPool& Get();
+
+  // Threads taking part in the work, the calling thread included
+  [[nodiscard]] inline int Size() const { return queues.size(); }
+
+  // Run `body` over the indices from 0 up to `count` in ranges of `grain`, returning once every range has finished; calls may not nest
+  void For(int count, int grain, const Body& body);
+};
@@ -0,0 +1,255 @@
+#pragma once
+
+#include <string>
+#include <thread>
+#include <optional>
+#include <functional>
+#include <stdexcept>
+#include <initializer_list>
+
+#include <value.hpp>
+#include <variableStore.hpp>
+#include <kernel.hpp>
+#include <renderer.hpp>
+#include <print.hpp>
+#include <time.hpp>
+
+// Support for programs translated to C++ by the `Transpiler`.
+// Generated code keeps the interpreter's runtime checks and their messages, so a transpiled program fails exactly where the interpreter would.
+namespace Transpiled {
+  constexpr int MAX_REPEAT_LENGTH = 2048;
+  constexpr int MIN_ARRAY_SIZE = 0;
+  constexpr int MAX_ARRAY_SIZE = 65536; // uniform reserves and ranges are only stored once edited
+
+  // A variable slot; proven types are stored natively, anything else as a `Value`
+  template<typename T>
+  class Variable final {
+  private:
+    const char* key; // the `definitionId`, for diagnostics
+    const char* name = "";
+    Primitive primitive = Primitive::STRING;
+    T value{};
+    bool defined = false;
+
+    inline void DefinedInvariant() const {
+      if (!defined) throw std::out_of_range("Variable `" + std::string{key} + "` is not defined!");
+    }
+  public:
+    explicit Variable(const char* key) : key{key} { }
+
+    // definitions do not overwrite existing values
+    inline void Define(T value, const char* name, const Primitive primitive) {
+      if (defined) return;
+      Variable::value = std::move(value);
+      Variable::name = name;
+      Variable::primitive = primitive;
+      defined = true;
+    }
+
+    [[nodiscard]] inline const T& Get() const { DefinedInvariant(); return value; } // throws `std::out_of_range`
+    [[nodiscard]] inline T& Edit() { DefinedInvariant(); return value; } // throws `std::out_of_range`
+    inline void Set(T value) { Edit() = std::move(value); }
+
+    [[nodiscard]] inline Primitive GetPrimitive() const { return primitive; }
+    [[nodiscard]] inline const char* GetName() const { return name; }
+  };
+
+  // Variables //
+
+  [[nodiscard]] inline Value Default(const Primitive primitive) {
+    switch (primitive) {
+      case Primitive::NUMBER:   return 0;
+      case Primitive::BOOLEAN:  return false;
+      case Primitive::LIST:     return Value{Value::List{}};
+      default:                  return std::string{};
+    }
+  }
+
+  // `increment` and `decrement`
+  template<typename T>
+  inline void Step(Variable<T>& variable, const int amount) {
+    auto& value = variable.Edit();
+    if (variable.GetPrimitive() != Primitive::NUMBER) throw std::invalid_argument("Invalid TYPE for UNARY ARITHMETIC expression!");
+
+    if constexpr (std::is_same_v<T, Value>) {
+      if (value.template Is<double>()) value = value.template As<double>() + amount;
+      else value = value.template Get<int>() + amount;
+    }
+    else if constexpr (std::is_same_v<T, int> || std::is_same_v<T, double>) value += amount;
+  } // throws `std::out_of_range`, `std::invalid_argument`, and `std::bad_variant_access`
+
+  // Lists //
+
+  template<typename T>
+  [[nodiscard]] inline Value::List& EditList(Variable<T>& variable) {
+    auto& value = variable.Edit();
+    if constexpr (std::is_same_v<T, Value>)
+      if (variable.GetPrimitive() == Primitive::LIST && value.template Is<Value::List>()) return value.EditList();
+    throw std::invalid_argument("Variable `" + std::string{variable.GetName()} + "` must be of `list` primitive!");
+  } // throws `std::out_of_range` and `std::invalid_argument`
+
+  template<typename T>
+  inline void Append(Variable<T>& variable, Value item) {
+    auto& list = EditList(variable);
+    if ((int)list.size() >= MAX_ARRAY_SIZE) throw std::range_error("Append would exceed MAX_LIST_LENGTH!");
+    list.push_back(std::move(item));
+  }
+
+  template<typename T>
+  inline void Remove(Variable<T>& variable, const int index) {
+    auto& list = EditList(variable);
+    const int size = list.size();
+    if (std::abs(index) >= size) throw std::out_of_range("Remove INDEX is out of range!");
+
+    list.erase(list.begin() + (index >= 0 ? index : size + index));
+  }
+
+  [[nodiscard]] inline Value List(std::initializer_list<Value> elements) { return Value{Value::List{elements}}; }
+
+  // `fill` is evaluated for each element
+  template<typename F>
+  [[nodiscard]] inline Value Reserve(const int reserve, F&& fill) {
+    if (reserve < MIN_ARRAY_SIZE) throw std::range_error("List reserve is less than 0!");
+    if (reserve > MAX_ARRAY_SIZE) throw std::range_error("List reserve is greater than MAX_LIST_LENGTH!");
+
+    Value::List list;
+    list.reserve(reserve);
+    for (int i = 0; i < reserve; ++i) list.push_back(fill());
+    return Value{std::move(list)};
+  }
+
+  // `fill` draws no random numbers, so it is evaluated once for a list that is not empty
+  template<typename F>
+  [[nodiscard]] inline Value Fill(const int reserve, F&& fill) {
+    if (reserve < MIN_ARRAY_SIZE) throw std::range_error("List reserve is less than 0!");
+    if (reserve > MAX_ARRAY_SIZE) throw std::range_error("List reserve is greater than MAX_LIST_LENGTH!");
+    return reserve ? Value::Fill(fill(), reserve) : Value{Value::List{}};
+  }
+
+  [[nodiscard]] inline Value Range(const int start, const int end) {
+    const long long size = (long long)end - start; // empty when `end` is not after `start`
+    if (size > MAX_ARRAY_SIZE) throw std::range_error("Range is longer than MAX_LIST_LENGTH!");
+    return Value::Range(start, size > 0 ? (int)size : 0);
+  }
+
+  // `index` is evaluated once the list is known to be one
+  template<typename F>
+  [[nodiscard]] inline Value Subscript(const Value& value, F&& index) {
+    if (!value.Is<Value::List>()) throw std::runtime_error("value subscription must be `list`!");
+    const int size = value.Size();
+    const int at = index();
+    if (std::abs(at) >= size) throw std::out_of_range("Subscript INDEX is out of range!");
+
+    return value.At(at >= 0 ? at : size + at);
+  }
+
+  // `foreach` checks its list once on entry, then reads each element by its counter
+  [[nodiscard]] inline Value Iterate(Value value) {
+    if (!value.Is<Value::List>()) throw std::invalid_argument("Foreach LIST must be a `list`!");
+    return value;
+  }
+
+  // `parallel` checks its list once on entry, then runs each element's iteration in order
+  [[nodiscard]] inline Value Parallel(Value value) {
+    if (!value.Is<Value::List>()) throw std::invalid_argument("Parallel LIST must be a `list`!");
+    return value;
+  }
+
+  // the body of a `parallel` block only reads numbers and booleans
+  [[nodiscard]] inline Value Scalar(Value value, const char* key) {
+    if (!value.IsNumber() && !value.Is<bool>()) throw std::runtime_error("Parallel `" + std::string{key} + "` can only read numbers and booleans!");
+    return value;
+  }
+
+  [[nodiscard]] inline int Size(const Value& value) {
+    if (!value.Is<Value::List>()) throw std::invalid_argument("Size operand must be a `list`!");
+    return value.Size();
+  }
+
+  // Expressions //
+
+  [[nodiscard]] inline Value Arithmetic(const NodeType type, const Value& value) { return Kernel::Arithmetic(type, value, value); }
+
+  [[nodiscard]] inline Value Missing() { throw std::invalid_argument("Expected an expression, but none was provided!"); }
+
+  // Statements //
+
+  [[nodiscard]] inline int Repeat(const int times) {
+    if (times < 0) throw std::range_error("Repeat TIMES is less than 0!");
+    if (times > MAX_REPEAT_LENGTH) throw std::range_error("Repeat TIMES is greater than MAX_REPEAT_LENGTH!");
+    return times;
+  }
+
+  // Host //
+
+  // What a transpiled program runs against: the renderer, and the block being executed for error messages
+  class Context final {
+  private:
+    static constexpr std::chrono::milliseconds CLOCK_SPEED{10}; // as the `Runtime`
+    static constexpr int ITERATIONS_PER_CLOCK_CHECK = 64;
+    static constexpr std::chrono::milliseconds FRAME_TIME{16}; // as the `Runtime` while every script waits
+
+    Time::steady_clock::time_point frame = Time::Now();
+    int iterations = 0;
+  public:
+    Renderer& renderer;
+    const char* block = "";
+    int depth = 0; // of procedure calls in progress
+
+    explicit Context(Renderer& renderer) : renderer{renderer} { }
+
+    // Called on each loop iteration, presents the canvas as often as the interpreter does
+    inline void Yield() {
+      if (++iterations < ITERATIONS_PER_CLOCK_CHECK) return;
+      iterations = 0;
+      if (!Time::Elapsed(frame, CLOCK_SPEED)) return;
+
+      renderer.Present();
+      frame = Time::Now();
+    }
+
+    // `wait`, presents the canvas and sleeps, as the program runs alone
+    inline void Wait(const int milliseconds) {
+      if (milliseconds < 0) throw std::range_error("Wait DURATION is less than 0!");
+      renderer.Present();
+      std::this_thread::sleep_for(std::chrono::milliseconds{milliseconds});
+      frame = Time::Now();
+    }
+
+    // `wait_frame`, presents the canvas and sleeps out the rest of the frame
+    inline void WaitFrame() {
+      renderer.Present();
+      std::this_thread::sleep_until(frame + FRAME_TIME);
+      frame = Time::Now();
+    }
+  };
+
+  // A procedure call in progress, counted against `MAX_CALL_DEPTH` as the interpreter's frames are
+  class Call final {
+  private:
+    Context& context;
+  public:
+    explicit Call(Context& context) : context{context} {
+      if (context.depth >= Locals::MAX_CALL_DEPTH) throw std::overflow_error("Procedure calls have exceeded MAX_CALL_DEPTH!");
+      ++context.depth;
+    }
+    ~Call() { --context.depth; }
+  };
+
+  // A call replacing the frame of its caller, whose own frame no longer counts
+  class Tail final {
+  private:
+    Context& context;
+  public:
+    explicit Tail(Context& context) : context{context} { --context.depth; }
+    ~Tail() { ++context.depth; }
+  };
+
+  // `exit` within a procedure unwinds its calls
+  struct Exit { };
+
+  typedef void (*Program)(Context& context);
+
+  // Run a transpiled program natively; `--trace` prints each draw to compare it with the interpreter
+  int Main(int argc, char* argv[], Program program);
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+
+#include <ast.hpp>
+
+// Translates a lowered program into a C++ translation unit that runs against `transpiled.hpp`.
+// Proven integers, doubles, and booleans become native values; anything else stays a `Value` and keeps the interpreter's runtime checks.
+class Transpiler final {
+private:
+  enum class Type { INTEGER, DOUBLE, BOOLEAN, VALUE };
+
+  struct Expression {
+    std::string code;
+    Type type;
+    bool computed; // produced by an operation; numbers and booleans read from variables and literals do not convert into each other
+  };
+
+  std::vector<Type> slots; // how each variable slot is stored
+  std::vector<std::string> strings; // string literals, hoisted to constants
+  std::string code; // the program body
+  const Ast::Procedure* procedure = nullptr; // whose body is being transpiled
+  const Ast::Parallel* parallel = nullptr; // whose body is being transpiled, which only reads numbers and booleans
+  const std::vector<std::string>* keys = nullptr; // of each slot, for diagnostics
+  bool listed = false; // the expression being transpiled is the list operand of a subscript or size, which is read whole
+  int indent = 0;
+  int labels = 0; // names loop counters and jump targets uniquely
+
+  [[nodiscard]] static Type GetType(const ValueType type);
+  [[nodiscard]] static const char* GetTypeName(const Type type);
+  [[nodiscard]] static std::string Quote(const std::string& text); // a C++ string literal
+  [[nodiscard]] static bool IsSimple(const Node& expression); // evaluating it can not fail or have effects
+
+  void Line(const std::string& line);
+  void Open(const std::string& line); // a line ending a `{`
+  void Close(const std::string& line = "}");
+
+  [[nodiscard]] std::string Convert(const Expression& expression, const Type type) const;
+  [[nodiscard]] std::string Transpile(const Node& expression, const Type type) { return Convert(TranspileExpression(expression), type); }
+
+  [[nodiscard]] Expression TranspileExpression(const Node& expression);
+  [[nodiscard]] Expression TranspileLiteral(const Value& value);
+  [[nodiscard]] Expression TranspileList(const Ast::List& list);
+  [[nodiscard]] Expression TranspileOperation(const Ast::Operation& operation);
+  [[nodiscard]] Expression TranspileCondition(const Ast::Operation& condition);
+  [[nodiscard]] static std::string Sequence(
+    const Node& left, const Node& right, const Type type, const std::string& lvalue, const std::string& rvalue,
+    const std::function<std::string(const std::string&, const std::string&)>& combine
+  ); // evaluates the left operand first, as the interpreter does
+
+  void TranspileComponents(const Nodes& components);
+  void TranspileComponent(const Node& component);
+  void TranspileJump(const Ast::Jump& jump, const std::string& label, const bool backward);
+  void TranspileDraw(const Ast::Draw& draw);
+  void TranspileParallel(const Ast::Parallel& parallel);
+  void TranspileProcedure(const Ast::Procedure& procedure, const std::vector<std::string>& keys);
+  void TranspileCall(const Ast::Call& call);
+  void TranspileReturn(const Ast::Return& ret);
+  [[nodiscard]] bool ListVariable(const Node& list); // emits the failure when `list` is not a variable
+public:
+  [[nodiscard]] std::string Transpile(const AbstractSyntaxTree& program); // throws `std::invalid_argument` for programs with scripts
+};
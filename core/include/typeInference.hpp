@@ -0,0 +1,25 @@
+#pragma once
+
+#include <vector>
+
+#include <ast.hpp>
+
+// Proves the type each expression produces from its literals and every value written to each variable, annotating `Node::valueType`.
+// A variable's type joins all of its writes, so a proof holds wherever the variable is read and the engines may skip runtime type checks.
+class TypeInference final {
+private:
+  std::vector<ValueType> slots; // the join of every value written to each slot
+  std::vector<ValueType> returns; // the join of every value returned by each procedure
+  const Ast::Procedure* procedure = nullptr; // whose body is being inferred
+  bool changed = false;
+
+  [[nodiscard]] static ValueType Join(const ValueType a, const ValueType b);
+  [[nodiscard]] static ValueType GetDefault(const Primitive primitive);
+
+  void Write(const int slot, const ValueType type);
+  void Return(const int procedure, const ValueType type);
+  ValueType InferExpression(Node& expression);
+  void InferComponents(Nodes& components);
+public:
+  void Infer(AbstractSyntaxTree& program);
+};
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <variant>
+#include <cstdint>
+#include <type_traits>
+
+// A 16 byte tagged value.
+// Numbers and booleans are stored inline; strings and lists live out of line in reference counted heap objects, so copying a value never deep copies.
+// Lists are copy-on-write: assignment, subscripts, and printing share storage, and `EditList` copies only when the storage is shared.
+// Reference counts are not atomic, so threads only read the values they share in place, without copying them.
+class Value final {
+public:
+  // ordered as the alternatives of the former `std::variant`, values of different types compare by this order (numbers compare by value)
+  enum class Type : uint8_t { STRING, INTEGER, DOUBLE, BOOLEAN, LIST };
+  typedef std::vector<Value> List;
+
+private:
+  struct Object { int references = 1; };
+  struct String final : Object { std::string value; explicit String(std::string value) : value{std::move(value)} { } };
+  // Ranges and fills are described by their size until they are read whole or edited
+  struct Array final : Object {
+    enum class Kind : uint8_t { ELEMENTS, RANGE, FILL };
+    List value; // the elements, or the single element of a `FILL`
+    Kind kind = Kind::ELEMENTS;
+    int size = 0; // of a `RANGE` or `FILL`
+    int start = 0; // the first element of a `RANGE`
+    explicit Array(List value) : value{std::move(value)} { }
+  };
+
+  Type type;
+  union {
+    uint64_t bits; // the whole payload, for copies
+    int integer;
+    double real;
+    bool boolean;
+    String* string; // `nullptr` is the empty string
+    Array* list;
+  };
+
+  inline Object* GetObject() const {
+    if (type == Type::STRING) return string;
+    if (type == Type::LIST) return list;
+    return nullptr;
+  }
+
+  inline bool IsObject() const { return type == Type::STRING || type == Type::LIST; }
+  inline void Retain() const { if (auto* object = GetObject()) ++object->references; }
+  inline void Release() { if (IsObject()) Destroy(); }
+  void Destroy(); // drop a reference to the heap object, freeing it with the last
+  void Materialize() const; // store the elements of a lazy list
+
+  [[noreturn]] static void BadAccess() { throw std::bad_variant_access(); }
+public:
+  Value() : type{Type::STRING}, string{nullptr} { }
+  Value(const int value) : type{Type::INTEGER}, integer{value} { }
+  Value(const double value) : type{Type::DOUBLE}, real{value} { }
+  Value(const bool value) : type{Type::BOOLEAN}, boolean{value} { }
+  Value(std::string value) : type{Type::STRING}, string{value.empty() ? nullptr : new String{std::move(value)}} { }
+  Value(const char* value) : Value{std::string{value}} { }
+  explicit Value(List value) : type{Type::LIST}, list{new Array{std::move(value)}} { }
+
+  Value(const Value& other) : type{other.type}, bits{other.bits} { Retain(); }
+  Value(Value&& other) noexcept : type{other.type}, bits{other.bits} { other.type = Type::INTEGER; }
+  inline Value& operator=(const Value& other) {
+    other.Retain(); // before releasing, `other` may be owned by our list
+    Release();
+    type = other.type;
+    bits = other.bits;
+    return *this;
+  }
+  inline Value& operator=(Value&& other) noexcept {
+    if (this == &other) return *this;
+    const auto otherType = other.type;
+    const auto otherBits = other.bits;
+    other.type = Type::INTEGER; // take ownership before releasing, `other` may be owned by our list
+    Release();
+    type = otherType;
+    bits = otherBits;
+    return *this;
+  }
+  ~Value() { Release(); }
+
+  [[nodiscard]] inline Type GetType() const { return type; }
+
+  template<typename T>
+  [[nodiscard]] inline bool Is() const {
+    if constexpr (std::is_same_v<T, int>) return type == Type::INTEGER;
+    else if constexpr (std::is_same_v<T, double>) return type == Type::DOUBLE;
+    else if constexpr (std::is_same_v<T, bool>) return type == Type::BOOLEAN;
+    else if constexpr (std::is_same_v<T, std::string>) return type == Type::STRING;
+    else if constexpr (std::is_same_v<T, List>) return type == Type::LIST;
+    else static_assert(!sizeof(T), "Invalid Value type!");
+  }
+
+  template<typename T>
+  [[nodiscard]] inline const T& Get() const {
+    if (!Is<T>()) BadAccess();
+    if constexpr (std::is_same_v<T, int>) return integer;
+    else if constexpr (std::is_same_v<T, double>) return real;
+    else if constexpr (std::is_same_v<T, bool>) return boolean;
+    else if constexpr (std::is_same_v<T, std::string>) return string ? string->value : EMPTY_STRING;
+    else {
+      if (list->kind != Array::Kind::ELEMENTS) Materialize();
+      return list->value;
+    }
+  } // throws `std::bad_variant_access`
+
+  // Read a value whose type has been proven, skipping the type check
+  template<typename T>
+  [[nodiscard]] inline const T& As() const {
+    if constexpr (std::is_same_v<T, int>) return integer;
+    else if constexpr (std::is_same_v<T, double>) return real;
+    else if constexpr (std::is_same_v<T, bool>) return boolean;
+    else return Get<T>();
+  }
+
+  [[nodiscard]] inline bool IsNumber() const { return type == Type::INTEGER || type == Type::DOUBLE; }
+
+  // Read a number as `T`, converting between integers and doubles
+  template<typename T>
+  [[nodiscard]] inline T GetNumber() const {
+    if (type == Type::INTEGER) return static_cast<T>(integer);
+    if (type == Type::DOUBLE) return static_cast<T>(real);
+    BadAccess();
+  } // throws `std::bad_variant_access`
+
+  // Mutable access to a list, detached from any other values sharing it
+  [[nodiscard]] List& EditList(); // throws `std::bad_variant_access`
+
+  // Lazy lists, whose elements are only stored once the list is read whole or edited
+  [[nodiscard]] static Value Range(int start, int size); // `start`, `start + 1`... `size` integers
+  [[nodiscard]] static Value Fill(Value element, int size); // `size` copies of `element`
+
+  // Read the size and elements of a list without storing a lazy list's elements
+  [[nodiscard]] inline int Size() const {
+    if (type != Type::LIST) BadAccess();
+    return list->kind == Array::Kind::ELEMENTS ? (int)list->value.size() : list->size;
+  } // throws `std::bad_variant_access`
+  [[nodiscard]] inline Value At(const int index) const {
+    switch (list->kind) {
+      case Array::Kind::RANGE:  return Value{list->start + index};
+      case Array::Kind::FILL:   return list->value.front();
+      default:                  return list->value[index];
+    }
+  } // `index` is within the list's `Size`
+
+  // Read an element in place, for readers that must leave reference counts alone; the elements of a `RANGE` are only computed, so they are written to `scratch`
+  [[nodiscard]] inline const Value& Element(const int index, Value& scratch) const {
+    switch (list->kind) {
+      case Array::Kind::RANGE:  return scratch = Value{list->start + index};
+      case Array::Kind::FILL:   return list->value.front();
+      default:                  return list->value[index];
+    }
+  } // `index` is within the list's `Size`
+
+  // Bytes the value holds, its heap objects included; records the length of the longest list within it in `longest`
+  [[nodiscard]] size_t Footprint(int& longest) const;
+
+  friend bool operator==(const Value& lvalue, const Value& rvalue);
+  friend bool operator<(const Value& lvalue, const Value& rvalue);
+  friend inline bool operator!=(const Value& lvalue, const Value& rvalue) { return !(lvalue == rvalue); }
+  friend inline bool operator>(const Value& lvalue, const Value& rvalue) { return rvalue < lvalue; }
+  friend inline bool operator<=(const Value& lvalue, const Value& rvalue) { return !(rvalue < lvalue); }
+  friend inline bool operator>=(const Value& lvalue, const Value& rvalue) { return !(lvalue < rvalue); }
+
+  friend class Jit; // compiled code reads and writes numbers and booleans in place
+
+private:
+  static const std::string EMPTY_STRING;
+};
+
+static_assert(sizeof(Value) == 16, "Value should stay within 16 bytes");
+
+// Print a value to the client, lists are printed element by element; returns the values printed
+int PrintValue(const Value& value);
@@ -1,16 +1,17 @@
 #pragma once
 
-#include <json.hpp>
+#include <value.hpp>
 
 #include <array>
-#include <variant>
 #include <string>
 #include <vector>
-#include <unordered_map>
+#include <optional>
 #include <tuple>
+#include <utility>
 #include <stdexcept>
 
-typedef std::variant<std::string, int, double, bool, Json> Any;
+// The runtime type of a variable, resolved from its definition's `primitive` at load time
+enum class Primitive { STRING, NUMBER, BOOLEAN, LIST };
 
 class BadDefinition final : public std::exception {
 private:
@@ -23,79 +24,158 @@ public:
     [[nodiscard]] inline const char* what() const noexcept override { return message.c_str(); }
 };
 
+[[nodiscard]] Primitive ParsePrimitive(const std::string& name, const std::string& primitive); // throws `BadDefinition`
+[[nodiscard]] const char* GetPrimitiveName(const Primitive primitive);
+
 class Variable final {
 private:
     std::string key; // unique identifier
     std::string name; // user-defined name
-    Any value;
-    std::string primitive; // runtime type
+    Value value;
+    Primitive primitive; // runtime type
 public:
     Variable() = delete;
-    Variable(const std::string key, const std::string name, const std::string primitive);
-    Variable(const std::string key, const std::string name, const std::string primitive, const Any value);
+    Variable(const std::string key, const std::string name, const Primitive primitive);
+    Variable(const std::string key, const std::string name, const Primitive primitive, const Value value);
 
-    void Invariant(const std::string name, const std::string primitive) const; // throws `BadDefinition`
+    void Invariant(const std::string& name) const; // throws `BadDefinition`
 
-    [[nodiscard]] inline std::string GetName() const { return name; }
-    [[nodiscard]] inline std::string GetPrimitive() const { return primitive; }
-    [[nodiscard]] inline std::string GetKey() const { return key; }
+    [[nodiscard]] inline const std::string& GetName() const { return name; }
+    [[nodiscard]] inline Primitive GetPrimitive() const { return primitive; }
+    [[nodiscard]] inline const std::string& GetKey() const { return key; }
 
-    template<typename T = Any>
-    [[nodiscard]] inline constexpr const T& Get() const { 
-        if constexpr (std::is_same_v<T, Any>) return value; // user has not specified the type, return the variant
-        else return std::get<T>(value); 
+    template<typename T = Value>
+    [[nodiscard]] inline const T& Get() const { 
+        if constexpr (std::is_same_v<T, Value>) return value; // user has not specified the type, return the value
+        else return value.Get<T>(); 
     } // throws `std::bad_variant_access`
 
-    template<typename T = Any>
-    inline constexpr void Set(const T value) {
-        Variable::value = value;
+    template<typename T = Value>
+    inline void Set(T value) {
+        Variable::value = std::move(value);
     }
 
+    // Mutate the value in place, the caller keeps it within the variable's primitive
+    [[nodiscard]] inline Value& Edit() { return value; }
+
+    // Mutate a list in place; throws `std::invalid_argument` when the variable does not hold a list
+    [[nodiscard]] Value::List& EditList();
+
     // todo: add operators (including assignment `=`)
 };
 
+// The locals of each procedure call in progress, innermost last; frames are only allocated to grow the pool
+class Locals final {
+public:
+    static constexpr int MAX_CALL_DEPTH = 256;
+private:
+    std::vector<std::optional<Variable>> cells;
+    std::vector<int> bases; // the first cell of each frame
+    int used = 0;
+public:
+    // Open a frame of `size` undefined locals; throws `std::overflow_error` past `MAX_CALL_DEPTH`
+    [[nodiscard]] std::optional<Variable>* Push(const int size);
+
+    // Release the innermost frame, returning the caller's frame; `nullptr` outside of any call
+    [[nodiscard]] std::optional<Variable>* Pop();
+
+    inline void Empty() {
+        cells.clear();
+        bases.clear();
+        used = 0;
+    }
+
+    [[nodiscard]] inline int Depth() const { return bases.size(); }
+
+    // Bytes the defined locals of every call in progress hold, as `Value::Footprint` measures them
+    [[nodiscard]] size_t Footprint(int& longest) const;
+
+    // The innermost frame, `nullptr` outside of any call
+    [[nodiscard]] inline std::optional<Variable>* Top() { return bases.empty() ? nullptr : cells.data() + bases.back(); }
+};
+
+// Variables live in contiguous slots resolved from their `definitionId` at load time; keys are kept for diagnostics.
+// The locals of a procedure are read from the frame of its innermost call instead, at their offset within it.
 class VariableStore final {
+public:
+    static constexpr int GLOBAL = -1; // the offset of a slot outside of any procedure
 private:
     static constexpr size_t MAX_VARIABLE_STORE = 1024;
-    std::unordered_map<std::string, Variable> store;
-    int stored;
+    std::vector<std::optional<Variable>> slots; // empty until the definition is evaluated
+    std::vector<std::string> keys;
+    std::vector<unsigned> versions; // bumped by each write to the slot, so readers can tell it is unchanged
+    std::vector<int> offsets; // of each local within its frame
+    std::optional<Variable>* frame = nullptr; // the locals of the innermost call
 
     inline void WriteCheck() const { 
-        if (stored > MAX_VARIABLE_STORE)
+        if (slots.size() > MAX_VARIABLE_STORE)
             throw std::overflow_error("Variable store is full!"); 
     }
-public:
-    VariableStore();
 
-    void Add(const std::string key, Variable variable);
+    [[nodiscard]] inline std::optional<Variable>& Cell(const int slot) {
+        const int offset = offsets[slot];
+        return offset == GLOBAL ? slots[slot] : frame[offset];
+    }
+    [[nodiscard]] inline const std::optional<Variable>& Cell(const int slot) const {
+        const int offset = offsets[slot];
+        return offset == GLOBAL ? slots[slot] : frame[offset];
+    }
 
-    inline void Empty() { 
-        store.clear();
-        stored = 0;
+    [[nodiscard]] inline Variable& At(const int slot) {
+        auto& variable = Cell(slot);
+        if (!variable) throw std::out_of_range("Variable `" + keys[slot] + "` is not defined!");
+        return *variable;
     }
 
-    template<typename T = Any>
-    [[nodiscard]] std::string Add(const T value) {
-        std::string primitive;
-        if constexpr (std::is_same_v<T, std::string>) primitive = "string";
-        else if constexpr (std::is_same_v<T, int>) primitive = "number";
-        else if constexpr (std::is_same_v<T, double>) primitive = "number";
-        else if constexpr (std::is_same_v<T, bool>) primitive = "bool";
-        else throw std::invalid_argument("Invalid type!");
+    // Access a variable to write it
+    [[nodiscard]] inline Variable& Write(const int slot) {
+        auto& variable = At(slot);
+        ++versions[slot];
+        return variable;
+    }
+public:
+    VariableStore() = default;
+
+    // Allocate a slot for each resolved key, discarding any previous variables; `offsets` places locals within their frame
+    void Allocate(const std::vector<std::string>& keys, const std::vector<int>& offsets = {});
 
-        const auto key = std::to_string(stored);
-        Add(key, { key, key, primitive, value }); 
+    void Add(const int slot, Variable variable);
 
-        return key;
+    // Read locals from `frame`; the values of `locals` change with it, so their versions are bumped
+    void SetFrame(std::optional<Variable>* frame, const std::vector<int>& locals);
+
+    inline void Empty() { 
+        slots.clear();
+        keys.clear();
+        versions.clear();
+        offsets.clear();
+        frame = nullptr;
     }
 
-    // todo: replace with range checked subscript overload?
-    [[nodiscard]] inline const Variable& Get(const std::string key) const {
-        return store.at(key);
+    // Bytes the defined global variables hold, and the length of the longest list among them; storage shared between variables counts for each.
+    // Locals live in the `Locals` of each script, which the engines measure beside it.
+    [[nodiscard]] std::pair<size_t, int> Measure() const;
+
+    [[nodiscard]] inline bool IsDefined(const int slot) const { return Cell(slot).has_value(); }
+    [[nodiscard]] inline bool IsLocal(const int slot) const { return offsets[slot] != GLOBAL; }
+    [[nodiscard]] inline unsigned GetVersion(const int slot) const { return versions[slot]; }
+
+    [[nodiscard]] inline const Variable& Get(const int slot) const {
+        const auto& variable = Cell(slot);
+        if (!variable) throw std::out_of_range("Variable `" + keys[slot] + "` is not defined!");
+        return *variable;
     } // throws `std::out_of_range` and `std::bad_variant_access`
 
-    template <typename T = Any>
-    inline void Set(const std::string key, const T value) { 
-        store.at(key).Set(value); // todo: overload assignment operator for Variable
+    [[nodiscard]] inline Value& Edit(const int slot) {
+        return Write(slot).Edit();
+    } // throws `std::out_of_range`
+
+    [[nodiscard]] inline Value::List& EditList(const int slot) {
+        return Write(slot).EditList();
+    } // throws `std::out_of_range` and `std::invalid_argument`
+
+    template <typename T = Value>
+    inline void Set(const int slot, T value) { 
+        Write(slot).Set(std::move(value)); // todo: overload assignment operator for Variable
     } // throws `std::out_of_range`
 };
\ No newline at end of file
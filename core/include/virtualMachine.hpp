@@ -0,0 +1,105 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <print.hpp>
+#include <renderer.hpp>
+#include <variableStore.hpp>
+#include <compiler.hpp>
+#include <peephole.hpp>
+#include <jit.hpp>
+#include <scheduler.hpp>
+#include <parallel.hpp>
+
+// Executes `Bytecode` compiled from a program; an alternative to the `Parser` and its `StackMachine`
+class VirtualMachine final {
+private:
+  static constexpr int MAX_REPEAT_LENGTH = 2048;
+  static constexpr int MIN_ARRAY_SIZE = 0;
+  static constexpr int MAX_ARRAY_SIZE = 65536; // uniform reserves and ranges are only stored once edited
+  static constexpr int NATIVE_SPEEDUP = 16; // instructions a compiled loop runs in the time the interpreter runs one
+
+  // A procedure call in progress
+  struct Frame {
+    const Ast::Procedure* procedure;
+    const Ast::Variable* result; // assigned the returned value in the caller's frame, `nullptr` when it is discarded
+    bool required; // returning without a value fails
+    int pc; // of the caller, to resume at
+    int base; // of the caller's registers
+  };
+
+  // What a script is running, held apart while another script runs
+  struct Thread {
+    int pc = 0;
+    int base = 0;
+    std::vector<Value> registers;
+    std::vector<Frame> frames;
+    Locals locals;
+  };
+
+  Renderer& renderer;
+
+  AbstractSyntaxTree program; // owns the nodes referenced by the bytecode
+  Bytecode bytecode;
+  std::vector<Value> registers;
+  VariableStore store;
+  int pc = 0;
+  int base = 0; // the first register of the innermost call
+  std::vector<Frame> frames; // innermost last
+  Locals locals;
+  Scheduler scheduler;
+  std::vector<Thread> scripts; // the state of each script while another runs
+  Jit jit;
+  bool tiered = true; // compile hot loops
+  long long printed = 0; // values, since the program was loaded
+  long long executed = 0; // instructions, since the program was loaded; those compiled loops run are counted from their fuel
+  int listQuota = 0; // elements `append` may grow a list to, 0 for `MAX_ARRAY_SIZE` alone
+  long long outputQuota = 0; // values the program may print, 0 for unlimited
+
+  [[nodiscard]] inline Value& Register(const int reg) { return registers[base + reg]; }
+  [[nodiscard]] inline int Integer(const int reg) const { return registers[base + reg].GetNumber<int>(); } // truncates doubles
+  [[nodiscard]] inline int Proven(const int reg) const { return registers[base + reg].As<int>(); } // proven an integer at compile time
+  [[nodiscard]] inline double Real(const int reg) const { return registers[base + reg].As<double>(); } // proven a double at compile time
+  [[nodiscard]] inline bool Boolean(const int reg) const { return registers[base + reg].Get<bool>(); }
+  [[nodiscard]] inline const Value& Operand(const int operand) const {
+    return IsConstantOperand(operand) ? bytecode.constants[GetConstantIndex(operand)] : store.Get(operand).Get();
+  } // throws `std::out_of_range`
+
+  void Define(const Instruction& instruction);
+  void Step(const Instruction& instruction, const int amount);
+  void Index(const Instruction& instruction);
+  void Append(const Instruction& instruction);
+  void Remove(const Instruction& instruction);
+  void Size(const Instruction& instruction);
+  void Range(const Instruction& instruction);
+  void Draw(const Instruction& instruction);
+  void Call(const Instruction& instruction);
+  void Bind(const Ast::Procedure& procedure, const int arguments);
+  void Return(const Instruction& instruction);
+  void Exchange(Thread& thread); // swap what the machine is running with `thread`
+  bool Switch(); // run the script the scheduler takes next; false when every script is waiting
+
+  template<bool TIERED>
+  bool Interpret(int instructions);
+  void Tier(int& instructions); // run the compiled loop at `pc`, compiling it once hot
+  static int Execute(Jit::MachinePtr machine, const int at); // run one instruction for compiled code
+public:
+  explicit VirtualMachine(Renderer& renderer);
+
+  void Load(AbstractSyntaxTree program);
+  bool Run(int instructions); // execute up to `instructions`, fewer once every script is waiting; false once the program has halted
+  [[nodiscard]] inline Scheduler& GetScheduler() { return scheduler; }
+  [[nodiscard]] inline long long GetPrinted() const { return printed; }
+  [[nodiscard]] inline long long GetExecuted() const { return executed; }
+  [[nodiscard]] std::pair<size_t, int> Measure() const; // the bytes variables hold, locals of every script included, and the longest list among them
+  inline void SetQuotas(const int list, const long long output) { listQuota = list; outputQuota = output; } // `append` or `print` past them throws `Governor::Exceeded`
+  inline bool Next() { return Run(1); }
+  inline void SetTiered(const bool tiered) { VirtualMachine::tiered = tiered; }
+
+  inline std::string GetCurrentBlockId() const {
+    const int current = pc - 1;
+    if (current < 0 || current >= (int)bytecode.sources.size() || !bytecode.sources[current]) return "";
+    return bytecode.sources[current]->key;
+  }
+};
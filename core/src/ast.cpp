@@ -0,0 +1,620 @@
+#include <ast.hpp>
+#include <unordered_map>
+#include <functional>
+#include <algorithm>
+
+using namespace std::string_literals;
+
+static const std::unordered_map<std::string, NodeType> NODE_TYPES {
+  { "definition", NodeType::DEFINITION },
+  { "assignment", NodeType::ASSIGNMENT },
+  { "increment", NodeType::INCREMENT },
+  { "decrement", NodeType::DECREMENT },
+
+  { "branch", NodeType::BRANCH },
+  { "repeat", NodeType::REPEAT },
+  { "while", NodeType::WHILE },
+  { "foreach", NodeType::FOREACH },
+  { "forever", NodeType::FOREVER },
+  { "parallel", NodeType::PARALLEL },
+  { "jump", NodeType::JUMP },
+  { "conditional_jump", NodeType::CONDITIONAL_JUMP },
+  { "exit", NodeType::EXIT },
+  { "comment", NodeType::COMMENT },
+
+  { "procedure", NodeType::PROCEDURE },
+  { "call", NodeType::CALL },
+  { "return", NodeType::RETURN },
+
+  { "script", NodeType::SCRIPT },
+  { "yield", NodeType::YIELD },
+  { "wait", NodeType::WAIT },
+  { "wait_frame", NodeType::WAIT_FRAME },
+
+  { "append", NodeType::APPEND },
+  { "remove", NodeType::REMOVE },
+
+  { "draw_line", NodeType::DRAW_LINE },
+  { "draw_rect", NodeType::DRAW_RECT },
+  { "draw_pixel", NodeType::DRAW_PIXEL },
+  { "clear_screen", NodeType::CLEAR_SCREEN },
+
+  { "print", NodeType::PRINT },
+  { "clear_output", NodeType::CLEAR_OUTPUT },
+
+  { "variable", NodeType::VARIABLE },
+  { "literal", NodeType::LITERAL },
+  { "list", NodeType::LIST },
+  { "subscript", NodeType::SUBSCRIPT },
+  { "size", NodeType::SIZE },
+  { "range", NodeType::RANGE },
+
+  { "sin", NodeType::SIN },
+  { "cos", NodeType::COS },
+  { "tan", NodeType::TAN },
+  { "asin", NodeType::ASIN },
+  { "acos", NodeType::ACOS },
+  { "atan", NodeType::ATAN },
+  { "log", NodeType::LOG },
+  { "log10", NodeType::LOG10 },
+  { "log2", NodeType::LOG2 },
+  { "sqrt", NodeType::SQRT },
+  { "cbrt", NodeType::CBRT },
+  { "abs", NodeType::ABS },
+  { "round", NodeType::ROUND },
+  { "ceil", NodeType::CEIL },
+  { "floor", NodeType::FLOOR },
+
+  { "add", NodeType::ADD },
+  { "subtract", NodeType::SUBTRACT },
+  { "multiply", NodeType::MULTIPLY },
+  { "divide", NodeType::DIVIDE },
+  { "modulo", NodeType::MODULO },
+  { "exponent", NodeType::EXPONENT },
+  { "min", NodeType::MIN },
+  { "max", NodeType::MAX },
+  { "random", NodeType::RANDOM },
+
+  { "and", NodeType::AND },
+  { "or", NodeType::OR },
+  { "xor", NodeType::XOR },
+  { "not", NodeType::NOT },
+  { "eq", NodeType::EQ },
+  { "ne", NodeType::NE },
+  { "gt", NodeType::GT },
+  { "ge", NodeType::GE },
+  { "lt", NodeType::LT },
+  { "le", NodeType::LE },
+};
+
+static constexpr int LVALUE = 0;
+static constexpr int RVALUE = 1;
+static constexpr int MAX_BRANCHES = 2;
+
+static NodePtr BuildExpression(Json& expression);
+static Nodes BuildComponents(Json& components);
+
+// Helpers //
+
+ValueType GetValueType(const Value& value) {
+  switch (value.GetType()) {
+    case Value::Type::INTEGER:  return ValueType::INTEGER;
+    case Value::Type::DOUBLE:   return ValueType::DOUBLE;
+    case Value::Type::BOOLEAN:  return ValueType::BOOLEAN;
+    case Value::Type::STRING:   return ValueType::STRING;
+    case Value::Type::LIST:     return ValueType::LIST;
+  }
+  return ValueType::ANY;
+}
+
+static std::string GetKey(Json& component) {
+  const auto& id = component["id"];
+  return id.is_string() ? id.get<std::string>() : ""s;
+}
+
+static NodeType GetType(Json& component) {
+  const auto& type = component["type"];
+  if (!type.is_string()) throw std::invalid_argument("Component is missing a TYPE!");
+
+  const auto name = type.get<std::string>();
+  if (const auto it = NODE_TYPES.find(name); it != NODE_TYPES.end()) return it->second;
+  throw std::invalid_argument("Invalid TYPE provided for component: `"s + name + "`"s);
+}
+
+static std::string GetString(Json& component, const char* field) {
+  const auto& value = component[field];
+  if (!value.is_string()) throw std::invalid_argument("Component `"s + GetKey(component) + "` is missing `"s + field + "`"s);
+  return value.get<std::string>();
+}
+
+std::string GetNodeName(const NodeType type) {
+  for (const auto& [name, nodeType] : NODE_TYPES)
+    if (nodeType == type) return name;
+  return "none";
+}
+
+// Evaluate a `Json` literal into a value
+static Value BuildValue(Json& value) {
+  if (value.is_null())            return ""s;
+  if (value.is_number_integer())  return value.get<int>();
+  if (value.is_number_float())    return value.get<double>();
+  if (value.is_boolean())         return value.get<bool>();
+  if (value.is_string())          return value.get<std::string>();
+
+  if (value.is_array()) throw std::invalid_argument("Unexpected array literal outside of `list` expression");
+  throw std::invalid_argument("Invalid literal type provided!");
+}
+
+static std::shared_ptr<Ast::Variable> BuildVariable(Json& variable) {
+  if (!variable.is_object() || GetType(variable) != NodeType::VARIABLE)
+    throw std::invalid_argument("Expected a `variable` expression!");
+  return std::make_shared<Ast::Variable>(GetKey(variable), GetString(variable, "definitionId"));
+}
+
+// Expressions //
+
+static NodePtr BuildOperation(const NodeType type, Json& operation) {
+  auto& expression = operation["expression"];
+  const auto key = GetKey(operation);
+
+  auto& left = expression.is_array() ? expression[LVALUE] : expression;
+  if (IsUnaryOperation(type) || type == NodeType::NOT)
+    return std::make_shared<Ast::Operation>(type, key, BuildExpression(left));
+
+  auto right = expression.is_array() && expression.size() >= MAX_BRANCHES
+    ? BuildExpression(expression[RVALUE])
+    : std::make_shared<Node>(NodeType::NONE, key);
+  return std::make_shared<Ast::Operation>(type, key, BuildExpression(left), right);
+}
+
+static bool DrawsRandom(Node& expression) {
+  bool random = expression.type == NodeType::RANDOM;
+  VisitChildren(expression, [&random](NodePtr& child) { random = random || DrawsRandom(*child); }, [](Nodes&) { });
+  return random;
+}
+
+static NodePtr BuildList(Json& list) {
+  Nodes elements;
+  if (auto& expression = list["expression"]; expression.is_array())
+    for (auto& element : expression) elements.push_back(BuildExpression(element));
+
+  auto& reserve = list["reserve"];
+  if (reserve.is_null()) return std::make_shared<Ast::List>(GetKey(list), elements, nullptr, nullptr);
+
+  auto reserved = std::make_shared<Ast::List>(GetKey(list), elements, BuildExpression(reserve), BuildExpression(list["fill"]));
+  reserved->uniform = !DrawsRandom(*reserved->fill);
+  return reserved;
+}
+
+static NodePtr BuildExpression(Json& expression) {
+  if (expression.is_null()) return std::make_shared<Node>(NodeType::NONE, ""s);
+  if (!expression.is_object()) throw std::invalid_argument("Expression must be an object!");
+
+  const auto type = GetType(expression);
+  const auto key = GetKey(expression);
+
+  if (IsOperation(type) || IsCondition(type)) return BuildOperation(type, expression);
+
+  switch (type) {
+    case NodeType::VARIABLE:
+      return BuildVariable(expression);
+
+    case NodeType::LITERAL: {
+      auto& value = expression["expression"];
+      if (value.is_object()) return BuildExpression(value); // a `list` wrapped in a literal
+      return std::make_shared<Ast::Literal>(key, BuildValue(value));
+    }
+
+    case NodeType::LIST:      return BuildList(expression);
+    case NodeType::SUBSCRIPT: return std::make_shared<Ast::Subscript>(key, BuildExpression(expression["list"]), BuildExpression(expression["index"]));
+    case NodeType::SIZE:      return std::make_shared<Ast::Size>(key, BuildExpression(expression["list"]));
+    case NodeType::RANGE:     return std::make_shared<Ast::Range>(key, BuildExpression(expression["start"]), BuildExpression(expression["end"]));
+
+    default: throw std::invalid_argument("Expected an expression: `"s + expression["type"].get<std::string>() + "` provided!"s);
+  }
+}
+
+// Components //
+
+static std::shared_ptr<Ast::Definition> BuildParameter(Json& parameter) {
+  if (!parameter.is_object()) throw std::invalid_argument("Parameter must be an object!");
+  const auto name = GetString(parameter, "name");
+  return std::make_shared<Ast::Definition>(GetKey(parameter), name, ParsePrimitive(name, GetString(parameter, "primitive")), std::make_shared<Node>(NodeType::NONE, GetKey(parameter)));
+}
+
+static NodePtr BuildProcedure(Json& procedure) {
+  std::vector<std::shared_ptr<Ast::Definition>> parameters;
+  auto& list = procedure["parameters"];
+  if (!list.is_null() && !list.is_array()) throw std::invalid_argument("Parameters must be an array!");
+  if (list.is_array()) for (auto& parameter : list) parameters.push_back(BuildParameter(parameter));
+
+  return std::make_shared<Ast::Procedure>(GetKey(procedure), GetString(procedure, "name"), std::move(parameters), BuildComponents(procedure["components"]));
+}
+
+static NodePtr BuildCall(Json& call) {
+  Nodes arguments;
+  auto& list = call["arguments"];
+  if (!list.is_null() && !list.is_array()) throw std::invalid_argument("Arguments must be an array!");
+  if (list.is_array()) for (auto& argument : list) arguments.push_back(BuildExpression(argument));
+
+  auto& result = call["result"];
+  return std::make_shared<Ast::Call>(GetKey(call), GetString(call, "procedure"), std::move(arguments), result.is_null() ? nullptr : BuildVariable(result));
+}
+
+static NodePtr BuildScript(Json& script) {
+  auto& priority = script["priority"];
+  const int ranked = priority.is_number_integer() ? priority.get<int>() : Ast::Script::MIN_PRIORITY - 1;
+  if (!priority.is_null() && (ranked < Ast::Script::MIN_PRIORITY || ranked > Ast::Script::MAX_PRIORITY))
+    throw std::invalid_argument("Script `"s + GetKey(script) + "` must have a PRIORITY from "s + std::to_string(Ast::Script::MIN_PRIORITY) + " to "s + std::to_string(Ast::Script::MAX_PRIORITY) + "!"s);
+
+  return std::make_shared<Ast::Script>(GetKey(script), GetString(script, "name"), priority.is_null() ? Ast::Script::MIN_PRIORITY : ranked, BuildComponents(script["components"]));
+}
+
+static NodePtr BuildJump(Json& jump, NodePtr condition) {
+  auto& expression = jump["expression"];
+  if (expression.is_object() && expression["type"] == "literal" && expression.contains("value"))
+    return std::make_shared<Ast::Jump>(GetKey(jump), std::make_shared<Ast::Literal>(GetKey(expression), BuildValue(expression["value"])), condition);
+  return std::make_shared<Ast::Jump>(GetKey(jump), BuildExpression(expression), condition);
+}
+
+static NodePtr BuildComponent(Json& component) {
+  if (!component.is_object()) throw std::invalid_argument("Component must be an object!");
+
+  const auto type = GetType(component);
+  const auto key = GetKey(component);
+
+  switch (type) {
+    case NodeType::COMMENT:
+    case NodeType::EXIT:
+    case NodeType::CLEAR_OUTPUT:
+    case NodeType::CLEAR_SCREEN:
+    case NodeType::YIELD:
+    case NodeType::WAIT_FRAME:
+      return std::make_shared<Node>(type, key);
+
+    case NodeType::DEFINITION: {
+      const auto name = GetString(component, "name");
+      return std::make_shared<Ast::Definition>(key, name, ParsePrimitive(name, GetString(component, "primitive")), BuildExpression(component["expression"]));
+    }
+    case NodeType::ASSIGNMENT:
+      return std::make_shared<Ast::Assignment>(key, BuildVariable(component["lvalue"]), BuildExpression(component["rvalue"]));
+    case NodeType::INCREMENT:
+    case NodeType::DECREMENT:
+      return std::make_shared<Ast::Increment>(type, key, BuildVariable(component["expression"]));
+
+    case NodeType::BRANCH: {
+      auto& branches = component["branches"];
+      if (!branches.is_array()) throw std::invalid_argument("Branches must be an array!");
+      if (branches.size() > MAX_BRANCHES) throw std::invalid_argument("Branches must be an array of size 2 or less!");
+
+      auto consequent = branches.empty() ? Nodes{} : BuildComponents(branches[LVALUE]);
+      auto alternative = branches.size() == MAX_BRANCHES ? BuildComponents(branches[RVALUE]) : Nodes{};
+      return std::make_shared<Ast::Branch>(key, BuildExpression(component["condition"]), consequent, alternative);
+    }
+
+    case NodeType::REPEAT:  return std::make_shared<Ast::Loop>(type, key, BuildExpression(component["repetition"]), BuildComponents(component["components"]));
+    case NodeType::WHILE:   return std::make_shared<Ast::Loop>(type, key, BuildExpression(component["condition"]), BuildComponents(component["components"]));
+    case NodeType::FOREACH: return std::make_shared<Ast::Loop>(type, key, BuildExpression(component["list"]), BuildComponents(component["components"]), BuildVariable(component["element"]));
+    case NodeType::FOREVER: return std::make_shared<Ast::Loop>(type, key, nullptr, BuildComponents(component["components"]));
+    case NodeType::PARALLEL: return std::make_shared<Ast::Parallel>(key, BuildVariable(component["list"]), BuildVariable(component["element"]), BuildComponents(component["components"]));
+
+    case NodeType::JUMP:              return BuildJump(component, nullptr);
+    case NodeType::CONDITIONAL_JUMP:  return BuildJump(component, BuildExpression(component["condition"]));
+
+    case NodeType::APPEND:  return std::make_shared<Ast::Append>(key, BuildExpression(component["list"]), BuildExpression(component["item"]));
+    case NodeType::REMOVE:  return std::make_shared<Ast::Remove>(key, BuildExpression(component["list"]), BuildExpression(component["index"]));
+    case NodeType::SIZE:    return std::make_shared<Ast::Size>(key, BuildExpression(component["list"]));
+
+    case NodeType::DRAW_LINE:
+      return std::make_shared<Ast::Draw>(type, key, std::array<NodePtr, Ast::Draw::MAX_OPERANDS>{
+        BuildExpression(component["x1"]), BuildExpression(component["y1"]), BuildExpression(component["x2"]), BuildExpression(component["y2"])
+      });
+    case NodeType::DRAW_RECT:
+      return std::make_shared<Ast::Draw>(type, key, std::array<NodePtr, Ast::Draw::MAX_OPERANDS>{
+        BuildExpression(component["x"]), BuildExpression(component["y"]), BuildExpression(component["w"]), BuildExpression(component["h"])
+      });
+    case NodeType::DRAW_PIXEL:
+      return std::make_shared<Ast::Draw>(type, key, std::array<NodePtr, Ast::Draw::MAX_OPERANDS>{
+        BuildExpression(component["x"]), BuildExpression(component["y"]), nullptr, nullptr
+      });
+
+    case NodeType::PRINT: return std::make_shared<Ast::Print>(key, BuildExpression(component["expression"]));
+
+    case NodeType::PROCEDURE: return BuildProcedure(component);
+    case NodeType::CALL:      return BuildCall(component);
+    case NodeType::RETURN: {
+      auto& expression = component["expression"];
+      return std::make_shared<Ast::Return>(key, expression.is_null() ? nullptr : BuildExpression(expression));
+    }
+
+    case NodeType::SCRIPT: return BuildScript(component);
+    case NodeType::WAIT:   return std::make_shared<Ast::Wait>(key, BuildExpression(component["duration"]));
+
+    default: throw std::invalid_argument("Invalid TYPE provided for component: `"s + component["type"].get<std::string>() + "`"s);
+  }
+}
+
+static Nodes BuildComponents(Json& components) {
+  Nodes nodes;
+  if (components.is_null()) return nodes; // an empty body
+  if (!components.is_array()) throw std::invalid_argument("Components must be an array!");
+
+  nodes.reserve(components.size());
+  for (auto& component : components) nodes.push_back(BuildComponent(component));
+  return nodes;
+}
+
+// Resolution //
+
+typedef std::unordered_map<std::string, int> Slots;
+
+// Variables resolve to the locals of the procedure they are read in, then to globals
+struct Scope {
+  Slots& globals;
+  std::vector<std::string>& keys;
+  std::vector<int>& offsets;
+  Ast::Procedure* procedure = nullptr;
+  Slots locals{};
+};
+
+static int Resolve(Scope& scope, const std::string& key) {
+  if (const auto it = scope.locals.find(key); it != scope.locals.end()) return it->second;
+  if (const auto it = scope.globals.find(key); it != scope.globals.end()) return it->second;
+
+  const int slot = scope.keys.size();
+  scope.globals.emplace(key, slot);
+  scope.keys.push_back(key);
+  scope.offsets.push_back(VariableStore::GLOBAL);
+  return slot;
+}
+
+// Give a parameter or definition of the scope's procedure the next offset of its frame
+static int Local(Scope& scope, const std::string& key) {
+  auto& locals = scope.procedure->locals;
+  const int slot = scope.keys.size();
+  scope.locals.emplace(key, slot);
+  scope.keys.push_back(key);
+  scope.offsets.push_back(locals.size());
+  locals.push_back(slot);
+  return slot;
+}
+
+static void CollectLocals(Nodes& components, Scope& scope) {
+  for (auto& component : components) {
+    if (component->type == NodeType::DEFINITION) GetNode<Ast::Definition>(*component).slot = Local(scope, component->key);
+    VisitChildren(*component, [](NodePtr&) { }, [&scope](Nodes& body) { CollectLocals(body, scope); });
+  }
+}
+
+// Give every definition and variable reference a dense slot; a reference without a definition keeps its slot and fails when read.
+// A reference to a local outside of its procedure resolves to a global of the same key, which is never defined.
+static void ResolveSlots(Nodes& nodes, Scope& scope, const bool top) {
+  std::function<void(NodePtr&)> expression = [&](NodePtr& node) {
+    if (node->type == NodeType::VARIABLE) {
+      auto& variable = GetNode<Ast::Variable>(*node);
+      variable.slot = Resolve(scope, variable.definitionId);
+    } else if (node->type == NodeType::DEFINITION && !scope.procedure) {
+      auto& definition = GetNode<Ast::Definition>(*node);
+      definition.slot = Resolve(scope, definition.key);
+    }
+    VisitChildren(*node, expression, [&](Nodes& block) { ResolveSlots(block, scope, false); });
+  };
+
+  for (auto& node : nodes) {
+    if (node->type == NodeType::SCRIPT && (!top || scope.procedure)) throw std::invalid_argument("Script `"s + node->key + "` must be defined at the top level!"s);
+    if (node->type != NodeType::PROCEDURE) { // scripts share the globals of the program
+      expression(node);
+      continue;
+    }
+    if (!top || scope.procedure) throw std::invalid_argument("Procedure `"s + node->key + "` must be defined at the top level!"s);
+
+    // parameters take the first offsets of the frame, then definitions in the order they appear
+    auto& procedure = GetNode<Ast::Procedure>(*node);
+    Scope local{ scope.globals, scope.keys, scope.offsets, &procedure };
+    for (auto& parameter : procedure.parameters) parameter->slot = Local(local, parameter->key);
+    CollectLocals(procedure.components, local);
+    ResolveSlots(procedure.components, local, false);
+  }
+}
+
+// What runs after a statement of a procedure: the end of the procedure ( `nullptr` ), a `return`, or anything else
+static const Node CONTINUES{ NodeType::NONE, ""s };
+
+static bool IsTail(const Ast::Call& call, const Node* after, const Ast::Procedure& procedure) {
+  if (!after || (after->type == NodeType::RETURN && !GetNode<Ast::Return>(*after).expression)) return !call.result;
+  if (after->type != NodeType::RETURN || !call.result) return false;
+
+  // `call -> local; return local`, the local is released with the frame the call replaces
+  const auto& value = *GetNode<Ast::Return>(*after).expression;
+  const int slot = call.result->slot;
+  const auto& locals = procedure.locals;
+  return value.type == NodeType::VARIABLE && GetNode<Ast::Variable>(value).slot == slot && std::find(locals.begin(), locals.end(), slot) != locals.end();
+}
+
+// Mark the calls whose caller returns exactly what they do
+static void MarkTails(Nodes& components, const Ast::Procedure& procedure, const Node* after) {
+  const int count = components.size();
+  for (int i = 0; i < count; ++i) {
+    auto& component = *components[i];
+    const Node* next = i + 1 == count ? after : components[i + 1]->type == NodeType::RETURN ? components[i + 1].get() : &CONTINUES;
+
+    if (component.type == NodeType::CALL) GetNode<Ast::Call>(component).tail = IsTail(GetNode<Ast::Call>(component), next, procedure);
+    else if (component.type == NodeType::BRANCH) {
+      auto& branch = GetNode<Ast::Branch>(component);
+      MarkTails(branch.consequent, procedure, next);
+      MarkTails(branch.alternative, procedure, next);
+    }
+    else VisitChildren(component, [](NodePtr&) { }, [&procedure](Nodes& body) { MarkTails(body, procedure, &CONTINUES); }); // loops run their body again
+  }
+}
+
+typedef std::unordered_map<std::string, Ast::Procedure*> Procedures;
+
+static void LinkCalls(Nodes& components, const Procedures& procedures) {
+  for (auto& component : components) {
+    if (component->type == NodeType::CALL) {
+      auto& call = GetNode<Ast::Call>(*component);
+      const auto procedure = procedures.find(call.procedureId);
+      call.procedure = procedure == procedures.end() ? nullptr : procedure->second;
+    }
+    VisitChildren(*component, [](NodePtr&) { }, [&procedures](Nodes& body) { LinkCalls(body, procedures); });
+  }
+}
+
+// Parallel Loops //
+
+// The body of a `parallel` block may only write its element and its own definitions, and only compute numbers and booleans, so its iterations can run at once
+static void CheckParallel(Ast::Parallel& parallel) {
+  using namespace std::string_literals;
+  const auto fail = [&parallel](const std::string& reason) { throw std::invalid_argument("Parallel `"s + parallel.key + "` "s + reason); };
+  if (parallel.list->slot == parallel.element->slot) fail("must iterate a list other than its element!"s);
+
+  // each iteration holds its element and definitions, wherever they are in the body
+  auto& locals = parallel.locals;
+  locals.assign(1, parallel.element->slot);
+  std::function<void(Nodes&)> define = [&](Nodes& components) {
+    for (auto& component : components) {
+      if (component->type == NodeType::DEFINITION) locals.push_back(GetNode<Ast::Definition>(*component).slot);
+      VisitChildren(*component, [](NodePtr&) { }, define);
+    }
+  };
+  define(parallel.components);
+
+  const auto write = [&](const Ast::Variable& variable) {
+    if (std::find(locals.begin(), locals.end(), variable.slot) == locals.end()) fail("may only write its element and its own definitions!"s);
+  };
+
+  std::function<void(NodePtr&)> expression = [&](NodePtr& node) {
+    const auto type = node->type;
+    if (type == NodeType::LIST || type == NodeType::RANGE || type == NodeType::RANDOM) fail("can not evaluate a `"s + GetNodeName(type) + "` expression!"s);
+    if (type == NodeType::LITERAL && !GetNode<Ast::Literal>(*node).value.IsNumber() && !GetNode<Ast::Literal>(*node).value.Is<bool>()) fail("can only compute numbers and booleans!"s);
+    VisitChildren(*node, expression, [](Nodes&) { });
+  };
+
+  std::function<void(Nodes&)> check = [&](Nodes& components) {
+    for (auto& component : components) {
+      switch (component->type) {
+        case NodeType::COMMENT:
+        case NodeType::BRANCH:
+        case NodeType::REPEAT:
+        case NodeType::WHILE:       break;
+        case NodeType::DEFINITION: {
+          const auto primitive = GetNode<Ast::Definition>(*component).primitive;
+          if (primitive != Primitive::NUMBER && primitive != Primitive::BOOLEAN) fail("can only compute numbers and booleans!"s);
+          break;
+        }
+        case NodeType::ASSIGNMENT:  write(*GetNode<Ast::Assignment>(*component).lvalue); break;
+        case NodeType::INCREMENT:
+        case NodeType::DECREMENT:   write(*GetNode<Ast::Increment>(*component).variable); break;
+        default: fail("can not run a `"s + GetNodeName(component->type) + "` block!"s);
+      }
+      VisitChildren(*component, expression, check);
+    }
+  };
+  check(parallel.components);
+}
+
+static void CheckParallels(Nodes& components) {
+  for (auto& component : components) {
+    if (component->type == NodeType::PARALLEL) CheckParallel(GetNode<Ast::Parallel>(*component));
+    VisitChildren(*component, [](NodePtr&) { }, CheckParallels);
+  }
+}
+
+// Copying //
+
+NodePtr Clone(const Node& node) {
+  using namespace Ast;
+  NodePtr copy;
+  switch (node.type) {
+    case NodeType::LITERAL:     copy = std::make_shared<Literal>(GetNode<Literal>(node)); break;
+    case NodeType::VARIABLE:    copy = std::make_shared<Ast::Variable>(GetNode<Ast::Variable>(node)); break;
+    case NodeType::LIST:        copy = std::make_shared<List>(GetNode<List>(node)); break;
+    case NodeType::RANGE:       copy = std::make_shared<Range>(GetNode<Range>(node)); break;
+    case NodeType::SUBSCRIPT:   copy = std::make_shared<Subscript>(GetNode<Subscript>(node)); break;
+    case NodeType::SIZE:        copy = std::make_shared<Size>(GetNode<Size>(node)); break;
+    case NodeType::DEFINITION:  copy = std::make_shared<Definition>(GetNode<Definition>(node)); break;
+    case NodeType::ASSIGNMENT:  copy = std::make_shared<Assignment>(GetNode<Assignment>(node)); break;
+    case NodeType::INCREMENT:
+    case NodeType::DECREMENT:   copy = std::make_shared<Increment>(GetNode<Increment>(node)); break;
+    case NodeType::BRANCH:      copy = std::make_shared<Branch>(GetNode<Branch>(node)); break;
+    case NodeType::REPEAT:
+    case NodeType::WHILE:
+    case NodeType::FOREACH:
+    case NodeType::FOREVER:     copy = std::make_shared<Loop>(GetNode<Loop>(node)); break;
+    case NodeType::PARALLEL:    copy = std::make_shared<Ast::Parallel>(GetNode<Ast::Parallel>(node)); break;
+    case NodeType::JUMP:
+    case NodeType::CONDITIONAL_JUMP: copy = std::make_shared<Jump>(GetNode<Jump>(node)); break;
+    case NodeType::APPEND:      copy = std::make_shared<Append>(GetNode<Append>(node)); break;
+    case NodeType::REMOVE:      copy = std::make_shared<Remove>(GetNode<Remove>(node)); break;
+    case NodeType::DRAW_LINE:
+    case NodeType::DRAW_RECT:
+    case NodeType::DRAW_PIXEL:  copy = std::make_shared<Draw>(GetNode<Draw>(node)); break;
+    case NodeType::PRINT:       copy = std::make_shared<Print>(GetNode<Print>(node)); break;
+    case NodeType::PROCEDURE:   copy = std::make_shared<Procedure>(GetNode<Procedure>(node)); break;
+    case NodeType::CALL:        copy = std::make_shared<Call>(GetNode<Call>(node)); break;
+    case NodeType::RETURN:      copy = std::make_shared<Return>(GetNode<Return>(node)); break;
+    case NodeType::SCRIPT:      copy = std::make_shared<Script>(GetNode<Script>(node)); break;
+    case NodeType::WAIT:        copy = std::make_shared<Wait>(GetNode<Wait>(node)); break;
+    default:
+      if (IsOperation(node.type) || IsCondition(node.type)) copy = std::make_shared<Operation>(GetNode<Operation>(node));
+      else copy = std::make_shared<Node>(node);
+      break;
+  }
+
+  // targets are only visited as copies, so they are replaced here
+  const auto target = [](std::shared_ptr<Ast::Variable>& variable) { if (variable) variable = std::make_shared<Ast::Variable>(*variable); };
+  switch (copy->type) {
+    case NodeType::ASSIGNMENT:  target(GetNode<Assignment>(*copy).lvalue); break;
+    case NodeType::INCREMENT:
+    case NodeType::DECREMENT:   target(GetNode<Increment>(*copy).variable); break;
+    case NodeType::FOREACH:     target(GetNode<Loop>(*copy).element); break;
+    case NodeType::PARALLEL:
+      target(GetNode<Ast::Parallel>(*copy).list);
+      target(GetNode<Ast::Parallel>(*copy).element);
+      break;
+    case NodeType::CALL:        target(GetNode<Call>(*copy).result); break;
+    default: break;
+  }
+
+  VisitChildren(*copy,
+    [](NodePtr& child) { child = Clone(*child); },
+    [](Nodes& body) { for (auto& component : body) component = Clone(*component); }
+  );
+  return copy;
+}
+
+// API //
+
+AbstractSyntaxTree BuildTree(Json& program) {
+  if (!program.is_array()) throw std::invalid_argument("Program must be an array!");
+
+  auto nodes = BuildComponents(program);
+  Slots slots;
+  std::vector<std::string> keys;
+  std::vector<int> offsets;
+  Scope scope{ slots, keys, offsets };
+  ResolveSlots(nodes, scope, true);
+  CheckParallels(nodes);
+
+  // procedures are called by their block id
+  Procedures procedures;
+  int scripts = 0;
+  for (auto& node : nodes) {
+    if (node->type == NodeType::SCRIPT) GetNode<Ast::Script>(*node).index = ++scripts;
+    if (node->type != NodeType::PROCEDURE) continue;
+    auto& procedure = GetNode<Ast::Procedure>(*node);
+    procedure.index = procedures.size();
+    procedures.emplace(procedure.key, &procedure);
+  }
+  LinkCalls(nodes, procedures);
+  for (const auto& [key, procedure] : procedures) MarkTails(procedure->components, *procedure, nullptr);
+
+  return AbstractSyntaxTree{ std::move(nodes), std::move(keys), std::move(offsets) };
+}
+
+AbstractSyntaxTree ParseProgram(const std::string& source) {
+  if (source.empty()) throw std::invalid_argument("Program must not be empty!");
+  auto program = Json::parse(source);
+  return BuildTree(program);
+}
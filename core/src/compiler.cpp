@@ -0,0 +1,555 @@
+#include <compiler.hpp>
+
+// Emission //
+
+int Compiler::Emit(const Opcode op, const int a, const int b, const int c) {
+  bytecode.code.push_back({ op, NodeType::NONE, a, b, c });
+  bytecode.sources.push_back(source);
+  return Here() - 1;
+}
+
+int Compiler::EmitOperation(const Opcode op, const NodeType operation, const int a, const int b, const int c) {
+  const int at = Emit(op, a, b, c);
+  bytecode.code[at].operation = operation;
+  return at;
+}
+
+void Compiler::EmitStep(const Ast::Variable& variable, const int amount) {
+  if (variable.valueType == ValueType::INTEGER) Emit(Opcode::INCREMENT_INTEGER, variable.slot, amount);
+  else Emit(amount > 0 ? Opcode::INCREMENT : Opcode::DECREMENT, variable.slot);
+}
+
+void Compiler::Patch(const int at, const int target) {
+  auto& instruction = bytecode.code.at(at);
+  if (instruction.op == Opcode::JUMP) instruction.a = target;
+  else if (instruction.op == Opcode::JUMP_COMPARE || instruction.op == Opcode::JUMP_COMPARE_INTEGER) instruction.c = target;
+  else instruction.b = target;
+}
+
+int Compiler::Allocate() {
+  const int reg = top++;
+  if (top > bytecode.registers) bytecode.registers = top;
+  return reg;
+}
+
+int Compiler::Constant(Value value) {
+  bytecode.constants.push_back(std::move(value));
+  return bytecode.constants.size() - 1;
+}
+
+void Compiler::Fail(const std::string& message) {
+  Emit(Opcode::FAIL, Constant(message));
+}
+
+// Expressions //
+
+void Compiler::CompileExpression(const Node& expression, const int target) {
+  const int base = top;
+
+  if (expression.type == NodeType::AND || expression.type == NodeType::OR) {
+    // the right operand is only evaluated when the left does not decide the result
+    const auto& operation = GetNode<Ast::Operation>(expression);
+    const bool conjunction = expression.type == NodeType::AND;
+
+    CompileExpression(*operation.left, target);
+    const int decided = Emit(conjunction ? Opcode::JUMP_UNLESS : Opcode::JUMP_IF, target);
+    const int right = Allocate();
+    CompileExpression(*operation.right, right);
+    Emit(conjunction ? Opcode::AND : Opcode::OR, target, target, right); // checks the right is a boolean
+    Patch(decided, Here());
+
+    top = base;
+    return;
+  }
+
+  if (IsOperation(expression.type) || IsCondition(expression.type)) {
+    const auto& operation = GetNode<Ast::Operation>(expression);
+
+    const int left = Allocate();
+    CompileExpression(*operation.left, left);
+
+    const bool proven = expression.valueType == ValueType::INTEGER;
+    const bool real = expression.valueType == ValueType::DOUBLE;
+    const bool unary = IsUnaryOperation(operation.type);
+    if (IsOperation(operation.type) && real) { // proven integer operands are promoted, as the tree engine extracts them
+      const int right = unary ? left : Allocate();
+      if (operation.left->valueType == ValueType::INTEGER) Emit(Opcode::PROMOTE, left);
+      if (!unary) {
+        CompileExpression(*operation.right, right);
+        if (operation.right->valueType == ValueType::INTEGER) Emit(Opcode::PROMOTE, right);
+      }
+      EmitOperation(Opcode::REAL, operation.type, target, left, right);
+    }
+    else if (IsOperation(operation.type) && (unary || !proven)) {
+      const int right = unary ? left : Allocate();
+      if (!unary) CompileExpression(*operation.right, right);
+      EmitOperation(proven ? Opcode::MATH : Opcode::NUMERIC, operation.type, target, left, right); // `NUMERIC` dispatches on the operands at runtime
+    }
+    else if (operation.type == NodeType::NOT) Emit(Opcode::NOT, target, left);
+    else if (operation.operands == ValueType::INTEGER) {
+      const int right = Allocate();
+      CompileExpression(*operation.right, right);
+      EmitOperation(Opcode::COMPARE_INTEGER, operation.type, target, left, right);
+    }
+    else {
+      const int right = Allocate();
+      CompileExpression(*operation.right, right);
+
+      Opcode op;
+      switch (operation.type) {
+        case NodeType::ADD:       op = Opcode::ADD; break;
+        case NodeType::SUBTRACT:  op = Opcode::SUBTRACT; break;
+        case NodeType::MULTIPLY:  op = Opcode::MULTIPLY; break;
+        case NodeType::DIVIDE:    op = Opcode::DIVIDE; break;
+        case NodeType::MODULO:    op = Opcode::MODULO; break;
+        case NodeType::EXPONENT:  op = Opcode::EXPONENT; break;
+        case NodeType::MIN:       op = Opcode::MIN; break;
+        case NodeType::MAX:       op = Opcode::MAX; break;
+        case NodeType::RANDOM:    op = Opcode::RANDOM; break;
+        case NodeType::EQ:        op = Opcode::EQ; break;
+        case NodeType::NE:        op = Opcode::NE; break;
+        case NodeType::GT:        op = Opcode::GT; break;
+        case NodeType::GE:        op = Opcode::GE; break;
+        case NodeType::LT:        op = Opcode::LT; break;
+        case NodeType::LE:        op = Opcode::LE; break;
+        case NodeType::XOR:       op = Opcode::XOR; break;
+        default: throw std::invalid_argument("Invalid operation TYPE provided!");
+      }
+      Emit(op, target, left, right);
+    }
+
+    top = base;
+    return;
+  }
+
+  switch (expression.type) {
+    case NodeType::LITERAL:
+      Emit(Opcode::LOAD_CONSTANT, target, Constant(GetNode<Ast::Literal>(expression).value));
+      break;
+
+    case NodeType::VARIABLE:
+      Emit(Opcode::LOAD, target, GetNode<Ast::Variable>(expression).slot);
+      break;
+
+    case NodeType::LIST:
+      CompileList(GetNode<Ast::List>(expression), target);
+      break;
+
+    case NodeType::SUBSCRIPT: {
+      const auto& subscript = GetNode<Ast::Subscript>(expression);
+      const int list = Allocate();
+      const int index = Allocate();
+      CompileExpression(*subscript.list, list);
+      CompileExpression(*subscript.index, index);
+      Emit(subscript.bounded ? Opcode::ELEMENT : Opcode::INDEX, target, list, index);
+      break;
+    }
+
+    case NodeType::SIZE: {
+      const int list = Allocate();
+      CompileExpression(*GetNode<Ast::Size>(expression).list, list);
+      Emit(Opcode::SIZE, target, list);
+      break;
+    }
+
+    case NodeType::RANGE: {
+      const auto& range = GetNode<Ast::Range>(expression);
+      const int start = Allocate();
+      const int end = Allocate();
+      CompileExpression(*range.start, start);
+      CompileExpression(*range.end, end);
+      Emit(Opcode::RANGE, target, start, end);
+      break;
+    }
+
+    case NodeType::NONE:
+      Fail("Expected an expression, but none was provided!");
+      break;
+
+    default:
+      Fail("Expected variable or literal expression: `" + expression.key + "` provided!");
+      break;
+  }
+
+  top = base;
+}
+
+void Compiler::CompileList(const Ast::List& list, const int target) {
+  Emit(Opcode::NEW_LIST, target);
+
+  if (!list.reserve) {
+    const int element = Allocate();
+    for (const auto& expression : list.elements) {
+      CompileExpression(*expression, element);
+      Emit(Opcode::PUSH, target, element);
+    }
+    return;
+  }
+
+  const int reserve = Allocate();
+  const int counter = Allocate();
+  const int element = Allocate();
+
+  CompileExpression(*list.reserve, reserve);
+  Emit(Opcode::RESERVE, reserve);
+  Emit(Opcode::LOAD_CONSTANT, counter, Constant(0));
+
+  // a fill that draws no random numbers is evaluated once, but not for an empty list
+  if (list.uniform) {
+    const int empty = EmitOperation(Opcode::JUMP_COMPARE_INTEGER, NodeType::GE, counter, reserve, 0);
+    CompileExpression(*list.fill, element);
+    Emit(Opcode::FILL, target, element, reserve);
+    Patch(empty, Here());
+    return;
+  }
+
+  // evaluate the fill for each reserved element
+
+  const int loop = Here();
+  const int exit = EmitOperation(Opcode::JUMP_COMPARE_INTEGER, NodeType::GE, counter, reserve, 0);
+  CompileExpression(*list.fill, element);
+  Emit(Opcode::PUSH, target, element);
+  Emit(Opcode::STEP, counter);
+  Emit(Opcode::JUMP, loop);
+  Patch(exit, Here());
+}
+
+// Jump when `condition` evaluates to `when`, returning the jumps to patch with their target.
+// `and` and `or` short-circuit, and comparisons branch on their operands without producing a boolean.
+std::vector<int> Compiler::CompileJump(const Node& condition, const bool when) {
+  const int base = top;
+  std::vector<int> jumps;
+
+  if (condition.type == NodeType::NOT) return CompileJump(*GetNode<Ast::Operation>(condition).left, !when);
+
+  if (condition.type == NodeType::AND || condition.type == NodeType::OR) {
+    const auto& operation = GetNode<Ast::Operation>(condition);
+    const bool decisive = condition.type == NodeType::OR; // the operand value that decides the result
+
+    if (when == decisive) { // either operand may take the jump
+      jumps = CompileJump(*operation.left, when);
+      const auto right = CompileJump(*operation.right, when);
+      jumps.insert(jumps.end(), right.begin(), right.end());
+    } else { // the left decides against jumping, otherwise the right decides
+      const auto decided = CompileJump(*operation.left, decisive);
+      jumps = CompileJump(*operation.right, when);
+      for (const int at : decided) Patch(at, Here());
+    }
+    return jumps;
+  }
+
+  if (IsComparison(condition.type)) {
+    const auto& operation = GetNode<Ast::Operation>(condition);
+    const int left = Allocate();
+    const int right = Allocate();
+    CompileExpression(*operation.left, left);
+    CompileExpression(*operation.right, right);
+
+    const auto op = operation.operands == ValueType::INTEGER ? Opcode::JUMP_COMPARE_INTEGER : Opcode::JUMP_COMPARE;
+    jumps.push_back(EmitOperation(op, when ? condition.type : InvertComparison(condition.type), left, right, 0));
+  } else {
+    const int value = Allocate();
+    CompileExpression(condition, value);
+    jumps.push_back(Emit(when ? Opcode::JUMP_IF : Opcode::JUMP_UNLESS, value));
+  }
+
+  top = base;
+  return jumps;
+}
+
+// Statements //
+
+void Compiler::CompileBranch(const Ast::Branch& branch) {
+  const auto alternative = CompileJump(*branch.condition, false);
+
+  CompileComponents(branch.consequent);
+  if (branch.alternative.empty()) {
+    for (const int at : alternative) Patch(at, Here());
+    return;
+  }
+
+  const int end = Emit(Opcode::JUMP);
+  for (const int at : alternative) Patch(at, Here());
+  CompileComponents(branch.alternative);
+  Patch(end, Here());
+}
+
+void Compiler::CompileRepeat(const Ast::Loop& repeat) {
+  // the count and counter are held for the length of the body
+  const int times = Allocate();
+  const int counter = Allocate();
+
+  CompileExpression(*repeat.expression, times);
+  Emit(Opcode::REPEAT, times);
+  Emit(Opcode::LOAD_CONSTANT, counter, Constant(0));
+  const int exit = EmitOperation(Opcode::JUMP_COMPARE_INTEGER, NodeType::GE, counter, times, 0);
+
+  const int loop = Here();
+  CompileComponents(repeat.components);
+  Emit(Opcode::STEP, counter);
+  EmitOperation(Opcode::JUMP_COMPARE_INTEGER, NodeType::LT, counter, times, loop);
+  Patch(exit, Here());
+}
+
+void Compiler::CompileForeach(const Ast::Loop& foreach) {
+  // the list, its size, and the counter are held for the length of the body, so the list is checked once
+  const int list = Allocate();
+  const int size = Allocate();
+  const int counter = Allocate();
+  const int element = Allocate();
+
+  CompileExpression(*foreach.expression, list);
+  Emit(Opcode::ITERATE, list, size);
+  Emit(Opcode::LOAD_CONSTANT, counter, Constant(0));
+  const int exit = EmitOperation(Opcode::JUMP_COMPARE_INTEGER, NodeType::GE, counter, size, 0);
+
+  const int loop = Here();
+  Emit(Opcode::ELEMENT, element, list, counter);
+  Emit(Opcode::STORE, foreach.element->slot, element);
+  CompileComponents(foreach.components);
+  Emit(Opcode::STEP, counter);
+  EmitOperation(Opcode::JUMP_COMPARE_INTEGER, NodeType::LT, counter, size, loop);
+  Patch(exit, Here());
+  Emit(Opcode::LOAD_CONSTANT, list, Constant(0)); // release the list, so editing it after the loop does not copy it
+}
+
+void Compiler::CompileWhile(const Ast::Loop& loop) {
+  // the body runs before the condition is first tested
+  const int start = Here();
+  CompileComponents(loop.components);
+
+  for (const int at : CompileJump(*loop.expression, true)) Patch(at, start);
+}
+
+void Compiler::CompileForever(const Ast::Loop& forever) {
+  const int start = Here();
+  CompileComponents(forever.components);
+  Emit(Opcode::JUMP, start);
+}
+
+void Compiler::CompileCall(const Ast::Call& call) {
+  const auto* callee = call.procedure;
+  if (!callee) {
+    Fail("Procedure `" + call.procedureId + "` is not defined!");
+    return;
+  }
+  const int count = callee->parameters.size();
+  if ((int)call.arguments.size() != count) {
+    Fail("Procedure `" + callee->name + "` takes " + std::to_string(count) + " arguments!");
+    return;
+  }
+
+  // the arguments are the first registers of the callee
+  const int first = top;
+  for (int i = 0; i < count; ++i) Allocate();
+  for (int i = 0; i < count; ++i) CompileExpression(*call.arguments[i], first + i);
+
+  bytecode.calls.push_back(&call);
+  Emit(Opcode::CALL, bytecode.calls.size() - 1, first, call.tail);
+}
+
+void Compiler::CompileReturn(const Ast::Return& ret) {
+  if (!procedure) {
+    Fail("RETURN outside of a procedure!");
+    return;
+  }
+  if (!ret.expression) {
+    Emit(Opcode::RETURN);
+    return;
+  }
+
+  const int value = Allocate();
+  CompileExpression(*ret.expression, value);
+  Emit(Opcode::RETURN, value, true);
+}
+
+void Compiler::CompileDraw(const Ast::Draw& draw, const Opcode op, const int operands) {
+  const int base = top;
+  for (int i = 0; i < operands; ++i) Allocate();
+  for (int i = 0; i < operands; ++i) CompileExpression(*draw.operands[i], base + i);
+  Emit(op, base);
+}
+
+void Compiler::CompileComponent(const Node& component) {
+  const Node* parent = source;
+  source = &component;
+  const int base = top;
+
+  switch (component.type) {
+    case NodeType::COMMENT: break;
+    case NodeType::EXIT: Emit(Opcode::HALT); break;
+
+    case NodeType::DEFINITION: {
+      const auto& definition = GetNode<Ast::Definition>(component);
+      bytecode.definitions.push_back(&definition);
+      const int index = bytecode.definitions.size() - 1;
+
+      if (definition.expression->type == NodeType::NONE) {
+        Emit(Opcode::DEFINE_DEFAULT, index);
+        break;
+      }
+
+      const int value = Allocate();
+      CompileExpression(*definition.expression, value);
+      Emit(Opcode::DEFINE, index, value);
+      break;
+    }
+
+    case NodeType::ASSIGNMENT: {
+      const auto& assignment = GetNode<Ast::Assignment>(component);
+      const int value = Allocate();
+      CompileExpression(*assignment.rvalue, value);
+      Emit(Opcode::STORE, assignment.lvalue->slot, value);
+      break;
+    }
+
+    case NodeType::INCREMENT:
+      EmitStep(*GetNode<Ast::Increment>(component).variable, 1);
+      break;
+    case NodeType::DECREMENT:
+      EmitStep(*GetNode<Ast::Increment>(component).variable, -1);
+      break;
+
+    case NodeType::BRANCH:  CompileBranch(GetNode<Ast::Branch>(component)); break;
+    case NodeType::REPEAT:  CompileRepeat(GetNode<Ast::Loop>(component)); break;
+    case NodeType::WHILE:   CompileWhile(GetNode<Ast::Loop>(component)); break;
+    case NodeType::FOREVER: CompileForever(GetNode<Ast::Loop>(component)); break;
+    case NodeType::FOREACH: CompileForeach(GetNode<Ast::Loop>(component)); break;
+    case NodeType::PARALLEL: // its body is run by its iterations, not compiled
+      bytecode.parallels.push_back(&GetNode<Ast::Parallel>(component));
+      Emit(Opcode::PARALLEL, bytecode.parallels.size() - 1);
+      break;
+
+    case NodeType::APPEND:
+    case NodeType::REMOVE: {
+      const bool append = component.type == NodeType::APPEND;
+      const auto& list = append ? GetNode<Ast::Append>(component).list : GetNode<Ast::Remove>(component).list;
+      const auto& operand = append ? GetNode<Ast::Append>(component).item : GetNode<Ast::Remove>(component).index;
+      if (list->type != NodeType::VARIABLE) { // todo: find a way to make `subscript` work here (mutating multidimensional arrays)
+        Fail("List operand must be a `variable`");
+        break;
+      }
+
+      const int value = Allocate();
+      CompileExpression(*operand, value);
+      Emit(append ? Opcode::APPEND : Opcode::REMOVE, GetNode<Ast::Variable>(*list).slot, value);
+      break;
+    }
+    case NodeType::SIZE: {
+      const int size = Allocate();
+      CompileExpression(component, size); // evaluated for its errors, the result is discarded
+      break;
+    }
+
+    case NodeType::DRAW_LINE:   CompileDraw(GetNode<Ast::Draw>(component), Opcode::DRAW_LINE, 4); break;
+    case NodeType::DRAW_RECT:   CompileDraw(GetNode<Ast::Draw>(component), Opcode::DRAW_RECT, 4); break;
+    case NodeType::DRAW_PIXEL:  CompileDraw(GetNode<Ast::Draw>(component), Opcode::DRAW_PIXEL, 2); break;
+    case NodeType::CLEAR_SCREEN: Emit(Opcode::CLEAR_SCREEN); break;
+
+    case NodeType::PRINT: {
+      const int value = Allocate();
+      CompileExpression(*GetNode<Ast::Print>(component).expression, value);
+      Emit(Opcode::PRINT, value);
+      break;
+    }
+    case NodeType::CLEAR_OUTPUT: Emit(Opcode::CLEAR_OUTPUT); break;
+
+    case NodeType::PROCEDURE: break; // compiled after the program
+    case NodeType::CALL:      CompileCall(GetNode<Ast::Call>(component)); break;
+    case NodeType::RETURN:    CompileReturn(GetNode<Ast::Return>(component)); break;
+
+    case NodeType::SCRIPT:    break; // compiled after the procedures
+    case NodeType::YIELD:     Emit(Opcode::YIELD); break;
+    case NodeType::WAIT: {
+      const int duration = Allocate();
+      CompileExpression(*GetNode<Ast::Wait>(component).duration, duration);
+      Emit(Opcode::WAIT, duration);
+      break;
+    }
+    case NodeType::WAIT_FRAME: Emit(Opcode::WAIT_FRAME); break;
+
+    default: Fail("Invalid TYPE provided for component: `" + component.key + "`"); break;
+  }
+
+  top = base;
+  source = parent;
+}
+
+void Compiler::CompileComponents(const Nodes& components) {
+  // `jump` and `conditional_jump` move relative to their statement, so resolve them once the block is laid out
+  const int count = components.size();
+  std::vector<int> starts;
+  std::vector<std::pair<int, int>> jumps; // instruction, target statement
+  starts.reserve(count + 1);
+
+  for (int i = 0; i < count; ++i) {
+    starts.push_back(Here());
+    const auto& component = *components[i];
+    if (component.type != NodeType::JUMP && component.type != NodeType::CONDITIONAL_JUMP) {
+      CompileComponent(component);
+      continue;
+    }
+
+    const Node* parent = source;
+    source = &component;
+    const auto& jump = GetNode<Ast::Jump>(component);
+    const int target = jump.expression->type == NodeType::LITERAL
+      ? i + 1 + GetNode<Ast::Literal>(*jump.expression).value.Get<int>()
+      : -1;
+
+    if (jump.expression->type != NodeType::LITERAL) Fail("Only literal JUMP distances can be compiled to bytecode!");
+    else if (target < 0 || target > count) Fail("JUMP operation out of range");
+    else if (jump.condition) {
+      for (const int at : CompileJump(*jump.condition, true)) jumps.emplace_back(at, target);
+    } else jumps.emplace_back(Emit(Opcode::JUMP), target);
+
+    source = parent;
+  }
+
+  starts.push_back(Here());
+  for (const auto& [at, target] : jumps) Patch(at, starts[target]);
+}
+
+// API //
+
+Bytecode Compiler::Compile(const AbstractSyntaxTree& program) {
+  bytecode = {};
+  top = 0;
+  source = nullptr;
+  procedure = nullptr;
+
+  bytecode.starts.push_back(Here());
+  CompileComponents(program.GetTree());
+  Emit(Opcode::END);
+
+  // each body returns without a value once it is exhausted
+  for (const auto& node : program.GetTree()) {
+    if (node->type != NodeType::PROCEDURE) continue;
+    procedure = &GetNode<Ast::Procedure>(*node);
+    if (procedure->index >= (int)bytecode.entries.size()) bytecode.entries.resize(procedure->index + 1);
+    bytecode.entries[procedure->index] = Here();
+
+    top = 0;
+    CompileComponents(procedure->components);
+    source = procedure;
+    Emit(Opcode::RETURN);
+    source = nullptr;
+  }
+  procedure = nullptr;
+
+  // each script finishes once its body is exhausted
+  for (const auto& node : program.GetTree()) {
+    if (node->type != NodeType::SCRIPT) continue;
+    const auto& script = GetNode<Ast::Script>(*node);
+    if (script.index >= (int)bytecode.starts.size()) bytecode.starts.resize(script.index + 1);
+    bytecode.starts[script.index] = Here();
+
+    top = 0;
+    CompileComponents(script.components);
+    source = &script;
+    Emit(Opcode::END);
+    source = nullptr;
+  }
+
+  return std::move(bytecode);
+}
@@ -0,0 +1,551 @@
+#include <jit.hpp>
+
+#if __JIT__
+
+#include <map>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+#include <sys/mman.h>
+
+#include <print.hpp>
+
+#endif // __JIT__
+
+// Trace //
+
+Jit::Trace::~Trace() {
+#if __JIT__
+  if (memory) munmap(memory, size);
+#endif // __JIT__
+}
+
+// API //
+
+void Jit::Reset(const int instructions) {
+  heat.assign(instructions, 0);
+  traces.clear();
+  traces.resize(instructions);
+}
+
+#if __JIT__
+
+// Assembly //
+
+enum Register : uint8_t { RAX = 0, RCX = 1, RDX = 2, RBX = 3, RSI = 6, RDI = 7 }; // scratch registers and bases without an index byte
+
+enum Condition : uint8_t { E = 0x4, NE = 0x5, S = 0x8, L = 0xC, GE = 0xD, LE = 0xE, G = 0xF };
+
+[[nodiscard]] static Condition GetCondition(const NodeType comparison) {
+  switch (comparison) {
+    case NodeType::EQ:  return E;
+    case NodeType::NE:  return NE;
+    case NodeType::GT:  return G;
+    case NodeType::GE:  return GE;
+    case NodeType::LT:  return L;
+    default:            return LE;
+  }
+}
+
+// Encodes the few x86-64 instructions compiled loops are made of; memory operands are `[base + displacement]`
+class Assembler final {
+private:
+  std::vector<uint8_t> code;
+
+  inline void Memory(const uint8_t reg, const Register base, const int32_t displacement) {
+    Byte(0x80 | (reg & 7) << 3 | base); // 32 bit displacement
+    Dword(displacement);
+  }
+public:
+  [[nodiscard]] inline int Here() const { return code.size(); }
+  [[nodiscard]] inline const std::vector<uint8_t>& GetCode() const { return code; }
+
+  inline void Byte(const uint8_t byte) { code.push_back(byte); }
+  inline void Bytes(std::initializer_list<uint8_t> bytes) { code.insert(code.end(), bytes); }
+  inline void Dword(const int32_t dword) { for (int i = 0; i < 4; ++i) Byte(dword >> i * 8); }
+  inline void Qword(const uint64_t qword) { for (int i = 0; i < 8; ++i) Byte(qword >> i * 8); }
+
+  // Moves //
+
+  inline void Load32(const Register to, const Register base, const int32_t at) { Byte(0x8B); Memory(to, base, at); }
+  inline void Store32(const Register base, const int32_t at, const Register from) { Byte(0x89); Memory(from, base, at); }
+  inline void Load64(const Register to, const Register base, const int32_t at) { Bytes({ 0x48, 0x8B }); Memory(to, base, at); }
+  inline void Store64(const Register base, const int32_t at, const Register from) { Bytes({ 0x48, 0x89 }); Memory(from, base, at); }
+  inline void Load8(const Register to, const Register base, const int32_t at) { Byte(0x8A); Memory(to, base, at); }
+  inline void Store8(const Register base, const int32_t at, const Register from) { Byte(0x88); Memory(from, base, at); }
+  inline void Store8(const Register base, const int32_t at, const uint8_t value) { Byte(0xC6); Memory(0, base, at); Byte(value); }
+  inline void Store32(const Register base, const int32_t at, const int32_t value) { Byte(0xC7); Memory(0, base, at); Dword(value); }
+  inline void Move32(const Register to, const int32_t value) { Byte(0xB8 + to); Dword(value); }
+  inline void Move64(const Register to, const uint64_t value) { Bytes({ 0x48, (uint8_t)(0xB8 + to) }); Qword(value); }
+
+  // Arithmetic //
+
+  inline void Add32(const Register to, const Register base, const int32_t at) { Byte(0x03); Memory(to, base, at); }
+  inline void Subtract32(const Register to, const Register base, const int32_t at) { Byte(0x2B); Memory(to, base, at); }
+  inline void Multiply32(const Register to, const Register base, const int32_t at) { Bytes({ 0x0F, 0xAF }); Memory(to, base, at); }
+  inline void Divide32(const Register base, const int32_t at) { Byte(0x99); Byte(0xF7); Memory(7, base, at); } // edx:eax / [at], sign extending eax
+  inline void Add32(const Register base, const int32_t at, const int32_t value) { Byte(0x81); Memory(0, base, at); Dword(value); }
+  inline void Increment32(const Register reg) { Bytes({ 0x83, (uint8_t)(0xC0 + reg), 0x01 }); }
+  inline void And8(const Register to, const Register base, const int32_t at) { Byte(0x22); Memory(to, base, at); }
+  inline void Or8(const Register to, const Register base, const int32_t at) { Byte(0x0A); Memory(to, base, at); }
+  inline void Xor8(const Register to, const Register base, const int32_t at) { Byte(0x32); Memory(to, base, at); }
+  inline void Not8() { Bytes({ 0x34, 0x01 }); } // of a boolean in `al`
+
+  // Comparisons //
+
+  inline void Compare32(const Register left, const Register base, const int32_t at) { Byte(0x3B); Memory(left, base, at); }
+  inline void Compare32(const Register left, const int32_t value) { Byte(0x81); Byte(0xF8 + left); Dword(value); }
+  inline void Compare8(const Register base, const int32_t at, const uint8_t value) { Byte(0x80); Memory(7, base, at); Byte(value); }
+  inline void Test32(const Register reg) { Byte(0x85); Byte(0xC0 | reg << 3 | reg); }
+  inline void Select32(const Condition condition, const Register to, const Register base, const int32_t at) { Bytes({ 0x0F, (uint8_t)(0x40 + condition) }); Memory(to, base, at); }
+  inline void Set8(const Condition condition, const Register to) { Bytes({ 0x0F, (uint8_t)(0x90 + condition), (uint8_t)(0xC0 + to) }); }
+
+  // Control Flow //
+
+  // Jumps return where their displacement is patched
+  [[nodiscard]] inline int Jump() { Byte(0xE9); Dword(0); return Here() - 4; }
+  [[nodiscard]] inline int Jump(const Condition condition) { Bytes({ 0x0F, (uint8_t)(0x80 + condition) }); Dword(0); return Here() - 4; }
+  inline void Patch(const int at, const int target) {
+    const int32_t displacement = target - (at + 4);
+    std::memcpy(code.data() + at, &displacement, sizeof displacement);
+  }
+  inline void Call(const uint64_t function) { Move64(RAX, function); Bytes({ 0xFF, 0xD0 }); }
+
+  // Frame //
+
+  // rbx holds the registers, r12 the fuel, r13 where the fuel is returned; three pushes keep calls aligned
+  inline void Prologue() {
+    Bytes({ 0x53, 0x41, 0x54, 0x41, 0x55 });  // push rbx; push r12; push r13
+    Bytes({ 0x48, 0x89, 0xFB });              // mov rbx, rdi
+    Bytes({ 0x49, 0x89, 0xF5 });              // mov r13, rsi
+    Bytes({ 0x4D, 0x8B, 0x65, 0x00 });        // mov r12, [r13]
+  }
+  inline void Epilogue() {
+    Bytes({ 0x4D, 0x89, 0x65, 0x00 });        // mov [r13], r12
+    Bytes({ 0x41, 0x5D, 0x41, 0x5C, 0x5B });  // pop r13; pop r12; pop rbx
+    Byte(0xC3);                               // ret
+  }
+  inline void Spend(const int32_t fuel) { Bytes({ 0x49, 0x81, 0xEC }); Dword(fuel); } // sub r12, fuel
+};
+
+// Helpers //
+
+// The instruction a jump may continue at, `-1` for other instructions
+[[nodiscard]] static int GetTarget(const Instruction& instruction) {
+  switch (instruction.op) {
+    case Opcode::JUMP:                  return instruction.a;
+    case Opcode::JUMP_IF:
+    case Opcode::JUMP_UNLESS:           return instruction.b;
+    case Opcode::JUMP_COMPARE:
+    case Opcode::JUMP_COMPARE_INTEGER:
+    case Opcode::LOOP:
+    case Opcode::JUMP_COMPARE_OPERANDS:
+    case Opcode::JUMP_COMPARE_INTEGER_OPERANDS: return instruction.c;
+    default:                            return -1;
+  }
+}
+
+// The instructions after a superinstruction that it fused, which the interpreter skips instead of running
+[[nodiscard]] static int GetFused(const Instruction& instruction) {
+  switch (instruction.op) {
+    case Opcode::LOOP:                  return 1;
+    case Opcode::JUMP_COMPARE_OPERANDS:
+    case Opcode::JUMP_COMPARE_INTEGER_OPERANDS: return 2;
+    case Opcode::DRAW_OPERANDS:         return instruction.b;
+    default:                            return 0;
+  }
+}
+
+// Compilation //
+
+Jit::Trace* Jit::Compile(const Bytecode& bytecode, const int head, VariableStore& store, Helper helper, MachinePtr machine) {
+  static_assert(sizeof(Value) == 16 && offsetof(Value, type) == 0 && offsetof(Value, bits) == 8, "Compiled code copies values as two quadwords");
+  constexpr int TYPE = offsetof(Value, type);
+  constexpr int PAYLOAD = offsetof(Value, bits);
+  constexpr auto INTEGER = static_cast<uint8_t>(Value::Type::INTEGER);
+  constexpr auto DOUBLE = static_cast<uint8_t>(Value::Type::DOUBLE);
+  constexpr auto BOOLEAN = static_cast<uint8_t>(Value::Type::BOOLEAN);
+
+  const auto& code = bytecode.code;
+
+  // the loop runs from its head to the last jump back to it
+  int end = -1;
+  for (int at = head; at < (int)code.size(); ++at)
+    if (GetTarget(code[at]) == head) end = at;
+  if (end < 0) {
+    heat[head] = COLD;
+    return nullptr;
+  }
+
+  auto trace = std::make_unique<Trace>();
+  Assembler assembler;
+  std::vector<int> starts(end - head + 1);
+  std::vector<std::pair<int, int>> forwards, loops, exits; // jumps to patch, and the instruction they continue at
+
+  const auto type = [](const int reg) { return reg * (int)sizeof(Value) + TYPE; };
+  const auto payload = [](const int reg) { return reg * (int)sizeof(Value) + PAYLOAD; };
+  const auto touch = [&trace](const int reg) { trace->registers.push_back(reg); };
+
+  // compiled code reads variables in place, so each must be defined before the loop is compiled
+  bool postponed = false, framed = false;
+  const auto variable = [&](const int slot) -> uint64_t {
+    if (store.IsLocal(slot)) { // moves with the frame of each call
+      framed = true;
+      return 0;
+    }
+    if (!store.IsDefined(slot)) {
+      postponed = true;
+      return 0;
+    }
+    trace->slots.push_back(slot);
+    return reinterpret_cast<uint64_t>(&store.Edit(slot));
+  };
+
+  // continue at `target` from the instruction `from`: jumps back to the loop spend fuel, jumps out of it leave for the interpreter
+  const auto branch = [&](const int jump, const int from, const int target) {
+    if (target < head || target > end) exits.emplace_back(jump, target);
+    else if (target <= from) loops.emplace_back(jump, target);
+    else forwards.emplace_back(jump, target);
+  };
+  const auto leave = [&](const int at) { exits.emplace_back(assembler.Jump(), at); };
+  const auto call = [&](const int at) {
+    assembler.Move64(RDI, reinterpret_cast<uint64_t>(machine));
+    assembler.Move32(RSI, at);
+    assembler.Call(reinterpret_cast<uint64_t>(helper));
+    assembler.Test32(RAX);
+    exits.emplace_back(assembler.Jump(S), at); // failed, the interpreter runs it again to report the error
+  };
+  const auto storeBoolean = [&](const int reg) {
+    assembler.Store8(RBX, payload(reg), RAX);
+    assembler.Store8(RBX, type(reg), BOOLEAN);
+  };
+  const auto storeInteger = [&](const int reg, const Register from) {
+    assembler.Store32(RBX, payload(reg), from);
+    assembler.Store8(RBX, type(reg), INTEGER);
+  };
+  const auto guardBoolean = [&](const int reg, const int at) {
+    assembler.Compare8(RBX, type(reg), BOOLEAN);
+    exits.emplace_back(assembler.Jump(NE), at);
+  };
+  // an operand of a superinstruction into `eax`
+  const auto loadOperand = [&](const int operand) {
+    if (IsConstantOperand(operand)) assembler.Move32(RAX, bytecode.constants[GetConstantIndex(operand)].As<int>());
+    else {
+      assembler.Move64(RSI, variable(operand));
+      assembler.Load32(RAX, RSI, PAYLOAD);
+    }
+  };
+  const auto compareOperand = [&](const int operand) {
+    if (IsConstantOperand(operand)) assembler.Compare32(RAX, bytecode.constants[GetConstantIndex(operand)].As<int>());
+    else {
+      assembler.Move64(RSI, variable(operand));
+      assembler.Compare32(RAX, RSI, PAYLOAD);
+    }
+  };
+
+  assembler.Prologue();
+  bool native = false; // the head is compiled, the loop makes progress before leaving
+
+  for (int at = head; at <= end; ++at) {
+    starts[at - head] = assembler.Here();
+    const auto& instruction = code[at];
+    const int a = instruction.a;
+    const int b = instruction.b;
+    const int c = instruction.c;
+    bool supported = true;
+
+    switch (instruction.op) {
+      // Values //
+      case Opcode::LOAD_CONSTANT: {
+        const auto& constant = bytecode.constants[b];
+        if (constant.Is<int>()) {
+          assembler.Store32(RBX, payload(a), constant.As<int>());
+          assembler.Store8(RBX, type(a), INTEGER);
+        } else if (constant.Is<bool>()) {
+          assembler.Store8(RBX, payload(a), (uint8_t)constant.As<bool>());
+          assembler.Store8(RBX, type(a), BOOLEAN);
+        } else if (constant.Is<double>()) {
+          assembler.Move64(RAX, constant.bits);
+          assembler.Store64(RBX, payload(a), RAX);
+          assembler.Store8(RBX, type(a), DOUBLE);
+        } else {
+          supported = false;
+          break;
+        }
+        touch(a);
+        break;
+      }
+      case Opcode::LOAD:
+        assembler.Move64(RSI, variable(b));
+        assembler.Load64(RAX, RSI, 0);
+        assembler.Store64(RBX, type(a), RAX);
+        assembler.Load64(RAX, RSI, PAYLOAD);
+        assembler.Store64(RBX, payload(a), RAX);
+        touch(a);
+        break;
+      case Opcode::STORE:
+        assembler.Move64(RSI, variable(a));
+        assembler.Load64(RAX, RBX, type(b));
+        assembler.Store64(RSI, 0, RAX);
+        assembler.Load64(RAX, RBX, payload(b));
+        assembler.Store64(RSI, PAYLOAD, RAX);
+        touch(b);
+        break;
+      case Opcode::DEFINE:
+      case Opcode::DEFINE_DEFAULT:
+        (void)variable(bytecode.definitions[a]->slot); // defined before entering, so definitions change nothing
+        break;
+      case Opcode::INCREMENT_INTEGER:
+        assembler.Move64(RSI, variable(a));
+        assembler.Add32(RSI, PAYLOAD, b);
+        break;
+
+      // Arithmetic //
+      case Opcode::ADD:
+      case Opcode::SUBTRACT:
+      case Opcode::MULTIPLY:
+        assembler.Load32(RAX, RBX, payload(b));
+        if (instruction.op == Opcode::ADD) assembler.Add32(RAX, RBX, payload(c));
+        else if (instruction.op == Opcode::SUBTRACT) assembler.Subtract32(RAX, RBX, payload(c));
+        else assembler.Multiply32(RAX, RBX, payload(c));
+        storeInteger(a, RAX);
+        touch(a), touch(b), touch(c);
+        break;
+      case Opcode::DIVIDE:
+      case Opcode::MODULO:
+        assembler.Load32(RAX, RBX, payload(b));
+        assembler.Divide32(RBX, payload(c));
+        storeInteger(a, instruction.op == Opcode::DIVIDE ? RAX : RDX);
+        touch(a), touch(b), touch(c);
+        break;
+      case Opcode::MIN:
+      case Opcode::MAX:
+        assembler.Load32(RAX, RBX, payload(b));
+        assembler.Compare32(RAX, RBX, payload(c));
+        assembler.Select32(instruction.op == Opcode::MIN ? G : L, RAX, RBX, payload(c));
+        storeInteger(a, RAX);
+        touch(a), touch(b), touch(c);
+        break;
+
+      // Conditions //
+      case Opcode::COMPARE_INTEGER:
+        assembler.Load32(RAX, RBX, payload(b));
+        assembler.Compare32(RAX, RBX, payload(c));
+        assembler.Set8(GetCondition(instruction.operation), RAX);
+        storeBoolean(a);
+        touch(a), touch(b), touch(c);
+        break;
+      case Opcode::AND:
+      case Opcode::OR:
+      case Opcode::XOR:
+        guardBoolean(b, at);
+        guardBoolean(c, at);
+        assembler.Load8(RAX, RBX, payload(b));
+        if (instruction.op == Opcode::AND) assembler.And8(RAX, RBX, payload(c));
+        else if (instruction.op == Opcode::OR) assembler.Or8(RAX, RBX, payload(c));
+        else assembler.Xor8(RAX, RBX, payload(c));
+        storeBoolean(a);
+        touch(a), touch(b), touch(c);
+        break;
+      case Opcode::NOT:
+        guardBoolean(b, at);
+        assembler.Load8(RAX, RBX, payload(b));
+        assembler.Not8();
+        storeBoolean(a);
+        touch(a), touch(b);
+        break;
+
+      // Control Flow //
+      case Opcode::JUMP: branch(assembler.Jump(), at, a); break;
+      case Opcode::JUMP_IF:
+      case Opcode::JUMP_UNLESS:
+        guardBoolean(a, at);
+        assembler.Compare8(RBX, payload(a), 0);
+        branch(assembler.Jump(instruction.op == Opcode::JUMP_IF ? NE : E), at, b);
+        touch(a);
+        break;
+      case Opcode::JUMP_COMPARE_INTEGER:
+        assembler.Load32(RAX, RBX, payload(a));
+        assembler.Compare32(RAX, RBX, payload(b));
+        branch(assembler.Jump(GetCondition(instruction.operation)), at, c);
+        touch(a), touch(b);
+        break;
+      case Opcode::STEP:
+        assembler.Add32(RBX, payload(a), 1);
+        touch(a);
+        break;
+
+      // Superinstructions //
+      case Opcode::LOOP:
+        assembler.Load32(RAX, RBX, payload(a));
+        assembler.Increment32(RAX);
+        assembler.Store32(RBX, payload(a), RAX);
+        assembler.Compare32(RAX, RBX, payload(b));
+        branch(assembler.Jump(L), at, c);
+        branch(assembler.Jump(), at, at + 2);
+        touch(a), touch(b);
+        break;
+      case Opcode::JUMP_COMPARE_INTEGER_OPERANDS:
+        loadOperand(a);
+        compareOperand(b);
+        branch(assembler.Jump(GetCondition(instruction.operation)), at, c);
+        branch(assembler.Jump(), at, at + 3);
+        break;
+
+      // the interpreter runs anything else that reads or writes no strings or lists
+      case Opcode::REPEAT:
+      case Opcode::PROMOTE:
+        call(at);
+        touch(a);
+        break;
+      case Opcode::MATH:
+        call(at);
+        touch(a), touch(b);
+        break;
+      case Opcode::EXPONENT:
+      case Opcode::RANDOM:
+      case Opcode::NUMERIC:
+      case Opcode::REAL:
+      case Opcode::EQ:
+      case Opcode::NE:
+      case Opcode::GT:
+      case Opcode::GE:
+      case Opcode::LT:
+      case Opcode::LE:
+        call(at);
+        touch(a), touch(b), touch(c);
+        break;
+      case Opcode::INCREMENT:
+      case Opcode::DECREMENT:
+        (void)variable(a);
+        call(at);
+        break;
+      case Opcode::DRAW_LINE:
+      case Opcode::DRAW_RECT:
+      case Opcode::DRAW_PIXEL:
+        call(at);
+        for (int i = 0; i < (instruction.op == Opcode::DRAW_PIXEL ? 2 : 4); ++i) touch(a + i);
+        break;
+      case Opcode::DRAW_OPERANDS:
+        call(at);
+        for (int i = 0; i < b; ++i)
+          if (const int operand = bytecode.operands[a + i]; !IsConstantOperand(operand)) (void)variable(operand);
+        branch(assembler.Jump(), at, at + 1 + b);
+        break;
+      case Opcode::PRINT:
+        call(at);
+        touch(a);
+        break;
+      case Opcode::CLEAR_SCREEN:
+      case Opcode::CLEAR_OUTPUT:
+        call(at);
+        break;
+      case Opcode::JUMP_COMPARE:
+      case Opcode::JUMP_COMPARE_OPERANDS: {
+        call(at); // returns where it continues
+        assembler.Compare32(RAX, c);
+        branch(assembler.Jump(E), at, c);
+        branch(assembler.Jump(), at, at + (instruction.op == Opcode::JUMP_COMPARE ? 1 : 3));
+        if (instruction.op == Opcode::JUMP_COMPARE) touch(a), touch(b);
+        else for (const int operand : { a, b }) if (!IsConstantOperand(operand)) (void)variable(operand);
+        break;
+      }
+
+      default: supported = false; break; // lists, strings, and halting
+    }
+
+    if (!supported) leave(at);
+    if (at == head) native = supported;
+  }
+  branch(assembler.Jump(), end, end + 1); // the loop is left by falling through its last instruction
+
+  if (framed) {
+    heat[head] = COLD;
+    return nullptr;
+  }
+  if (postponed) { // a variable is not yet defined, try again later
+    heat[head] = 0;
+    return nullptr;
+  }
+  if (!native) {
+    heat[head] = COLD;
+    return nullptr;
+  }
+
+  // jumps back to the loop spend the fuel of an iteration, the instructions the interpreter would have run, returning to it once the fuel is spent
+  std::map<int, int> backEdges;
+  for (const auto& [jump, target] : loops) {
+    auto [it, inserted] = backEdges.try_emplace(target, assembler.Here());
+    if (inserted) {
+      int iteration = 0;
+      for (int at = target; at <= end; at += 1 + GetFused(code[at])) ++iteration;
+      assembler.Spend(iteration);
+      exits.emplace_back(assembler.Jump(LE), target);
+      assembler.Patch(assembler.Jump(), starts[target - head]);
+    }
+    assembler.Patch(jump, it->second);
+  }
+  for (const auto& [jump, target] : forwards) assembler.Patch(jump, starts[target - head]);
+
+  // each exit returns the pc to resume interpreting at
+  std::map<int, int> stubs;
+  std::vector<int> epilogue;
+  for (const auto& [jump, target] : exits) {
+    auto [it, inserted] = stubs.try_emplace(target, assembler.Here());
+    if (inserted) {
+      assembler.Move32(RAX, target);
+      epilogue.push_back(assembler.Jump());
+    }
+    assembler.Patch(jump, it->second);
+  }
+  for (const int jump : epilogue) assembler.Patch(jump, assembler.Here());
+  assembler.Epilogue();
+
+  // map the code executable
+  const auto& machineCode = assembler.GetCode();
+  trace->size = machineCode.size();
+  void* memory = mmap(nullptr, trace->size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (memory == MAP_FAILED) {
+    heat[head] = COLD;
+    return nullptr;
+  }
+  trace->memory = memory;
+  std::memcpy(memory, machineCode.data(), trace->size);
+  if (mprotect(memory, trace->size, PROT_READ | PROT_EXEC) != 0) {
+    heat[head] = COLD;
+    return nullptr;
+  }
+  trace->entry = reinterpret_cast<Entry>(memory);
+
+  for (auto* accessed : { &trace->registers, &trace->slots }) {
+    std::sort(accessed->begin(), accessed->end());
+    accessed->erase(std::unique(accessed->begin(), accessed->end()), accessed->end());
+  }
+
+  const auto* source = bytecode.sources[head];
+  Log("Compiled loop at " + std::to_string(head) + (source ? " for block `" + source->key + "`" : "") + " to " + std::to_string(trace->size) + " bytes");
+
+  traces[head] = std::move(trace);
+  return traces[head].get();
+}
+
+bool Jit::Enter(const int head, const Value* registers, const VariableStore& store) {
+  auto& trace = *traces[head];
+  bool enterable = true;
+  for (const int reg : trace.registers) enterable = enterable && !registers[reg].GetObject();
+  for (const int slot : trace.slots) enterable = enterable && store.IsDefined(slot) && !store.Get(slot).Get().GetObject();
+
+  if (enterable) {
+    trace.refusals = 0;
+    return true;
+  }
+
+  // the loop keeps strings or lists where it was compiled for numbers
+  if (++trace.refusals > MAX_REFUSALS) {
+    traces[head].reset();
+    heat[head] = COLD;
+  }
+  return false;
+}
+
+#endif // __JIT__
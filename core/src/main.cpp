@@ -2,6 +2,8 @@
 
 #include <SDL2.hpp>
 #include <string>
+#include <climits>
+#include <algorithm>
 #include <runtime.hpp>
 #include <file.hpp>
 
@@ -11,9 +13,22 @@
 #endif // __EMSCRIPTEN__
 
 constexpr int MIN_CMD_ARGS = 2;
-constexpr int MAX_CMD_ARGS = 2;
+constexpr int MAX_CMD_ARGS = 13;
 constexpr int PROGRAM_NAME_ARG = 0;
-constexpr int PROGRAM_FILE_ARG = 1;
+constexpr int FIRST_OPTION_ARG = 1;
+
+constexpr std::string_view ENGINE_OPTION = "--engine=";
+constexpr std::string_view NO_OPTIMIZE_OPTION = "--no-optimize";
+constexpr std::string_view TRACE_OPTION = "--trace";
+constexpr std::string_view TRANSPILE_OPTION = "--transpile=";
+constexpr std::string_view NO_JIT_OPTION = "--no-jit";
+constexpr std::string_view MEMOIZE_OPTION = "--memoize";
+constexpr std::string_view DETERMINISTIC_OPTION = "--deterministic";
+constexpr std::string_view MAX_INSTRUCTIONS_OPTION = "--max-instructions=";
+constexpr std::string_view MAX_TIME_OPTION = "--max-time=";
+constexpr std::string_view MAX_MEMORY_OPTION = "--max-memory=";
+constexpr std::string_view MAX_LIST_OPTION = "--max-list=";
+constexpr std::string_view MAX_OUTPUT_OPTION = "--max-output=";
 
 Runtime runtime;
 
@@ -29,17 +44,71 @@ int main(int argc, char* argv[]) {
 
 #else
 
-    if (argc < MIN_CMD_ARGS) {
-        const auto executable = std::filesystem::path{argv[PROGRAM_NAME_ARG]};
-        std::cout << "Usage: " << executable.filename() << " <file>\n";
+    const auto executable = std::filesystem::path{argv[PROGRAM_NAME_ARG]};
+    const auto usage = [&]() {
+        std::cout << "Usage: " << executable.filename() << " [--engine=tree|bytecode] [--no-optimize] [--no-jit] [--memoize] [--deterministic] [--max-instructions=<n>] [--max-time=<ms>] [--max-memory=<bytes>] [--max-list=<n>] [--max-output=<n>] [--trace] [--transpile=<output>] <file>\n";
         return EXIT_FAILURE;
+    };
+    if (argc < MIN_CMD_ARGS || argc > MAX_CMD_ARGS) return usage();
+
+    std::filesystem::path filepath, transpiled;
+    Governor::Quotas quotas;
+
+    // a quota is a whole number, 0 for unlimited
+    const auto quota = [](const std::string_view argument, const std::string_view option) {
+        const std::string value{argument.substr(option.size())};
+        const auto invalid = std::invalid_argument("Invalid quota `" + value + "`; expected a whole number, 0 for unlimited");
+        size_t parsed = 0;
+        long long quota = 0;
+        try {
+            quota = std::stoll(value, &parsed);
+        } catch (const std::logic_error&) { // not a number, or out of range
+            throw invalid;
+        }
+        if (parsed != value.size() || quota < 0) throw invalid;
+        return quota;
+    }; // throws `std::invalid_argument`
+
+    try {
+        for (int i = FIRST_OPTION_ARG; i < argc; ++i) {
+            const std::string_view argument{argv[i]};
+            if (argument.starts_with(ENGINE_OPTION)) runtime.SetEngine(Runtime::ParseEngine(std::string{argument.substr(ENGINE_OPTION.size())}));
+            else if (argument == NO_OPTIMIZE_OPTION) runtime.SetOptimize(false);
+            else if (argument == NO_JIT_OPTION) runtime.SetTiered(false);
+            else if (argument == MEMOIZE_OPTION) runtime.SetMemoize(true);
+            else if (argument == DETERMINISTIC_OPTION) runtime.SetDeterministic(true);
+            else if (argument.starts_with(MAX_INSTRUCTIONS_OPTION)) quotas.instructions = quota(argument, MAX_INSTRUCTIONS_OPTION);
+            else if (argument.starts_with(MAX_TIME_OPTION)) quotas.time = std::chrono::milliseconds{quota(argument, MAX_TIME_OPTION)};
+            else if (argument.starts_with(MAX_MEMORY_OPTION)) quotas.memory = quota(argument, MAX_MEMORY_OPTION);
+            else if (argument.starts_with(MAX_LIST_OPTION)) quotas.list = (int)std::min<long long>(quota(argument, MAX_LIST_OPTION), INT_MAX);
+            else if (argument.starts_with(MAX_OUTPUT_OPTION)) quotas.output = quota(argument, MAX_OUTPUT_OPTION);
+            else if (argument == TRACE_OPTION) runtime.SetTrace(true);
+            else if (argument.starts_with(TRANSPILE_OPTION)) transpiled = argument.substr(TRANSPILE_OPTION.size());
+            else filepath = argument;
+        }
+    } catch (const std::exception& e) { // an unknown engine or a malformed quota
+        std::cerr << e.what() << '\n';
+        return usage();
     }
+    if (filepath.empty()) return usage();
 
-    const auto filepath = std::filesystem::path{argv[PROGRAM_FILE_ARG]};
     const auto program = readFile(filepath);
 
+    // write the program as C++ instead of running it
+    if (!transpiled.empty()) {
+        try {
+            std::ofstream{transpiled} << runtime.Transpile(program);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << '\n';
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+
+    runtime.SetQuotas(quotas);
     runtime.Load(program);
     runtime.Run();
+    if (runtime.GetStopReason() != Governor::Reason::NONE) return EXIT_FAILURE;
 
 #endif // __EMSCRIPTEN__
 
@@ -70,6 +139,45 @@ std::string getScaleQuality() {
     return runtime.GetScaleQuality() == Renderer::ScaleQuality::nearest ? "nearest" : "linear";
 }
 
+void setEngine(std::string engine) {
+    runtime.SetEngine(Runtime::ParseEngine(engine));
+}
+std::string getEngine() {
+    return runtime.GetEngine() == Runtime::Engine::bytecode ? "bytecode" : "tree";
+}
+
+void setOptimize(bool optimize) {
+    runtime.SetOptimize(optimize);
+}
+bool getOptimize() {
+    return runtime.GetOptimize();
+}
+
+void setMemoize(bool memoize) {
+    runtime.SetMemoize(memoize);
+}
+bool getMemoize() {
+    return runtime.GetMemoize();
+}
+
+void setDeterministic(bool deterministic) {
+    runtime.SetDeterministic(deterministic);
+}
+bool getDeterministic() {
+    return runtime.GetDeterministic();
+}
+
+// quotas of 0 are unlimited, numbers are doubles as JavaScript's
+void setQuotas(double instructions, double time, double memory, int list, double output) {
+    runtime.SetQuotas({ (long long)instructions, std::chrono::milliseconds{(long long)time}, (long long)memory, list, (long long)output });
+}
+void cancel() {
+    runtime.Cancel(); // the program stops with `cancelled` at its next batch
+}
+std::string getStopReason() {
+    return Governor::GetReasonName(runtime.GetStopReason());
+}
+
 int getCanvasWidth() {
     const auto w = runtime.GetCanvasResolution().x;
     return w;
@@ -99,6 +207,22 @@ EMSCRIPTEN_BINDINGS(parser) {
 
     emscripten::function("GetScaleQuality", &getScaleQuality);
     emscripten::function("SetScaleQuality", &setScaleQuality);
+
+    emscripten::function("GetEngine", &getEngine);
+    emscripten::function("SetEngine", &setEngine);
+
+    emscripten::function("GetOptimize", &getOptimize);
+    emscripten::function("SetOptimize", &setOptimize);
+
+    emscripten::function("GetMemoize", &getMemoize);
+    emscripten::function("SetMemoize", &setMemoize);
+
+    emscripten::function("GetDeterministic", &getDeterministic);
+    emscripten::function("SetDeterministic", &setDeterministic);
+
+    emscripten::function("SetQuotas", &setQuotas);
+    emscripten::function("Cancel", &cancel);
+    emscripten::function("GetStopReason", &getStopReason);
 }
 
 #endif // __EMSCRIPTEN__
@@ -0,0 +1,1025 @@
+#include <optimizer.hpp>
+#include <typeInference.hpp>
+#include <kernel.hpp>
+#include <print.hpp>
+
+#include <algorithm>
+
+static constexpr int MAX_REPEAT_LENGTH = 2048;
+
+// Helpers //
+
+bool Optimizer::IsLiteral(const NodePtr& expression) {
+  return expression && expression->type == NodeType::LITERAL;
+}
+
+static bool HasJumps(const Nodes& components) {
+  for (const auto& component : components)
+    if (component->type == NodeType::JUMP || component->type == NodeType::CONDITIONAL_JUMP) return true;
+  return false;
+}
+
+// Can every jump in `components` be re-targeted; only literal distances are known before execution
+static bool IsRelocatable(const Nodes& components) {
+  for (const auto& component : components)
+    if ((component->type == NodeType::JUMP || component->type == NodeType::CONDITIONAL_JUMP)
+      && GetNode<Ast::Jump>(*component).expression->type != NodeType::LITERAL) return false;
+  return true;
+}
+
+// Lay out the statements each of `components` is replaced with by `lay`, re-targeting jumps to where their target now starts; `components` must be relocatable
+template<typename F>
+static void Layout(Nodes& components, F&& lay) {
+  // lay out the body, recording where each original statement now starts
+  const int count = components.size();
+  Nodes laid;
+  std::vector<int> starts;
+  laid.reserve(count);
+  starts.reserve(count + 1);
+
+  for (int i = 0; i < count; ++i) {
+    starts.push_back(laid.size());
+    lay(i, laid);
+  }
+  starts.push_back(laid.size());
+
+  // re-target jumps; a jump lands after itself plus its distance, out of range jumps stay out of range
+  const int size = laid.size();
+  for (int i = 0; i < count; ++i) {
+    const auto& component = components[i];
+    if (component->type != NodeType::JUMP && component->type != NodeType::CONDITIONAL_JUMP) continue;
+
+    auto& jump = GetNode<Ast::Jump>(*component);
+    const auto& distance = GetNode<Ast::Literal>(*jump.expression).value;
+    if (!distance.Is<int>()) continue;
+
+    const int target = i + 1 + distance.Get<int>();
+    const int relocated = target < 0 ? target : target > count ? size + target - count : starts[target];
+    const int moved = relocated - (starts[i] + 1);
+    if (moved != distance.Get<int>()) jump.expression = std::make_shared<Ast::Literal>(jump.expression->key, moved);
+  }
+
+  components = std::move(laid);
+}
+
+// Folding //
+
+bool Optimizer::Fold(NodePtr& expression) {
+  const auto type = expression->type;
+  if (!IsOperation(type) && !IsCondition(type)) return false;
+
+  const auto& operation = GetNode<Ast::Operation>(*expression);
+  const bool unary = IsUnaryOperation(type) || type == NodeType::NOT;
+  if (!IsLiteral(operation.left) || (!unary && !IsLiteral(operation.right))) return false;
+
+  const auto& left = GetLiteral(operation.left);
+  const auto& right = unary ? left : GetLiteral(operation.right);
+  Value result;
+
+  if (IsOperation(type)) {
+    if (type == NodeType::RANDOM) return false; // differs each evaluation
+    if (!left.IsNumber() || !right.IsNumber()) return false; // leave type errors to runtime
+    if ((type == NodeType::DIVIDE || type == NodeType::MODULO) && !unary && right.GetNumber<double>() == 0) return false;
+
+    result = Kernel::Arithmetic(type, left, right);
+  } else if (type == NodeType::NOT || type == NodeType::AND || type == NodeType::OR || type == NodeType::XOR) {
+    if (!left.Is<bool>() || !right.Is<bool>()) return false;
+
+    const bool a = left.Get<bool>();
+    const bool b = right.Get<bool>();
+    if (type == NodeType::NOT) result = !a;
+    else if (type == NodeType::AND) result = a && b;
+    else if (type == NodeType::OR) result = a || b;
+    else result = a != b;
+  } else result = Kernel::Compare(type, left, right);
+
+  expression = std::make_shared<Ast::Literal>(expression->key, std::move(result));
+  ++report.folded;
+  return true;
+}
+
+void Optimizer::OptimizeExpression(NodePtr& expression) {
+  VisitChildren(*expression,
+    [this](NodePtr& child) { OptimizeExpression(child); },
+    [this](Nodes& body) { OptimizeComponents(body); }
+  );
+  (void)Fold(expression);
+}
+
+// Statements //
+
+bool Optimizer::IsEmpty(const Node& component) {
+  switch (component.type) {
+    case NodeType::REPEAT: {
+      const auto& repeat = GetNode<Ast::Loop>(component);
+      if (!repeat.components.empty() || !IsLiteral(repeat.expression)) return false;
+
+      const auto& times = GetLiteral(repeat.expression);
+      return times.Is<int>() && times.Get<int>() >= 0 && times.Get<int>() <= MAX_REPEAT_LENGTH; // out of range repeats still throw
+    }
+    case NodeType::WHILE: {
+      const auto& loop = GetNode<Ast::Loop>(component);
+      return loop.components.empty() && IsLiteral(loop.expression) && GetLiteral(loop.expression) == Value{false};
+    }
+    default: return false;
+  }
+}
+
+const Nodes* Optimizer::Inline(const NodePtr& component) {
+  static const Nodes NOTHING{};
+
+  if (component->type == NodeType::COMMENT) {
+    ++report.comments;
+    return &NOTHING;
+  }
+
+  if (IsEmpty(*component)) {
+    ++report.bodies;
+    return &NOTHING;
+  }
+
+  if (component->type == NodeType::BRANCH) {
+    const auto& branch = GetNode<Ast::Branch>(*component);
+    if (!IsLiteral(branch.condition) || !GetLiteral(branch.condition).Is<bool>()) return nullptr;
+
+    const auto& taken = GetLiteral(branch.condition).Get<bool>() ? branch.consequent : branch.alternative;
+    if (HasJumps(taken)) return nullptr; // its jumps are relative to its own body
+
+    ++report.branches;
+    return &taken;
+  }
+
+  return nullptr; // keep the statement
+}
+
+void Optimizer::OptimizeComponents(Nodes& components) {
+  for (auto& component : components)
+    VisitChildren(*component,
+      [this](NodePtr& expression) { OptimizeExpression(expression); },
+      [this](Nodes& body) { OptimizeComponents(body); }
+    );
+
+  if (!IsRelocatable(components)) return;
+
+  Layout(components, [this, &components](const int i, Nodes& laid) {
+    const auto& component = components[i];
+    if (const auto* replacement = Inline(component)) laid.insert(laid.end(), replacement->begin(), replacement->end());
+    else laid.push_back(component);
+  });
+}
+
+// Effects //
+
+static bool IsLoop(const NodeType type) { return type == NodeType::REPEAT || type == NodeType::WHILE || type == NodeType::FOREACH || type == NodeType::FOREVER; }
+static bool IsNumber(const ValueType type) { return type == ValueType::INTEGER || type == ValueType::DOUBLE; }
+static bool Contains(const std::vector<bool>& slots, const int slot) { return slot >= 0 && slot < (int)slots.size() && slots[slot]; }
+
+// Are there jumps anywhere in `components`, including their nested bodies
+static bool HasNestedJumps(Nodes& components) {
+  bool jumps = HasJumps(components);
+  for (auto& component : components)
+    VisitChildren(*component, [](NodePtr&) { }, [&jumps](Nodes& body) { jumps = jumps || HasNestedJumps(body); });
+  return jumps;
+}
+
+static void CountWrites(Nodes& components, std::vector<int>& writes, std::vector<const Ast::Procedure*>& called);
+
+// Count the statements in `components`, including their nested bodies, writing each slot; a call writes whatever its procedure does
+static void CountWrites(Nodes& components, std::vector<int>& writes) {
+  std::vector<const Ast::Procedure*> called;
+  CountWrites(components, writes, called);
+}
+
+static void CountWrites(Nodes& components, std::vector<int>& writes, std::vector<const Ast::Procedure*>& called) {
+  const auto write = [&writes](const int slot) { if (slot >= 0 && slot < (int)writes.size()) ++writes[slot]; };
+  const auto writeList = [&write](const NodePtr& list) { if (list->type == NodeType::VARIABLE) write(GetNode<Ast::Variable>(*list).slot); };
+
+  for (auto& component : components) {
+    switch (component->type) {
+      case NodeType::DEFINITION:  write(GetNode<Ast::Definition>(*component).slot); break;
+      case NodeType::ASSIGNMENT:  write(GetNode<Ast::Assignment>(*component).lvalue->slot); break;
+      case NodeType::INCREMENT:
+      case NodeType::DECREMENT:   write(GetNode<Ast::Increment>(*component).variable->slot); break;
+      case NodeType::FOREACH:     write(GetNode<Ast::Loop>(*component).element->slot); break;
+      case NodeType::PARALLEL:
+        write(GetNode<Ast::Parallel>(*component).list->slot);
+        write(GetNode<Ast::Parallel>(*component).element->slot);
+        break;
+      case NodeType::APPEND:      writeList(GetNode<Ast::Append>(*component).list); break; // lists are mutated through their variable
+      case NodeType::REMOVE:      writeList(GetNode<Ast::Remove>(*component).list); break;
+      case NodeType::CALL: {
+        const auto& call = GetNode<Ast::Call>(*component);
+        if (call.result) write(call.result->slot);
+        auto* callee = call.procedure;
+        if (!callee || std::find(called.begin(), called.end(), callee) != called.end()) break; // counted once, recursion included
+
+        called.push_back(callee);
+        for (const auto& parameter : callee->parameters) write(parameter->slot);
+        CountWrites(callee->components, writes, called);
+        break;
+      }
+      default: break;
+    }
+    VisitChildren(*component, [](NodePtr&) { }, [&writes, &called](Nodes& body) { CountWrites(body, writes, called); });
+  }
+}
+
+// Count the definitions of each slot in `components`, including their nested bodies
+static void CountDefinitions(Nodes& components, std::vector<int>& definitions) {
+  for (auto& component : components) {
+    if (component->type == NodeType::DEFINITION) {
+      const int slot = GetNode<Ast::Definition>(*component).slot;
+      if (slot >= 0 && slot < (int)definitions.size()) ++definitions[slot];
+    }
+    VisitChildren(*component, [](NodePtr&) { }, [&definitions](Nodes& body) { CountDefinitions(body, definitions); });
+  }
+}
+
+// Can `expression` be evaluated ahead of where it is: it reads variables defined beforehand and not written in between, and can not fail or differ between evaluations
+bool Optimizer::IsHoistable(const Node& expression, const Hoisting& hoisting) {
+  const auto invariant = [&hoisting](const NodePtr& child) { return IsHoistable(*child, hoisting); };
+  const auto type = expression.type;
+
+  if (type == NodeType::LITERAL) return true;
+  if (type == NodeType::VARIABLE) {
+    const int slot = GetNode<Ast::Variable>(expression).slot;
+    return Contains(hoisting.defined, slot) && hoisting.writes[slot] == 0;
+  }
+  if (type == NodeType::SIZE) {
+    const auto& list = GetNode<Ast::Size>(expression).list;
+    return list->valueType == ValueType::LIST && invariant(list);
+  }
+  if (!IsOperation(type) && !IsCondition(type)) return false;
+
+  const auto& operation = GetNode<Ast::Operation>(expression);
+  const bool unary = !operation.right;
+  const auto left = operation.left->valueType;
+  const auto right = unary ? left : operation.right->valueType;
+
+  if (IsOperation(type)) {
+    if (type == NodeType::RANDOM) return false; // differs each evaluation
+    if (!IsNumber(left) || !IsNumber(right)) return false;
+
+    // integer division traps on these divisors
+    if (type == NodeType::MODULO || (type == NodeType::DIVIDE && expression.valueType == ValueType::INTEGER)) {
+      if (operation.right->type != NodeType::LITERAL) return false;
+      const int divisor = GetLiteral(operation.right).GetNumber<int>();
+      if (divisor == 0 || divisor == -1) return false;
+    }
+  }
+  else if (IsComparison(type)) {
+    if (!(IsNumber(left) && IsNumber(right)) && !(left == ValueType::BOOLEAN && right == ValueType::BOOLEAN)) return false;
+  }
+  else if (left != ValueType::BOOLEAN || right != ValueType::BOOLEAN) return false;
+
+  return invariant(operation.left) && (unary || invariant(operation.right));
+}
+
+std::shared_ptr<Ast::Variable> Optimizer::Temporary(NodePtr expression, const std::string& key, Nodes& statements) {
+  const auto valueType = expression->valueType;
+  const auto definitionId = key + ":" + std::to_string(program->GetSlots().size());
+  const int slot = program->AddSlot(definitionId, procedure);
+
+  const auto variable = [&]() {
+    auto variable = std::make_shared<Ast::Variable>(key, definitionId, slot);
+    variable->valueType = valueType;
+    return variable;
+  };
+
+  // definitions do not overwrite, so a block run again assigns its temporaries
+  NodePtr initial;
+  Primitive primitive = Primitive::NUMBER;
+  switch (valueType) {
+    case ValueType::INTEGER:  initial = std::make_shared<Ast::Literal>(key, 0); break;
+    case ValueType::DOUBLE:   initial = std::make_shared<Ast::Literal>(key, 0.0); break;
+    case ValueType::BOOLEAN:  initial = std::make_shared<Ast::Literal>(key, false); primitive = Primitive::BOOLEAN; break;
+    case ValueType::STRING:   primitive = Primitive::STRING; break;
+    case ValueType::LIST:     primitive = Primitive::LIST; break;
+    default: break;
+  }
+  if (!initial) initial = std::make_shared<Node>(NodeType::NONE, key); // the default of its primitive
+
+  auto definition = std::make_shared<Ast::Definition>(key, definitionId, primitive, std::move(initial));
+  definition->slot = slot;
+  statements.push_back(std::move(definition));
+  statements.push_back(std::make_shared<Ast::Assignment>(key, variable(), std::move(expression)));
+
+  return variable();
+}
+
+std::shared_ptr<Ast::Variable> Optimizer::Hoist(NodePtr expression, Hoisting& hoisting) {
+  const auto key = expression->key; // hoisted expressions can not fail, so their block is only named for debugging
+  auto temporary = Temporary(std::move(expression), key, hoisting.preheader);
+
+  const int slot = temporary->slot;
+  hoisting.writes.resize(slot + 1);
+  hoisting.defined.resize(slot + 1);
+  hoisting.defined[slot] = true;
+  return temporary;
+}
+
+// Hoisting //
+
+void Optimizer::HoistExpression(NodePtr& expression, Hoisting& hoisting) {
+  if (expression->type == NodeType::LITERAL || expression->type == NodeType::VARIABLE) return; // already as cheap as a temporary
+
+  if (IsHoistable(*expression, hoisting)) {
+    expression = Hoist(std::move(expression), hoisting);
+    ++report.hoisted;
+    return;
+  }
+
+  VisitChildren(*expression, [this, &hoisting](NodePtr& child) { HoistExpression(child, hoisting); }, [](Nodes&) { });
+}
+
+void Optimizer::HoistComponents(Nodes& components, Hoisting& hoisting) {
+  for (auto& component : components)
+    VisitChildren(*component,
+      [this, &hoisting](NodePtr& expression) { HoistExpression(expression, hoisting); },
+      [this, &hoisting](Nodes& body) { HoistComponents(body, hoisting); }
+    );
+}
+
+// Strength Reduction //
+
+// `induction * factor`, where the factor is an invariant integer, becomes a temporary stepped by the factor wherever the induction variable is
+void Optimizer::ReduceExpression(NodePtr& expression, Hoisting& hoisting) {
+  if (expression->type == NodeType::MULTIPLY && expression->valueType == ValueType::INTEGER) {
+    const auto& operation = GetNode<Ast::Operation>(*expression);
+
+    for (const auto& [induction, factor] : { std::pair{ operation.left, operation.right }, std::pair{ operation.right, operation.left } }) {
+      if (induction->type != NodeType::VARIABLE) continue;
+      const int slot = GetNode<Ast::Variable>(*induction).slot;
+      if (slot < 0 || slot >= (int)hoisting.inductions.size() || hoisting.inductions[slot] == NOT_INDUCTION) continue;
+
+      const bool literal = factor->type == NodeType::LITERAL && GetLiteral(factor).Is<int>();
+      const bool variable = factor->type == NodeType::VARIABLE && factor->valueType == ValueType::INTEGER && IsHoistable(*factor, hoisting);
+      if (!literal && !variable) continue;
+
+      const int at = hoisting.inductions[slot];
+      const auto step = (*hoisting.body)[at]->type == NodeType::INCREMENT ? NodeType::ADD : NodeType::SUBTRACT;
+      const NodePtr amount = literal
+        ? NodePtr{std::make_shared<Ast::Literal>(factor->key, GetLiteral(factor))}
+        : NodePtr{std::make_shared<Ast::Variable>(GetNode<Ast::Variable>(*factor))};
+
+      const auto temporary = Hoist(std::move(expression), hoisting); // the product on entering the loop
+      ++hoisting.writes[temporary->slot];
+
+      auto sum = std::make_shared<Ast::Operation>(step, temporary->key, std::make_shared<Ast::Variable>(*temporary), amount);
+      sum->valueType = ValueType::INTEGER;
+      hoisting.steps[at].push_back(std::make_shared<Ast::Assignment>(temporary->key, std::make_shared<Ast::Variable>(*temporary), std::move(sum)));
+
+      expression = temporary;
+      ++report.reduced;
+      return;
+    }
+  }
+
+  VisitChildren(*expression, [this, &hoisting](NodePtr& child) { ReduceExpression(child, hoisting); }, [](Nodes&) { });
+}
+
+void Optimizer::ReduceComponents(Nodes& components, Hoisting& hoisting) {
+  for (auto& component : components)
+    VisitChildren(*component,
+      [this, &hoisting](NodePtr& expression) { ReduceExpression(expression, hoisting); },
+      [this, &hoisting](Nodes& body) { ReduceComponents(body, hoisting); }
+    );
+}
+
+// Inlining //
+
+static constexpr int MAX_INLINE_NODES = 32; // in the body of a procedure small enough to inline
+static constexpr int MAX_INLINE_ROUNDS = 4; // a procedure whose calls were all inlined may be inlined in turn
+
+static int CountNodes(Node& node) {
+  int count = 1;
+  VisitChildren(node,
+    [&count](NodePtr& child) { count += CountNodes(*child); },
+    [&count](Nodes& body) { for (auto& component : body) count += CountNodes(*component); }
+  );
+  return count;
+}
+
+// Do `components` and their nested bodies only run statements that stay within the frame
+static bool IsLeaf(Nodes& components) {
+  bool leaf = true;
+  for (auto& component : components) {
+    const auto type = component->type;
+    leaf = leaf && type != NodeType::CALL && type != NodeType::RETURN && type != NodeType::DEFINITION && type != NodeType::PROCEDURE;
+    VisitChildren(*component, [](NodePtr&) { }, [&leaf](Nodes& body) { leaf = leaf && IsLeaf(body); });
+  }
+  return leaf;
+}
+
+// The slots `node` reads or writes, including its nested bodies
+static void CollectSlots(Node& node, std::vector<int>& slots) {
+  if (node.type == NodeType::VARIABLE) slots.push_back(GetNode<Ast::Variable>(node).slot);
+  VisitChildren(node,
+    [&slots](NodePtr& child) { CollectSlots(*child, slots); },
+    [&slots](Nodes& body) { for (auto& component : body) CollectSlots(*component, slots); }
+  );
+}
+
+// Can a call of `procedure` be replaced by its body: it is small, calls nothing, returns a value exactly when one is assigned and only at its end,
+// and defines each local once at the top of its body before it is used, so a fresh frame changes nothing
+static bool IsInlinable(Ast::Procedure& procedure, const bool result) {
+  auto& body = procedure.components;
+  int nodes = 0;
+  for (auto& component : body) nodes += CountNodes(*component);
+  if (nodes > MAX_INLINE_NODES || HasNestedJumps(body)) return false;
+
+  const bool returns = !body.empty() && body.back()->type == NodeType::RETURN && GetNode<Ast::Return>(*body.back()).expression;
+  if (returns != result) return false;
+
+  const auto& locals = procedure.locals;
+  std::vector<int> defined;
+  for (const auto& parameter : procedure.parameters) defined.push_back(parameter->slot);
+  const auto usable = [&locals, &defined](const int slot) {
+    return std::find(locals.begin(), locals.end(), slot) == locals.end() || std::find(defined.begin(), defined.end(), slot) != defined.end();
+  };
+
+  const int count = body.size();
+  for (int i = 0; i < count; ++i) {
+    auto& component = *body[i];
+    const auto type = component.type;
+    if (type == NodeType::CALL || type == NodeType::PROCEDURE || (type == NodeType::RETURN && i + 1 < count)) return false;
+
+    bool leaf = true;
+    VisitChildren(component, [](NodePtr&) { }, [&leaf](Nodes& inner) { leaf = leaf && IsLeaf(inner); });
+    if (!leaf) return false;
+
+    std::vector<int> slots;
+    CollectSlots(component, slots);
+    if (!std::all_of(slots.begin(), slots.end(), usable)) return false;
+
+    if (type == NodeType::DEFINITION) {
+      const int slot = GetNode<Ast::Definition>(component).slot;
+      if (std::find(defined.begin(), defined.end(), slot) != defined.end()) return false; // defined twice, the second does nothing
+      defined.push_back(slot);
+    }
+  }
+  return true;
+}
+
+// Give each slot of `node` and its nested bodies the slot it is `renamed` to
+static void Rename(Node& node, const std::vector<int>& renamed) {
+  const auto rename = [&renamed](int& slot) { if (slot >= 0 && slot < (int)renamed.size() && renamed[slot] != Ast::UNRESOLVED) slot = renamed[slot]; };
+  if (node.type == NodeType::VARIABLE) rename(GetNode<Ast::Variable>(node).slot);
+  else if (node.type == NodeType::DEFINITION) rename(GetNode<Ast::Definition>(node).slot);
+  else if (node.type == NodeType::PARALLEL) for (int& slot : GetNode<Ast::Parallel>(node).locals) rename(slot);
+
+  VisitChildren(node, // targets are visited as copies of the same node
+    [&renamed](NodePtr& child) { Rename(*child, renamed); },
+    [&renamed](Nodes& body) { for (auto& component : body) Rename(*component, renamed); }
+  );
+}
+
+bool Optimizer::IsExpandable(const Node& component) const {
+  if (component.type != NodeType::CALL) return false;
+  const auto& call = GetNode<Ast::Call>(component);
+  auto* callee = call.procedure;
+  return callee && callee != procedure && call.arguments.size() == callee->parameters.size() && IsInlinable(*callee, call.result != nullptr);
+}
+
+void Optimizer::Expand(const Ast::Call& call, Nodes& laid) {
+  auto& callee = *call.procedure;
+
+  // the locals of the callee become locals of the caller
+  std::vector<int> renamed(program->GetSlots().size(), Ast::UNRESOLVED);
+  for (const int slot : callee.locals) {
+    const auto key = program->GetSlots()[slot];
+    renamed[slot] = program->AddSlot(key + ":" + std::to_string(program->GetSlots().size()), procedure);
+  }
+
+  // definitions do not overwrite, so a call run again assigns its locals
+  const auto define = [&](const Ast::Definition& definition, const int slot, NodePtr value) {
+    const auto& definitionId = program->GetSlots()[slot];
+    auto local = std::make_shared<Ast::Definition>(definition.key, definition.name, definition.primitive, std::make_shared<Node>(NodeType::NONE, definition.key));
+    local->slot = slot;
+    laid.push_back(std::move(local));
+    laid.push_back(std::make_shared<Ast::Assignment>(definition.key, std::make_shared<Ast::Variable>(definition.key, definitionId, slot), std::move(value)));
+  };
+
+  for (int i = 0; i < (int)call.arguments.size(); ++i) define(*callee.parameters[i], renamed[callee.parameters[i]->slot], call.arguments[i]);
+
+  for (const auto& component : callee.components) {
+    auto copy = Clone(*component);
+    Rename(*copy, renamed);
+
+    if (copy->type == NodeType::RETURN) { // the last statement
+      if (call.result) laid.push_back(std::make_shared<Ast::Assignment>(copy->key, std::make_shared<Ast::Variable>(*call.result), GetNode<Ast::Return>(*copy).expression));
+      continue;
+    }
+    if (copy->type != NodeType::DEFINITION) {
+      laid.push_back(std::move(copy));
+      continue;
+    }
+
+    const auto& definition = GetNode<Ast::Definition>(*copy);
+    NodePtr value = definition.expression;
+    if (value->type == NodeType::NONE) {
+      switch (definition.primitive) { // the default of its primitive
+        case Primitive::NUMBER:   value = std::make_shared<Ast::Literal>(definition.key, 0); break;
+        case Primitive::STRING:   value = std::make_shared<Ast::Literal>(definition.key, std::string()); break;
+        case Primitive::BOOLEAN:  value = std::make_shared<Ast::Literal>(definition.key, false); break;
+        case Primitive::LIST:     value = std::make_shared<Ast::List>(definition.key, Nodes{}, nullptr, nullptr); break;
+      }
+    }
+    define(definition, definition.slot, std::move(value));
+  }
+
+  ++report.inlined;
+}
+
+bool Optimizer::InlineCalls(Nodes& components) {
+  bool inlined = false;
+  for (auto& component : components) {
+    if (component->type == NodeType::PROCEDURE) {
+      procedure = &GetNode<Ast::Procedure>(*component);
+      inlined = InlineCalls(procedure->components) || inlined;
+      procedure = nullptr;
+    }
+    else VisitChildren(*component, [](NodePtr&) { }, [this, &inlined](Nodes& body) { inlined = InlineCalls(body) || inlined; });
+  }
+
+  if (!IsRelocatable(components) || std::none_of(components.begin(), components.end(), [this](const NodePtr& component) { return IsExpandable(*component); }))
+    return inlined;
+
+  Layout(components, [this, &components](const int i, Nodes& laid) {
+    const auto& component = components[i];
+    if (IsExpandable(*component)) Expand(GetNode<Ast::Call>(*component), laid);
+    else laid.push_back(component);
+  });
+  return true;
+}
+
+// Scripts //
+
+void Optimizer::Interleave(const int script) {
+  concurrent.assign(program->GetSlots().size(), 0);
+  if (scripts.size() < 2) return; // the program runs alone
+
+  for (int other = 0; other < (int)scripts.size(); ++other) {
+    if (other == script) continue;
+    for (int slot = 0; slot < (int)scripts[other].size(); ++slot) concurrent[slot] += scripts[other][slot];
+  }
+}
+
+void Optimizer::Interleaved(std::vector<int>& writes) const {
+  for (int slot = 0; slot < (int)writes.size() && slot < (int)concurrent.size(); ++slot) writes[slot] += concurrent[slot];
+}
+
+// Loops //
+
+Nodes Optimizer::OptimizeLoop(Ast::Loop& loop, const std::vector<bool>& defined) {
+  auto& body = loop.components;
+  Hoisting hoisting{ &body, std::vector<int>(defined.size(), 0), defined, {}, {}, {} };
+  CountWrites(body, hoisting.writes);
+  Interleaved(hoisting.writes);
+  if (loop.type == NodeType::FOREACH) ++hoisting.writes[loop.element->slot]; // each iteration assigns its element
+
+  // invariant expressions, the condition of a `while` is evaluated each iteration as well
+  if (loop.type == NodeType::WHILE) HoistExpression(loop.expression, hoisting);
+  HoistComponents(body, hoisting);
+
+  // induction variables are integers stepped once each iteration, so every statement of the body must run exactly once
+  if (HasNestedJumps(body)) return std::move(hoisting.preheader);
+
+  const int count = body.size();
+  hoisting.inductions.assign(defined.size(), NOT_INDUCTION);
+  hoisting.steps.resize(count);
+  for (int i = 0; i < count; ++i) {
+    if (body[i]->type != NodeType::INCREMENT && body[i]->type != NodeType::DECREMENT) continue;
+
+    const auto& variable = *GetNode<Ast::Increment>(*body[i]).variable;
+    const int slot = variable.slot;
+    if (Contains(defined, slot) && hoisting.writes[slot] == 1 && variable.valueType == ValueType::INTEGER) hoisting.inductions[slot] = i;
+  }
+
+  if (loop.type == NodeType::WHILE) ReduceExpression(loop.expression, hoisting);
+  ReduceComponents(body, hoisting);
+
+  Nodes stepped;
+  stepped.reserve(count);
+  for (int i = 0; i < count; ++i) {
+    stepped.push_back(std::move(body[i]));
+    stepped.insert(stepped.end(), hoisting.steps[i].begin(), hoisting.steps[i].end());
+  }
+  body = std::move(stepped);
+
+  return std::move(hoisting.preheader);
+}
+
+void Optimizer::OptimizeLoops(Nodes& components, std::vector<bool> defined, const bool once) {
+  const bool relocatable = IsRelocatable(components);
+  const bool ordered = !HasJumps(components); // each definition has run before the statements after it
+  const int count = components.size();
+  std::vector<Nodes> preheaders(count);
+  bool hoisted = false;
+
+  for (int i = 0; i < count; ++i) {
+    auto& component = *components[i];
+    if (component.type == NodeType::PROCEDURE) { // called from anywhere, so nothing is known to be defined in its body
+      procedure = &GetNode<Ast::Procedure>(component);
+      Interleave(ANY_SCRIPT);
+      OptimizeLoops(procedure->components, std::vector<bool>(defined.size(), false), false);
+      Interleave(0);
+      procedure = nullptr;
+      continue;
+    }
+    if (component.type == NodeType::SCRIPT) { // started with the program, before anything is defined
+      auto& script = GetNode<Ast::Script>(component);
+      Interleave(script.index);
+      OptimizeLoops(script.components, std::vector<bool>(defined.size(), false), true);
+      Interleave(0);
+      continue;
+    }
+    if (component.type == NodeType::PARALLEL) continue; // its iterations only hold the variables checked at load time, not temporaries
+
+    const bool branch = component.type == NodeType::BRANCH; // taken at most once each time its block runs
+    VisitChildren(component, [](NodePtr&) { }, [this, &defined, once, ordered, branch](Nodes& body) { OptimizeLoops(body, defined, once && ordered && branch); }); // inner loops first
+
+    if (ordered && i > 0 && component.type == NodeType::REPEAT) BoundSubscripts(*components[i - 1], GetNode<Ast::Loop>(component), once);
+
+    if (relocatable && IsLoop(component.type)) {
+      preheaders[i] = OptimizeLoop(GetNode<Ast::Loop>(component), defined);
+      hoisted = hoisted || !preheaders[i].empty();
+    }
+
+    if (ordered && component.type == NodeType::DEFINITION) {
+      const int slot = GetNode<Ast::Definition>(component).slot;
+      if (slot >= 0 && slot < (int)defined.size()) defined[slot] = true;
+    }
+  }
+
+  if (!hoisted) return;
+
+  Layout(components, [&components, &preheaders](const int i, Nodes& laid) {
+    laid.insert(laid.end(), preheaders[i].begin(), preheaders[i].end());
+    laid.push_back(components[i]);
+  });
+}
+
+// Bounds Checks //
+
+// `index = 0` before `repeat size(list)`, whose body steps `index` once and does not edit `list`, subscripts the list within its bounds until the step
+void Optimizer::BoundSubscripts(const Node& initializer, Ast::Loop& repeat, const bool once) {
+  if (repeat.expression->type != NodeType::SIZE) return;
+  const auto& size = *GetNode<Ast::Size>(*repeat.expression).list;
+  if (size.type != NodeType::VARIABLE || size.valueType != ValueType::LIST) return; // the list is read from one variable
+  const int list = GetNode<Ast::Variable>(size).slot;
+
+  // definitions do not overwrite, so one must be the only definition of the index and run once
+  int index;
+  const NodePtr* initial;
+  if (initializer.type == NodeType::ASSIGNMENT) {
+    const auto& assignment = GetNode<Ast::Assignment>(initializer);
+    index = assignment.lvalue->slot;
+    initial = &assignment.rvalue;
+  } else if (initializer.type == NodeType::DEFINITION) {
+    const auto& definition = GetNode<Ast::Definition>(initializer);
+    index = definition.slot;
+    initial = &definition.expression;
+    if (!once || index < 0 || index >= (int)definitions.size() || definitions[index] != 1) return;
+  } else return;
+  if (!IsLiteral(*initial) || !GetLiteral(*initial).Is<int>() || GetLiteral(*initial).Get<int>() != 0) return;
+
+  // every statement of the body runs once an iteration, in order
+  auto& body = repeat.components;
+  if (HasNestedJumps(body)) return;
+
+  std::vector<int> writes(program->GetSlots().size(), 0);
+  CountWrites(body, writes);
+  Interleaved(writes);
+  if (list < 0 || index < 0 || writes[list] != 0 || writes[index] != 1) return;
+
+  const auto step = std::find_if(body.begin(), body.end(), [index](const NodePtr& component) {
+    return component->type == NodeType::INCREMENT && GetNode<Ast::Increment>(*component).variable->slot == index;
+  });
+  if (step == body.end() || GetNode<Ast::Increment>(**step).variable->valueType != ValueType::INTEGER) return;
+
+  BoundComponents(body.begin(), step, list, index);
+}
+
+void Optimizer::BoundComponents(const Nodes::iterator begin, const Nodes::iterator end, const int list, const int index) {
+  for (auto component = begin; component != end; ++component)
+    VisitChildren(**component,
+      [this, list, index](NodePtr& expression) { BoundExpression(expression, list, index); },
+      [this, list, index](Nodes& body) { BoundComponents(body.begin(), body.end(), list, index); }
+    );
+}
+
+void Optimizer::BoundExpression(NodePtr& expression, const int list, const int index) {
+  VisitChildren(*expression, [this, list, index](NodePtr& child) { BoundExpression(child, list, index); }, [](Nodes&) { });
+  if (expression->type != NodeType::SUBSCRIPT) return;
+
+  const auto& subscript = GetNode<Ast::Subscript>(*expression);
+  const auto reads = [](const NodePtr& operand, const int slot) { return operand->type == NodeType::VARIABLE && GetNode<Ast::Variable>(*operand).slot == slot; };
+  if (subscript.bounded || !reads(subscript.list, list) || !reads(subscript.index, index)) return;
+
+  auto bounded = std::make_shared<Ast::Subscript>(subscript); // copied, the node may be read elsewhere
+  bounded->bounded = true;
+  expression = std::move(bounded);
+  ++report.bounded;
+}
+
+// Common Subexpressions //
+
+void Optimizer::Intern(NodePtr& expression) {
+  VisitChildren(*expression, [this](NodePtr& child) { Intern(child); }, [](Nodes&) { });
+
+  // the structure of a node is its type and payload, its children are already canonical
+  const auto type = expression->type;
+  std::string structure{ static_cast<char>(type), static_cast<char>(expression->valueType) };
+  const auto append = [&structure](const auto& payload) { structure.append(reinterpret_cast<const char*>(&payload), sizeof(payload)); };
+
+  if (type == NodeType::LITERAL) {
+    const auto& value = GetLiteral(expression);
+    structure.push_back(static_cast<char>(value.GetType()));
+    if (value.Is<int>()) append(value.Get<int>());
+    else if (value.Is<double>()) append(value.Get<double>());
+    else if (value.Is<bool>()) append(value.Get<bool>());
+    else if (value.Is<std::string>()) structure += value.Get<std::string>();
+    else return; // lists are mutable
+  }
+  else if (type == NodeType::VARIABLE) {
+    const int slot = GetNode<Ast::Variable>(*expression).slot;
+    if (slot == Ast::UNRESOLVED) return;
+    append(slot);
+  }
+  else if (type == NodeType::SIZE || type == NodeType::SUBSCRIPT || ((IsOperation(type) || IsCondition(type)) && type != NodeType::RANDOM)) {
+    VisitChildren(*expression, [&append](NodePtr& child) { append(child.get()); }, [](Nodes&) { });
+    if (type == NodeType::SUBSCRIPT) structure.push_back(GetNode<Ast::Subscript>(*expression).bounded); // only proven within its loop
+  }
+  else return; // list constructions and random numbers differ each evaluation
+
+  const auto [canonical, inserted] = interned.try_emplace(std::move(structure), expression);
+  if (inserted || canonical->second == expression) return;
+
+  expression = canonical->second;
+  ++report.shared;
+}
+
+void Optimizer::InternComponents(Nodes& components) {
+  for (auto& component : components) {
+    if (component->type == NodeType::ASSIGNMENT) Intern(GetNode<Ast::Assignment>(*component).rvalue); // targets are written, not read
+    else if (component->type != NodeType::INCREMENT && component->type != NodeType::DECREMENT)
+      VisitChildren(*component,
+        [this](NodePtr& expression) { Intern(expression); },
+        [this](Nodes& body) { InternComponents(body); }
+      );
+  }
+}
+
+// The expressions `component` evaluates exactly once, in the order it evaluates them
+std::vector<NodePtr*> Optimizer::GetOperands(Node& component) const {
+  switch (component.type) {
+    case NodeType::DEFINITION:  return { &GetNode<Ast::Definition>(component).expression };
+    case NodeType::ASSIGNMENT:  return { &GetNode<Ast::Assignment>(component).rvalue };
+    case NodeType::BRANCH:      return { &GetNode<Ast::Branch>(component).condition };
+    case NodeType::REPEAT:
+    case NodeType::FOREACH:     return { &GetNode<Ast::Loop>(component).expression };
+    case NodeType::APPEND:      return { &GetNode<Ast::Append>(component).item };
+    case NodeType::REMOVE:      return { &GetNode<Ast::Remove>(component).index };
+    case NodeType::PRINT:       return { &GetNode<Ast::Print>(component).expression };
+    case NodeType::WAIT:        return { &GetNode<Ast::Wait>(component).duration };
+    case NodeType::DRAW_LINE:
+    case NodeType::DRAW_RECT:
+    case NodeType::DRAW_PIXEL: {
+      std::vector<NodePtr*> operands;
+      for (auto& operand : GetNode<Ast::Draw>(component).operands) if (operand) operands.push_back(&operand);
+      return operands;
+    }
+    case NodeType::CALL: { // unless it fails before evaluating them
+      auto& call = GetNode<Ast::Call>(component);
+      if (!call.procedure || call.arguments.size() != call.procedure->parameters.size()) return {};
+
+      std::vector<NodePtr*> operands;
+      for (auto& argument : call.arguments) operands.push_back(&argument);
+      return operands;
+    }
+    case NodeType::RETURN: {
+      auto& value = GetNode<Ast::Return>(component).expression;
+      if (!procedure || !value) return {}; // fails outside of a procedure
+      return { &value };
+    }
+    default: return {};
+  }
+}
+
+// Replace each expression held in a temporary, copying the nodes above it as nodes are shared
+bool Optimizer::Substitute(NodePtr& expression, const Temporaries& temporaries) {
+  if (const auto temporary = temporaries.find(expression.get()); temporary != temporaries.end()) {
+    expression = std::make_shared<Ast::Variable>(*temporary->second);
+    return true;
+  }
+
+  NodePtr copy;
+  const auto type = expression->type;
+  if (type == NodeType::SIZE) copy = std::make_shared<Ast::Size>(GetNode<Ast::Size>(*expression));
+  else if (type == NodeType::SUBSCRIPT) copy = std::make_shared<Ast::Subscript>(GetNode<Ast::Subscript>(*expression));
+  else if (IsOperation(type) || IsCondition(type)) copy = std::make_shared<Ast::Operation>(GetNode<Ast::Operation>(*expression));
+  else return false;
+
+  bool substituted = false;
+  VisitChildren(*copy, [&substituted, &temporaries](NodePtr& child) { substituted = Substitute(child, temporaries) || substituted; }, [](Nodes&) { });
+  if (substituted) expression = std::move(copy);
+  return substituted;
+}
+
+static bool IsDeterministic(Node& expression) {
+  if (expression.type == NodeType::RANDOM || expression.type == NodeType::LIST) return false;
+  bool deterministic = true;
+  VisitChildren(expression, [&deterministic](NodePtr& child) { deterministic = deterministic && IsDeterministic(*child); }, [](Nodes&) { });
+  return deterministic;
+}
+
+static void CollectReads(Node& expression, std::vector<int>& reads) {
+  if (expression.type == NodeType::VARIABLE) reads.push_back(GetNode<Ast::Variable>(expression).slot);
+  VisitChildren(expression, [&reads](NodePtr& child) { CollectReads(*child, reads); }, [](Nodes&) { });
+}
+
+// Record the expressions of `statement` that may be evaluated before it; `certain` when the statement always evaluates `expression`
+void Optimizer::CollectSubexpressions(NodePtr& expression, const bool certain, const int statement, Elimination& elimination) {
+  auto& node = *expression;
+  const auto type = node.type;
+  if (type == NodeType::LITERAL) return;
+  if (type == NodeType::VARIABLE) {
+    elimination.safe = elimination.safe && Contains(elimination.scope.defined, GetNode<Ast::Variable>(node).slot);
+    return;
+  }
+  if (type != NodeType::SIZE && type != NodeType::SUBSCRIPT && !IsOperation(type) && !IsCondition(type)) {
+    elimination.safe = false;
+    return;
+  }
+
+  // evaluated earlier in the statement with the same reads
+  if (const auto live = elimination.live.find(&node); live != elimination.live.end()) {
+    auto& subexpression = elimination.subexpressions[live->second];
+    ++subexpression.uses;
+    subexpression.last = statement;
+    return;
+  }
+
+  // short circuits and subscripts of a non list do not evaluate their right operand
+  const bool safe = elimination.safe;
+  const auto collect = [&elimination, statement](NodePtr& child, const bool certain) { CollectSubexpressions(child, certain, statement, elimination); };
+  if (type == NodeType::SUBSCRIPT) {
+    collect(GetNode<Ast::Subscript>(node).list, certain);
+    collect(GetNode<Ast::Subscript>(node).index, false);
+  } else if (type == NodeType::AND || type == NodeType::OR) {
+    collect(GetNode<Ast::Operation>(node).left, certain);
+    collect(GetNode<Ast::Operation>(node).right, false);
+  } else VisitChildren(node, [&collect, certain](NodePtr& child) { collect(child, certain); }, [](Nodes&) { });
+
+  // an expression that can fail is only evaluated early where it would have been reached anyway
+  const bool hoistable = IsHoistable(node, elimination.scope);
+  if (IsDeterministic(node) && (hoistable || (certain && safe))) {
+    Subexpression subexpression{ expression, {}, statement, statement };
+    CollectReads(node, subexpression.reads);
+
+    // another script may write what it reads between its evaluations
+    const auto& writes = elimination.scope.writes;
+    const auto& reads = subexpression.reads;
+    if (std::none_of(reads.begin(), reads.end(), [&writes](const int slot) { return slot >= 0 && slot < (int)writes.size() && writes[slot] > 0; })) {
+      elimination.live.emplace(&node, elimination.subexpressions.size());
+      elimination.subexpressions.push_back(std::move(subexpression));
+    }
+  }
+  elimination.safe = safe && hoistable;
+}
+
+void Optimizer::EliminateComponents(Nodes& components, std::vector<bool> defined) {
+  const bool ordered = !HasJumps(components); // each statement runs once, after the ones before it
+  const int count = components.size();
+  Elimination elimination{ Hoisting{ &components, {}, {}, {}, {}, {} }, {}, {}, true };
+
+  for (int i = 0; i < count; ++i) {
+    auto& component = *components[i];
+    if (component.type == NodeType::PROCEDURE) {
+      procedure = &GetNode<Ast::Procedure>(component);
+      Interleave(ANY_SCRIPT);
+      EliminateComponents(procedure->components, std::vector<bool>(defined.size(), false));
+      Interleave(0);
+      procedure = nullptr;
+    }
+    else if (component.type == NodeType::SCRIPT) {
+      auto& script = GetNode<Ast::Script>(component);
+      Interleave(script.index);
+      EliminateComponents(script.components, std::vector<bool>(defined.size(), false));
+      Interleave(0);
+    }
+    else if (component.type == NodeType::PARALLEL) { } // its iterations only hold the variables checked at load time, not temporaries
+    else VisitChildren(component, [](NodePtr&) { }, [this, &defined](Nodes& body) { EliminateComponents(body, defined); });
+    if (!ordered) continue;
+
+    // lists are checked before the item is evaluated, and draws convert each operand as it is evaluated
+    elimination.scope.defined = defined;
+    elimination.scope.writes.assign(defined.size(), 0);
+    Interleaved(elimination.scope.writes);
+    elimination.safe = (component.type != NodeType::APPEND || GetNode<Ast::Append>(component).list->type == NodeType::VARIABLE)
+      && (component.type != NodeType::REMOVE || GetNode<Ast::Remove>(component).list->type == NodeType::VARIABLE);
+    const bool draw = component.type == NodeType::DRAW_LINE || component.type == NodeType::DRAW_RECT || component.type == NodeType::DRAW_PIXEL;
+    for (auto* operand : GetOperands(component)) {
+      CollectSubexpressions(*operand, true, i, elimination);
+      elimination.safe = elimination.safe && (!draw || IsNumber((*operand)->valueType));
+    }
+
+    // writes end the reuse of what they read
+    std::vector<int> writes(program->GetSlots().size(), 0);
+    Nodes statement{ components[i] };
+    CountWrites(statement, writes);
+    std::erase_if(elimination.live, [&elimination, &writes](const auto& live) {
+      const auto& reads = elimination.subexpressions[live.second].reads;
+      return std::any_of(reads.begin(), reads.end(), [&writes](const int slot) { return slot >= 0 && writes[slot] > 0; });
+    });
+
+    if (component.type == NodeType::DEFINITION) {
+      const int slot = GetNode<Ast::Definition>(component).slot;
+      if (slot >= 0 && slot < (int)defined.size()) defined[slot] = true;
+    }
+  }
+
+  const auto& subexpressions = elimination.subexpressions;
+  if (std::none_of(subexpressions.begin(), subexpressions.end(), [](const Subexpression& subexpression) { return subexpression.uses > 1; })) return;
+
+  // evaluate each repeated expression into a temporary before its first statement, inner expressions first
+  Temporaries temporaries;
+  Nodes laid;
+  laid.reserve(count);
+  for (int i = 0; i < count; ++i) {
+    const auto& key = components[i]->key; // attribute errors to the statement that evaluated the expression
+    for (const auto& subexpression : subexpressions) {
+      if (subexpression.first != i || subexpression.uses < 2) continue;
+
+      auto expression = subexpression.expression;
+      (void)Substitute(expression, temporaries);
+      temporaries.emplace(subexpression.expression.get(), Temporary(std::move(expression), key, laid));
+      report.reused += subexpression.uses - 1;
+    }
+
+    for (auto* operand : GetOperands(*components[i])) (void)Substitute(*operand, temporaries);
+    laid.push_back(components[i]);
+
+    for (const auto& subexpression : subexpressions)
+      if (subexpression.last == i && subexpression.uses > 1) temporaries.erase(subexpression.expression.get());
+  }
+  components = std::move(laid);
+}
+
+// API //
+
+std::string Optimizer::Report::ToString() const {
+  return "Optimized: folded " + std::to_string(folded) + " expressions, removed "
+    + std::to_string(branches) + " constant branches, "
+    + std::to_string(comments) + " comments, and "
+    + std::to_string(bodies) + " empty loops; hoisted "
+    + std::to_string(hoisted) + " invariant expressions and reduced "
+    + std::to_string(reduced) + " multiplications; shared "
+    + std::to_string(shared) + " expressions and reused "
+    + std::to_string(reused) + " evaluations; removed "
+    + std::to_string(bounded) + " bounds checks; inlined "
+    + std::to_string(inlined) + " calls";
+}
+
+Optimizer::Report Optimizer::Optimize(AbstractSyntaxTree& program) {
+  report = {};
+  Optimizer::program = &program;
+  OptimizeComponents(program.GetTree());
+  for (int round = 0; round < MAX_INLINE_ROUNDS && InlineCalls(program.GetTree()); ++round) { }
+
+  // loops are only rewritten where types are proven
+  TypeInference{}.Infer(program);
+  definitions.assign(program.GetSlots().size(), 0);
+  CountDefinitions(program.GetTree(), definitions);
+
+  // what each script writes, the program's own components being the first script
+  Nodes components;
+  scripts.assign(1, std::vector<int>(program.GetSlots().size(), 0));
+  for (const auto& component : program.GetTree()) {
+    if (component->type == NodeType::PROCEDURE) continue; // counted where it is called
+    if (component->type != NodeType::SCRIPT) {
+      components.push_back(component);
+      continue;
+    }
+    auto& script = GetNode<Ast::Script>(*component);
+    if (script.index >= (int)scripts.size()) scripts.resize(script.index + 1, std::vector<int>(program.GetSlots().size(), 0));
+    CountWrites(script.components, scripts[script.index]);
+  }
+  CountWrites(components, scripts.front());
+  Interleave(0);
+
+  OptimizeLoops(program.GetTree(), std::vector<bool>(program.GetSlots().size(), false), true);
+
+  // repeated expressions are found by identity once shared, and the copies substitution makes are shared again
+  InternComponents(program.GetTree());
+  EliminateComponents(program.GetTree(), std::vector<bool>(program.GetSlots().size(), false));
+  InternComponents(program.GetTree());
+  interned.clear();
+  scripts.clear();
+  concurrent.clear();
+  Optimizer::program = nullptr;
+
+  Log(report.ToString());
+  return report;
+}
@@ -0,0 +1,230 @@
+#include <parallel.hpp>
+#include <threadPool.hpp>
+#include <kernel.hpp>
+
+#include <mutex>
+#include <atomic>
+#include <optional>
+#include <exception>
+#include <algorithm>
+
+static constexpr int MAX_REPEAT_LENGTH = 2048;
+static constexpr int MAX_PARALLEL_STEPS = 1 << 24; // statements an iteration may run, so a body that never finishes fails instead of hanging its engine
+static constexpr int MIN_GRAIN = 32; // iterations worth waking a thread for
+static constexpr int RANGES_PER_THREAD = 8; // smaller ranges leave more to steal
+static constexpr int SHARED = -1; // a slot read from the store, rather than held by the iteration
+
+// Runs the body of a `parallel` block for one element after another on one thread.
+// Values are read from the store in place and only numbers and booleans are copied out, as reference counts are not atomic.
+class Iteration final {
+private:
+  const Ast::Parallel& parallel;
+  const VariableStore& store;
+  const std::vector<int>& locals; // the index of each slot among the iteration's own, `SHARED` outside of them
+  std::vector<std::optional<Value>> cells; // the iteration's own variables, its element first
+  std::vector<Primitive> primitives; // of each of the iteration's own variables, as defined
+  int steps = 0;
+
+  [[nodiscard]] inline int Local(const int slot) const { return slot >= 0 && slot < (int)locals.size() ? locals[slot] : SHARED; }
+
+  [[nodiscard]] const Value& Scalar(const Value& value) const {
+    using namespace std::string_literals;
+    if (!value.IsNumber() && !value.Is<bool>()) throw std::runtime_error("Parallel `"s + parallel.key + "` can only read numbers and booleans!"s);
+    return value;
+  } // throws `std::runtime_error`
+
+  [[nodiscard]] const Value& Read(const Ast::Variable& variable) const {
+    const int local = Local(variable.slot);
+    if (local == SHARED) return store.Get(variable.slot).Get();
+
+    const auto& cell = cells[local];
+    if (!cell) throw std::out_of_range("Variable `" + variable.definitionId + "` is not defined!");
+    return *cell;
+  } // throws `std::out_of_range`
+
+  [[nodiscard]] Value& Write(const Ast::Variable& variable) {
+    auto& cell = cells[Local(variable.slot)]; // the body only writes the iteration's own, checked at load time
+    if (!cell) throw std::out_of_range("Variable `" + variable.definitionId + "` is not defined!");
+    return *cell;
+  } // throws `std::out_of_range`
+
+  // Read an expression in place: variables and subscripts are borrowed, anything else is evaluated into `temporary`
+  [[nodiscard]] const Value& Read(const Node& expression, Value& temporary) {
+    if (expression.type == NodeType::VARIABLE) return Read(GetNode<Ast::Variable>(expression));
+    if (expression.type == NodeType::SUBSCRIPT) return Subscript(GetNode<Ast::Subscript>(expression), temporary);
+    return temporary = Evaluate(expression);
+  }
+
+  [[nodiscard]] const Value& Subscript(const Ast::Subscript& subscript, Value& temporary) {
+    Value operand;
+    const auto& list = Read(*subscript.list, operand);
+    if (!list.Is<Value::List>()) throw std::runtime_error("value subscription must be `list`!");
+
+    const int size = list.Size();
+    const int index = Evaluate(*subscript.index).GetNumber<int>();
+    if (std::abs(index) >= size) throw std::out_of_range("Subscript INDEX is out of range!");
+
+    return list.Element(index >= 0 ? index : size + index, temporary);
+  }
+
+  [[nodiscard]] bool Boolean(const Node& expression) { return Evaluate(expression).Get<bool>(); } // throws `std::bad_variant_access`
+
+  [[nodiscard]] bool Condition(const Ast::Operation& condition) {
+    switch (condition.type) {
+      case NodeType::NOT: return !Boolean(*condition.left);
+      case NodeType::AND: return Boolean(*condition.left) && Boolean(*condition.right); // the right is only evaluated when the left does not decide
+      case NodeType::OR:  return Boolean(*condition.left) || Boolean(*condition.right);
+      case NodeType::XOR: return Boolean(*condition.left) != Boolean(*condition.right);
+      default: break;
+    }
+
+    Value left, right;
+    const auto& lvalue = Scalar(Read(*condition.left, left));
+    return Kernel::Compare(condition.type, lvalue, Scalar(Read(*condition.right, right)));
+  }
+
+  [[nodiscard]] Value Evaluate(const Node& expression) {
+    switch (expression.type) {
+      case NodeType::LITERAL:   return GetNode<Ast::Literal>(expression).value; // numbers and booleans, checked at load time
+      case NodeType::VARIABLE:  return Scalar(Read(GetNode<Ast::Variable>(expression)));
+      case NodeType::SUBSCRIPT: {
+        Value temporary;
+        return Scalar(Subscript(GetNode<Ast::Subscript>(expression), temporary));
+      }
+      case NodeType::SIZE: {
+        Value temporary;
+        const auto& list = Read(*GetNode<Ast::Size>(expression).list, temporary);
+        if (!list.Is<Value::List>()) throw std::invalid_argument("Size operand must be a `list`!");
+        return list.Size();
+      }
+      case NodeType::NONE: throw std::invalid_argument("Expected an expression, but none was provided!");
+      default: break;
+    }
+
+    if (IsCondition(expression.type)) return Condition(GetNode<Ast::Operation>(expression));
+
+    const auto& operation = GetNode<Ast::Operation>(expression); // anything else is rejected at load time
+    const auto left = Evaluate(*operation.left);
+    if (IsUnaryOperation(operation.type)) return Kernel::Arithmetic(operation.type, left, left);
+    return Kernel::Arithmetic(operation.type, left, Evaluate(*operation.right));
+  } // throws `std::bad_variant_access`
+
+  void Run(const Nodes& components) {
+    for (const auto& component : components) Run(*component);
+  }
+
+  void Run(const Node& component) {
+    using namespace std::string_literals;
+    if (++steps > MAX_PARALLEL_STEPS) throw std::runtime_error("Parallel `"s + parallel.key + "` ran past MAX_PARALLEL_STEPS!"s);
+
+    switch (component.type) {
+      case NodeType::COMMENT: break;
+
+      case NodeType::DEFINITION: {
+        const auto& definition = GetNode<Ast::Definition>(component);
+        auto& cell = cells[Local(definition.slot)];
+        if (cell) break; // definitions do not overwrite existing values
+
+        if (definition.expression->type == NodeType::NONE) cell = definition.primitive == Primitive::BOOLEAN ? Value{false} : Value{0};
+        else cell = Evaluate(*definition.expression);
+        primitives[Local(definition.slot)] = definition.primitive;
+        break;
+      }
+      case NodeType::ASSIGNMENT: {
+        const auto& assignment = GetNode<Ast::Assignment>(component);
+        auto value = Evaluate(*assignment.rvalue);
+        Write(*assignment.lvalue) = std::move(value);
+        break;
+      }
+      case NodeType::INCREMENT:
+      case NodeType::DECREMENT: {
+        const int amount = component.type == NodeType::INCREMENT ? 1 : -1;
+        const auto& variable = *GetNode<Ast::Increment>(component).variable;
+        auto& value = Write(variable);
+        if (primitives[Local(variable.slot)] != Primitive::NUMBER) throw std::invalid_argument("Invalid TYPE for UNARY ARITHMETIC expression!");
+
+        if (value.Is<double>()) value = value.As<double>() + amount;
+        else value = value.Get<int>() + amount;
+        break;
+      }
+
+      case NodeType::BRANCH: {
+        const auto& branch = GetNode<Ast::Branch>(component);
+        Run(Boolean(*branch.condition) ? branch.consequent : branch.alternative);
+        break;
+      }
+      case NodeType::REPEAT: {
+        const auto& repeat = GetNode<Ast::Loop>(component);
+        const int times = Evaluate(*repeat.expression).GetNumber<int>();
+        if (times < 0) throw std::range_error("Repeat TIMES is less than 0!");
+        if (times > MAX_REPEAT_LENGTH) throw std::range_error("Repeat TIMES is greater than MAX_REPEAT_LENGTH!");
+        for (int i = 0; i < times; ++i) Run(repeat.components);
+        break;
+      }
+      case NodeType::WHILE: {
+        const auto& loop = GetNode<Ast::Loop>(component);
+        do Run(loop.components); // the body runs before the condition is first tested
+        while (Boolean(*loop.expression));
+        break;
+      }
+
+      default: throw std::invalid_argument("Invalid TYPE provided for component: `" + component.key + "`");
+    }
+  }
+public:
+  Iteration(const Ast::Parallel& parallel, const VariableStore& store, const std::vector<int>& locals)
+  : parallel{parallel}, store{store}, locals{locals}, cells(parallel.locals.size()), primitives(parallel.locals.size()) {
+    primitives.front() = store.Get(parallel.element->slot).GetPrimitive(); // the element keeps the primitive it was defined with
+  }
+
+  // Run the body for `element`, returning the element it ends with
+  [[nodiscard]] Value Run(const Value& element) {
+    for (auto& cell : cells) cell.reset();
+    cells.front() = Scalar(element);
+    steps = 0;
+
+    Run(parallel.components);
+    return *cells.front();
+  }
+};
+
+void RunParallel(const Ast::Parallel& parallel, VariableStore& store) {
+  const auto& list = store.Get(parallel.list->slot).Get();
+  if (!list.Is<Value::List>()) throw std::invalid_argument("Parallel LIST must be a `list`!");
+  (void)store.Get(parallel.element->slot); // assigned each element, as a `foreach` element is
+
+  const int count = list.Size();
+  if (!count) return;
+
+  std::vector<int> locals(*std::max_element(parallel.locals.begin(), parallel.locals.end()) + 1, SHARED);
+  for (int i = 0; i < (int)parallel.locals.size(); ++i) locals[parallel.locals[i]] = i;
+
+  // each range stops at its first failure, so the earliest of them is the earliest of all
+  Value::List elements(count);
+  std::atomic<int> failed = count;
+  std::exception_ptr failure;
+  std::mutex guard;
+
+  auto& pool = ThreadPool::Get();
+  const int grain = std::max(MIN_GRAIN, count / (pool.Size() * RANGES_PER_THREAD));
+  pool.For(count, grain, [&](const int begin, const int end) {
+    Iteration iteration{ parallel, store, locals };
+    Value scratch;
+    for (int i = begin; i < end && i < failed; ++i) {
+      try {
+        elements[i] = iteration.Run(list.Element(i, scratch));
+      } catch (...) {
+        std::lock_guard lock{ guard };
+        if (i < failed) {
+          failed = i;
+          failure = std::current_exception();
+        }
+        return;
+      }
+    }
+  });
+  if (failure) std::rethrow_exception(failure);
+
+  store.Set(parallel.element->slot, elements.back()); // as if the iterations had run in order
+  store.Set(parallel.list->slot, Value{std::move(elements)});
+}
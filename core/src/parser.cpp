@@ -1,184 +1,187 @@
 #include <parser.hpp>
 #include <vec2.hpp>
+#include <governor.hpp>
+
+#include <algorithm>
 
 // Variable and Definition //
 
-Json Parser::ReserveArray(Json list, const std::string elementIdSalt) { 
-  if (list["reserve"].is_null()) return list; // nothing to reserve
+Value Parser::ParseList(const Ast::List& list) {
+  if (list.reserve) return ReserveList(list);
+
+  Value::List elements;
+  elements.reserve(list.elements.size());
+  for (const auto& element : list.elements)
+    elements.push_back(ExtractValue(*element));
 
-  // get fill
-  if (list["fill"].is_null()) throw std::invalid_argument("Reserved list must have a `fill` value!");
-  auto fill = list["fill"];
-  if (!fill.is_object()) throw std::invalid_argument("List fill must be an object!");
+  return Value{std::move(elements)};
+}
 
+Value Parser::ReserveList(const Ast::List& list) {
   // get reserve
-  const auto reserve = ExtractValue<int>(list["reserve"]);
+  const auto reserve = ExtractValue<int>(*list.reserve);
   if (reserve < MIN_ARRAY_SIZE) throw std::range_error("List reserve is less than 0!");
   if (reserve > MAX_ARRAY_SIZE) throw std::range_error("List reserve is greater than MAX_LIST_LENGTH!");
 
+  // a fill that draws no random numbers is evaluated once, but not for an empty list
+  if (list.uniform) return reserve ? Value::Fill(ExtractValue(*list.fill), reserve) : Value{Value::List{}};
+
   // reserve array
-  auto reservedArray = Json::array();
-  for (size_t i = 0; i < reserve; ++i) {
-    // reserve the fill if needed (yes, we do this for each element, a `random` or `increment` might be called downstream)
-    auto reservedFill = fill;
-    if (fill["type"] == "list")
-      reservedFill = ReserveArray(fill, elementIdSalt);
-
-    auto value = CreateLiteral(reservedFill); // compute the value of the fill each element
-    value["id"] = elementIdSalt + std::to_string(i); // append the index to some salt to keep the id unique
-    reservedArray.push_back(value);
-  }
-  list["expression"] = reservedArray;
+  Value::List reservedArray;
+  reservedArray.reserve(reserve);
+  for (size_t i = 0; i < reserve; ++i)
+    // compute the value of the fill each element (yes, we do this for each element, a `random` might be called downstream)
+    reservedArray.push_back(ExtractValue(*list.fill));
 
-  return list;
+  return Value{std::move(reservedArray)};
 }
 
-void Parser::ParseDefinition(Json& definition) {
-  const std::string key = definition["id"];
-  const std::string name = definition["name"];
-  const std::string primitive = definition["primitive"];
+Value Parser::ParseRange(const Ast::Range& range) {
+  const auto start = ExtractValue<int>(*range.start);
+  const auto end = ExtractValue<int>(*range.end);
 
-  using namespace std::string_literals;
-  Log("Pushing variable `"s + key + "` ("s + name + ") of type `"s + primitive);
-
-  if (primitive == "list") {
-    const auto expression = ExtractValue<Json>(definition["expression"]);
-    auto reservedArray = ReserveArray(expression, key);
-
-    store.Add(key, { key, name, primitive, reservedArray });
-  } else {
-    const auto value = ExtractValue(definition["expression"]);
-    store.Add(key, { key, name, primitive, value });
-  }
+  const long long size = (long long)end - start; // empty when `end` is not after `start`
+  if (size > MAX_ARRAY_SIZE) throw std::range_error("Range is longer than MAX_LIST_LENGTH!");
+  return Value::Range(start, size > 0 ? (int)size : 0);
 }
 
-void Parser::ParseAssignment(Json& assignment) {
-  const std::string key = assignment["lvalue"]["definitionId"];
-  auto right = assignment["rvalue"];
+void Parser::ParseDefinition(const Ast::Definition& definition) {
+  const auto& key = definition.key;
 
   using namespace std::string_literals;
-  Log("Parsing assignment of definition id `"s + key + "`"s);
+  Log("Pushing variable `"s + key + "` ("s + definition.name + ") of type `"s + GetPrimitiveName(definition.primitive));
 
-  const auto rvalue = ExtractValue(right); 
-  store.Set(key, rvalue);
+  if (definition.expression->type == NodeType::NONE)
+    store.Add(definition.slot, { key, definition.name, definition.primitive }); // default value of the primitive
+  else
+    store.Add(definition.slot, { key, definition.name, definition.primitive, ExtractValue(*definition.expression) });
 }
 
-// Array //
-
-void Parser::ParseAppend(Json& append) {
-  const std::string type = append["list"]["type"];
-  if (type != "variable") // todo: find a way to make `subscript` work here (appending into multidimensional arrays)
-    throw std::invalid_argument("Append type must be either `variable`"); 
+void Parser::ParseAssignment(const Ast::Assignment& assignment) {
+  auto rvalue = ExtractValue(*assignment.rvalue); // lists are shared until either side is mutated
+  store.Set(assignment.lvalue->slot, std::move(rvalue));
+}
 
-  // get list
-  const std::string key = append["list"]["definitionId"];
-  auto variable = ParseVariable(append["list"]);
-  const auto primitive = variable.GetPrimitive();
-  if (primitive != "list") throw std::invalid_argument("Appending variable must be of `list` primitive!");
-  auto list = variable.Get<Json>();
-  if (!list["expression"].is_array()) throw std::invalid_argument("Appending variable must be an array!");
+// Array //
 
-  list["expression"].push_back(append["item"]);
+// Lists are mutated in place through their variable's slot
+int Parser::ListSlot(const Node& list) const {
+  if (list.type != NodeType::VARIABLE) // todo: find a way to make `subscript` work here (mutating multidimensional arrays)
+    throw std::invalid_argument("List operand must be a `variable`");
+  return GetNode<Ast::Variable>(list).slot;
+}
 
-  store.Set(key, list);
+void Parser::ParseAppend(const Ast::Append& append) {
+  const int slot = ListSlot(*append.list);
+  auto item = ExtractValue(*append.item); // evaluate before editing, the item may read the list
 
-  using namespace std::string_literals;
-  Log("Appending to list `"s + key + "`"s);
+  auto& list = store.EditList(slot);
+  if ((int)list.size() >= MAX_ARRAY_SIZE) throw std::range_error("Append would exceed MAX_LIST_LENGTH!");
+  if (listQuota > 0 && (int)list.size() >= listQuota) throw Governor::Exceeded(Governor::Reason::LIST);
+  list.push_back(std::move(item));
 }
 
-void Parser::ParseSize(Json& pop) {
-  throw std::runtime_error("unimplemented!");
+int Parser::ParseSize(const Ast::Size& size) {
+  Value temporary;
+  const auto& value = ReadValue(*size.list, temporary);
+  if (!value.Is<Value::List>()) throw std::invalid_argument("Size operand must be a `list`!");
+  return value.Size();
 }
 
-void Parser::ParseRemove(Json& remove) {
-  throw std::runtime_error("unimplemented!");
+void Parser::ParseRemove(const Ast::Remove& remove) {
+  const int slot = ListSlot(*remove.list);
+  const auto index = ExtractValue<int>(*remove.index);
+
+  auto& list = store.EditList(slot);
+  const int size = list.size();
+  if (std::abs(index) >= size) throw std::out_of_range("Remove INDEX is out of range!");
+
+  list.erase(list.begin() + (index >= 0 ? index : size + index));
 }
 
 // Loops //
 
-void Parser::ParseRepeat(Json& repeat) {
-  Json& repetition = repeat["repetition"];
+// Loops run their body in a stack that carries the loop's counter; the loop is parsed again at the end of each iteration
+
+void Parser::ParseRepeat(const Ast::Loop& repeat) {
+  if (stackMachine.Iterating(repeat)) {
+    auto& body = stackMachine.Top();
+    if (body.counter + 1 < body.bound) body.Restart();
+    else stackMachine.Pop();
+    return;
+  }
 
-  const int times = ExtractValue<int>(repetition);
+  const int times = ExtractValue<int>(*repeat.expression);
   if (!times) return; // nothing to repeat
   if (times < 0) throw std::range_error("Repeat TIMES is less than 0!");
+  if (times > MAX_REPEAT_LENGTH) throw std::range_error("Repeat TIMES is greater than MAX_REPEAT_LENGTH!");
 
-  Json& components = repeat["components"];
-  if (times < 0 || times > MAX_REPEAT_LENGTH) throw std::range_error("Repeat TIMES is gre/ter than MAX_REPEAT_LENGTH!");
-  if (!components.is_array()) throw std::invalid_argument("Repeat components must be an array!");
-
-  stackMachine.Push(components); // create a new stack for the repeat block body
-
-  const auto instructions = components.size();
-  const auto i = store.Add(0); // initialize `i`
-
-  // create incrementor and conditional jump statements
-  constexpr int EXTRA_INSTRUCTIONS = 2; // `incrementor` and `conditional jump` appended to the stack
-  Json incrementor = Block::Incrementor<Block::ArithmeticOperation::INC, int>(i); // ++i
-  Json repeatCondition = Block::Conditional<Block::BooleanOperation::LT, true, false>(i, times); // counter < times
-  Json jumpIf = Block::ConditionalJump(-(instructions + EXTRA_INSTRUCTIONS), repeatCondition); // jump to the start of the repeat loop
-
-  // push statements into the repeat loops stack
-  stackMachine.PushBlock(incrementor);
-  stackMachine.PushBlock(jumpIf); 
+  stackMachine.Push(repeat.components, &repeat, times); // create a new stack for the repeat block body
 }
 
-void Parser::ParseWhile(Json& loop) {
-  Json& condition = loop["condition"];
-  Json& components = loop["components"];
-  if (!components.is_array()) throw std::invalid_argument("While components must be an array!");
+void Parser::ParseWhile(const Ast::Loop& loop) {
+  if (stackMachine.Iterating(loop)) {
+    if (ExtractValue<bool>(*loop.expression)) stackMachine.Top().Restart();
+    else stackMachine.Pop();
+    return;
+  }
 
-  constexpr int EXTRA_INSTRUCTIONS = 1; // `conditional jump` appended to the stack
-  Json jumpIf = Block::ConditionalJump(-(components.size() + EXTRA_INSTRUCTIONS), condition); // jump to the start of the while loop 
-  stackMachine.Push(components);
-  stackMachine.PushBlock(jumpIf);
+  stackMachine.Push(loop.components, &loop); // the body runs before the condition is first tested
 }
 
-void Parser::ParseForeach(Json& loop) {
-  throw std::runtime_error("unimplemented!");
-}
+// The list is evaluated and checked once on entry, then each element is read in place by the loop's counter
+void Parser::ParseForeach(const Ast::Loop& foreach) {
+  const int element = foreach.element->slot;
+  if (stackMachine.Iterating(foreach)) {
+    auto& body = stackMachine.Top();
+    if (body.counter + 1 < body.bound) {
+      body.Restart();
+      store.Set(element, body.iterable.At(body.counter));
+      return;
+    }
+
+    body.iterable = {}; // release the list, so editing it after the loop does not copy it
+    stackMachine.Pop();
+    return;
+  }
 
-void Parser::ParseForever(Json& forever) {
-  Json& components = forever["components"];
-  if (!components.is_array()) throw std::invalid_argument("Forever components must be an array!");
+  auto list = ExtractValue(*foreach.expression); // shared, not copied
+  if (!list.Is<Value::List>()) throw std::invalid_argument("Foreach LIST must be a `list`!");
+  const int size = list.Size();
+  if (!size) return; // nothing to iterate
 
-  stackMachine.Push(components); // create a new stack for the repeat block body
+  store.Set(element, list.At(0));
+  stackMachine.Push(foreach.components, &foreach, size); // create a new stack for the foreach block body
+  stackMachine.Top().iterable = std::move(list);
+}
 
-  const auto instructions = components.size(); 
-  constexpr int EXTRA_INSTRUCTIONS = 1; // `jump`
-  Json jump = Block::Jump(-(instructions + EXTRA_INSTRUCTIONS)); // jump to the start of the forever loop
-  stackMachine.PushBlock(jump);
+void Parser::ParseForever(const Ast::Loop& forever) {
+  if (stackMachine.Iterating(forever)) stackMachine.Top().Restart();
+  else stackMachine.Push(forever.components, &forever); // create a new stack for the forever block body
 }
 
 // Low-level //
 
-void Parser::ParseJump(Json& jump) {
-  using namespace std::string_literals;
-
-  int instructions = 0;
-  const std::string type = jump["expression"]["type"];
-
-  if (type == "literal") instructions = jump["expression"]["value"];
-  else if (type == "variable") instructions = ParseVariable(jump["expression"]).Get<int>();
-  else throw std::invalid_argument("Invalid expression TYPE provided for JUMP!");
+void Parser::ParseJump(const Ast::Jump& jump) {
+  const auto type = jump.expression->type;
+  if (type != NodeType::LITERAL && type != NodeType::VARIABLE)
+    throw std::invalid_argument("Invalid expression TYPE provided for JUMP!");
 
-  Log("Jumping `"s + std::to_string(instructions) + "` instructions"s);
-  stackMachine.Jump(instructions);
+  stackMachine.Jump(ExtractValue<int>(*jump.expression));
 }
 
-void Parser::ParseConditionJump(Json& jump) {
-  Json& condition = jump["condition"];
-  bool result = ExtractValue<bool>(condition);
+void Parser::ParseConditionJump(const Ast::Jump& jump) {
+  const bool result = ExtractValue<bool>(*jump.condition);
   if (result) ParseJump(jump);
 }
 
 // Rendering //
 
-void Parser::ParseDrawLine(Json& draw) {
-  const auto x1 = ExtractValue<int>(draw["x1"]);
-  const auto y1 = ExtractValue<int>(draw["y1"]);
-  const auto x2 = ExtractValue<int>(draw["x2"]);
-  const auto y2 = ExtractValue<int>(draw["y2"]);
+void Parser::ParseDrawLine(const Ast::Draw& draw) {
+  const auto x1 = ExtractValue<int>(*draw.operands[0]);
+  const auto y1 = ExtractValue<int>(*draw.operands[1]);
+  const auto x2 = ExtractValue<int>(*draw.operands[2]);
+  const auto y2 = ExtractValue<int>(*draw.operands[3]);
 
   const Vec2 start{ x1, y1 };
   const Vec2 end{ x2, y2 };
@@ -186,20 +189,20 @@ void Parser::ParseDrawLine(Json& draw) {
   renderer.DrawLine(start, end);
 }
 
-void Parser::ParseDrawRect(Json& draw) {
-  const auto x = ExtractValue<int>(draw["x"]);
-  const auto y = ExtractValue<int>(draw["y"]);
-  const auto w = ExtractValue<int>(draw["w"]);
-  const auto h = ExtractValue<int>(draw["h"]);
+void Parser::ParseDrawRect(const Ast::Draw& draw) {
+  const auto x = ExtractValue<int>(*draw.operands[0]);
+  const auto y = ExtractValue<int>(*draw.operands[1]);
+  const auto w = ExtractValue<int>(*draw.operands[2]);
+  const auto h = ExtractValue<int>(*draw.operands[3]);
 
   const Rec2 rect{ { x, y }, { w, h } };
 
   renderer.DrawRect(rect);
 }
 
-void Parser::ParseDrawPixel(Json& draw) {
-  const auto x = ExtractValue<int>(draw["x"]);
-  const auto y = ExtractValue<int>(draw["y"]);
+void Parser::ParseDrawPixel(const Ast::Draw& draw) {
+  const auto x = ExtractValue<int>(*draw.operands[0]);
+  const auto y = ExtractValue<int>(*draw.operands[1]);
 
   const Vec2 pixel{ x, y };
 
@@ -208,93 +211,109 @@ void Parser::ParseDrawPixel(Json& draw) {
 
 // Conditions //
 
-[[nodiscard]] bool Parser::ParseCondition(Json& condition) {
-  const std::string type = condition["type"];
-  Json& expression = condition["expression"];
+[[nodiscard]] bool Parser::ParseCondition(const Ast::Operation& condition) {
+  const auto& left = *condition.left;
 
-  using namespace std::string_literals;
-  Log("Parsing conditional expression of type '"s + type + "'"s);
-
-  auto left = expression.at(LVALUE);
-  const auto lvalue = ExtractValue(left);
-
-  if (type == "not") return !std::get<bool>(lvalue);
-
-  if (expression.size() == MAX_BRANCHES) {
-    auto right = expression.at(RVALUE);
-    const auto rvalue = ExtractValue(right);
-    Log("Performing '"s + type + "' on `"s + left.dump() + "` and `"s + right.dump() + "`"s);
-
-    if (type == "and")  return std::get<bool>(lvalue) && std::get<bool>(rvalue);
-    if (type == "or")   return std::get<bool>(lvalue) || std::get<bool>(rvalue);
-    if (type == "xor")  return (std::get<bool>(lvalue) || std::get<bool>(rvalue)) && (std::get<bool>(lvalue) != std::get<bool>(rvalue));
-    if (type == "eq")   return lvalue == rvalue;
-    if (type == "ne")   return lvalue != rvalue;
-    if (type == "gt")   return lvalue > rvalue;
-    if (type == "ge")   return lvalue >= rvalue;
-    if (type == "lt")   return lvalue < rvalue;
-    if (type == "le")   return lvalue <= rvalue;
-    
-    throw std::invalid_argument("'" + type + "' is not a valid TYPE for a BINARY conditional expression");
+  switch (condition.type) {
+    case NodeType::NOT: return !ExtractValue<bool>(left);
+    case NodeType::AND: return ExtractValue<bool>(left) && ExtractValue<bool>(*condition.right); // the right is only evaluated when the left does not decide
+    case NodeType::OR:  return ExtractValue<bool>(left) || ExtractValue<bool>(*condition.right);
+    case NodeType::XOR: return ExtractValue<bool>(left) != ExtractValue<bool>(*condition.right);
+    default: break;
   }
 
-  throw std::invalid_argument("'" + type + "' is not a valid TYPE for a UNARY conditional expression");
+  // comparisons were specialized by operand type at load time
+  const auto& right = *condition.right;
+  switch (condition.operands) {
+    case ValueType::INTEGER: {
+      const auto lvalue = ExtractValue<int>(left);
+      return Kernel::Compare<int>(condition.type, lvalue, ExtractValue<int>(right));
+    }
+    case ValueType::DOUBLE: {
+      const auto lvalue = ExtractValue<double>(left);
+      return Kernel::Compare<double>(condition.type, lvalue, ExtractValue<double>(right));
+    }
+    default: {
+      Value ltemporary, rtemporary;
+      const auto& lvalue = ReadValue(left, ltemporary);
+      return Kernel::Compare(condition.type, lvalue, ReadValue(right, rtemporary));
+    }
+  }
 }
 
-void Parser::ParseBranch(Json& branch) {
-  Json& branches = branch["branches"];
-  if (!branches.is_array()) throw std::invalid_argument("Branches must be an array!");
-  if (branches.size() > MAX_BRANCHES) throw std::invalid_argument("Branches must be an array of size 2 or less!");
-
-  Json& condition = branch["condition"];
-  const bool evaluation = ExtractValue<bool>(condition);
+void Parser::ParseBranch(const Ast::Branch& branch) {
+  const bool evaluation = ExtractValue<bool>(*branch.condition);
 
-  const bool hasElse = branches.size() == MAX_BRANCHES;
-  if (evaluation) stackMachine.Push(branches.at(LVALUE));
-  else if (hasElse) stackMachine.Push(branches.at(RVALUE));
+  const auto& components = evaluation ? branch.consequent : branch.alternative;
+  if (!components.empty()) stackMachine.Push(components);
 }
 
-// Output //
+// Procedures //
 
-void Parser::ParsePrint(Json& print) {
-  PrintExpression(print["expression"]);
-}
-void Parser::PrintExpression(Json& expression) {
+void Parser::ParseCall(const Ast::Call& call) {
   using namespace std::string_literals;
-  const auto& value = ExtractValue(expression);
+  const auto* procedure = call.procedure;
+  if (!procedure) throw std::invalid_argument("Procedure `"s + call.procedureId + "` is not defined!"s);
+
+  const auto& parameters = procedure->parameters;
+  const int count = parameters.size();
+  if ((int)call.arguments.size() != count)
+    throw std::invalid_argument("Procedure `"s + procedure->name + "` takes "s + std::to_string(count) + " arguments!"s);
+
+  arguments.clear();
+  for (const auto& argument : call.arguments) arguments.push_back(ExtractValue(*argument)); // in the caller's frame
+
+  const Ast::Variable* result = call.result.get();
+  bool required = result;
+  if (call.tail) { // the caller returns what the callee does, so the callee replaces it
+    const auto caller = stackMachine.GetFrame();
+    if (result || !caller.required) {
+      result = caller.result;
+      required = required || caller.required;
+      store.SetFrame(stackMachine.Return(), caller.procedure->locals);
+    }
+  }
+
+  store.SetFrame(stackMachine.Call(*procedure, result, required), procedure->locals);
+  for (int i = 0; i < count; ++i) {
+    const auto& parameter = *parameters[i];
+    store.Add(parameter.slot, { parameter.key, parameter.name, parameter.primitive, std::move(arguments[i]) });
+  }
+}
 
-  if (std::holds_alternative<std::string>(value))
-    ClientPrint(std::get<std::string>(value));
+void Parser::ParseReturn(const Ast::Return& ret) {
+  if (!stackMachine.InProcedure()) throw std::runtime_error("RETURN outside of a procedure!");
+  Return(ret.expression.get());
+}
+
+// Leave the innermost call, assigning the value of `expression` to the caller's result
+void Parser::Return(const Node* expression) {
+  const auto frame = stackMachine.GetFrame();
+  if (!expression && frame.required) {
+    using namespace std::string_literals;
+    throw std::runtime_error("Procedure `"s + frame.procedure->name + "` did not return a value!"s);
+  }
 
-  else if (std::holds_alternative<int>(value))
-    ClientPrint(std::get<int>(value));
-  
-  else if (std::holds_alternative<double>(value))
-    ClientPrint(std::get<double>(value));
+  Value value = expression ? ExtractValue(*expression) : Value{};
+  store.SetFrame(stackMachine.Return(), frame.procedure->locals);
+  if (frame.result) store.Set(frame.result->slot, std::move(value));
+}
 
-  else if (std::holds_alternative<bool>(value))
-    ClientPrint(std::get<bool>(value) ? "true" : "false");
+// Output //
 
-  else if (std::holds_alternative<Json>(value)) {
-    const auto& expression = std::get<Json>(value);
-    Log(".");
-    Log(expression);
-    const std::string type = expression["type"];
+void Parser::ParsePrint(const Ast::Print& print) {
+  PrintExpression(*print.expression);
+}
 
-    if (expression.is_null()) ClientPrint("null");
-    else if (type == "list")
-      // recursively print each item in the list
-      for (auto item : expression["expression"])
-        PrintExpression(item);
-    else
-      throw std::invalid_argument("Invalid TYPE for PRINT expression: `"s + type + "`"s);
-  } else
-    throw std::invalid_argument("Invalid TYPE for PRINT expression");
+void Parser::PrintExpression(const Node& expression) {
+  if (outputQuota > 0 && printed >= outputQuota) throw Governor::Exceeded(Governor::Reason::OUTPUT);
+  Value temporary;
+  printed += PrintValue(ReadValue(expression, temporary));
 }
 
 void Parser::ParseClearOutput() {
 #ifdef __EMSCRIPTEN__
-  ClientClearOutput(); 
+  ClientClearOutput();
 #else
   // todo: some native clear implementation
 #endif // __EMSCRIPTEN__
@@ -307,73 +326,173 @@ void Parser::ParseClearScreen() {
 
 // Generic //
 
-bool Parser::ParseComponent(Json& component) {
-  const std::string type = component["type"];
-  
-  using std::string_literals::operator""s;
-  Log("Parsing `"s + type + "` component"s);
+bool Parser::ParseComponent(const Node& component) {
+  currentBlock = &component;
 
-  currentBlockId = component["id"].get<std::string>();
+  switch (component.type) {
+    case NodeType::COMMENT:           return true; // ignore comments
+    case NodeType::EXIT:              scheduler.Stop(); return false; // stop parsing every script
 
-  if (type == "comment")                return true; // ignore comments
-  else if (type == "exit")              return false; // stop parsing
-  
-  else if (type == "definition")        ParseDefinition(component);
-  else if (type == "assignment")        ParseAssignment(component);
+    case NodeType::DEFINITION:        ParseDefinition(GetNode<Ast::Definition>(component)); break;
+    case NodeType::ASSIGNMENT:        ParseAssignment(GetNode<Ast::Assignment>(component)); break;
 
-  else if (type == "branch")            ParseBranch(component);
+    case NodeType::BRANCH:            ParseBranch(GetNode<Ast::Branch>(component)); break;
 
-  else if (type == "print")             ParsePrint(component);
-  else if (type == "clear_output")      ParseClearOutput();
-  else if (type == "clear_screen")      ParseClearScreen();
+    case NodeType::PRINT:             ParsePrint(GetNode<Ast::Print>(component)); break;
+    case NodeType::CLEAR_OUTPUT:      ParseClearOutput(); break;
+    case NodeType::CLEAR_SCREEN:      ParseClearScreen(); break;
 
-  else if (type == "increment")         ParseUnaryArithmetic<Block::ArithmeticOperation::INC>(component["expression"]);
-  else if (type == "decrement")         ParseUnaryArithmetic<Block::ArithmeticOperation::DEC>(component["expression"]);
+    case NodeType::INCREMENT:         ParseUnaryArithmetic<Block::ArithmeticOperation::INC>(*GetNode<Ast::Increment>(component).variable); break;
+    case NodeType::DECREMENT:         ParseUnaryArithmetic<Block::ArithmeticOperation::DEC>(*GetNode<Ast::Increment>(component).variable); break;
 
-  else if (type == "repeat")            ParseRepeat(component);
-  else if (type == "while")             ParseWhile(component);
-  else if (type == "foreach")           ParseForeach(component);
-  else if (type == "forever")           ParseForever(component);
+    case NodeType::REPEAT:            ParseRepeat(GetNode<Ast::Loop>(component)); break;
+    case NodeType::WHILE:             ParseWhile(GetNode<Ast::Loop>(component)); break;
+    case NodeType::FOREACH:           ParseForeach(GetNode<Ast::Loop>(component)); break;
+    case NodeType::FOREVER:           ParseForever(GetNode<Ast::Loop>(component)); break;
+    case NodeType::PARALLEL:          RunParallel(GetNode<Ast::Parallel>(component), store); break;
 
-  else if (type == "jump")              ParseJump(component);
-  else if (type == "conditional_jump")  ParseConditionJump(component);
+    case NodeType::JUMP:              ParseJump(GetNode<Ast::Jump>(component)); break;
+    case NodeType::CONDITIONAL_JUMP:  ParseConditionJump(GetNode<Ast::Jump>(component)); break;
 
-  else if (type == "append")            ParseAppend(component);
-  else if (type == "size")              ParseSize(component);
-  else if (type == "remove")            ParseRemove(component);
+    case NodeType::APPEND:            ParseAppend(GetNode<Ast::Append>(component)); break;
+    case NodeType::SIZE:              (void)ParseSize(GetNode<Ast::Size>(component)); break;
+    case NodeType::REMOVE:            ParseRemove(GetNode<Ast::Remove>(component)); break;
 
-  else if (type == "draw_line")         ParseDrawLine(component);
-  else if (type == "draw_rect")         ParseDrawRect(component);
-  else if (type == "draw_pixel")        ParseDrawPixel(component);
+    case NodeType::DRAW_LINE:         ParseDrawLine(GetNode<Ast::Draw>(component)); break;
+    case NodeType::DRAW_RECT:         ParseDrawRect(GetNode<Ast::Draw>(component)); break;
+    case NodeType::DRAW_PIXEL:        ParseDrawPixel(GetNode<Ast::Draw>(component)); break;
 
-  else                                  throw std::invalid_argument("Invalid TYPE provided for component: `"s + type + "`"s);
+    case NodeType::PROCEDURE:         if (stackMachine.Iterating(component)) Return(nullptr); break; // defining it does nothing, finishing its body returns
+    case NodeType::CALL:              ParseCall(GetNode<Ast::Call>(component)); break;
+    case NodeType::RETURN:            ParseReturn(GetNode<Ast::Return>(component)); break;
+
+    case NodeType::SCRIPT:            break; // started with the program
+    case NodeType::YIELD:             scheduler.Yield(); break;
+    case NodeType::WAIT:              scheduler.Sleep(scheduler.After(ExtractValue<int>(*GetNode<Ast::Wait>(component).duration))); break;
+    case NodeType::WAIT_FRAME:        scheduler.WaitFrame(); break;
+
+    default: throw std::invalid_argument("Invalid TYPE provided for component: `" + component.key + "`");
+  }
 
   return true; // continue parsing
 }
 
-// API //
+// Memoization //
 
-void Parser::ParseComponents(const std::string components) {
-  if (components.empty()) throw std::invalid_argument("Program must not be empty!");
-  program = jsn::json::parse(components);
+// Collect the slots `expression` reads; false when its value depends on anything else
+static bool CollectReads(Node& expression, std::vector<int>& reads) {
+  const auto type = expression.type;
+  if (type == NodeType::RANDOM || type == NodeType::LIST || type == NodeType::NONE) return false; // differ each evaluation, or fail
 
-  if (!program.is_array()) throw std::invalid_argument("Program must be an array!");
-  if (program.empty()) return;
+  if (type == NodeType::VARIABLE) {
+    const int slot = GetNode<Ast::Variable>(expression).slot;
+    if (slot == Ast::UNRESOLVED) return false;
+    if (std::find(reads.begin(), reads.end(), slot) == reads.end()) reads.push_back(slot);
+  }
+
+  bool pure = true;
+  VisitChildren(expression, [&pure, &reads](NodePtr& child) { pure = pure && CollectReads(*child, reads); }, [](Nodes&) { });
+  return pure;
+}
+
+// Memoize operations, conditions, sizes, and subscripts whose value only depends on the variables they read
+void Parser::Memoize(NodePtr& expression) {
+  VisitChildren(*expression, [this](NodePtr& child) { Memoize(child); }, [this](Nodes& body) { Memoize(body); });
+
+  const auto type = expression->type;
+  if (type != NodeType::SIZE && type != NodeType::SUBSCRIPT && !IsCondition(type) && !IsOperation(type)) return;
+
+  Memo memo;
+  if (!CollectReads(*expression, memo.reads)) return;
+
+  memo.versions.resize(memo.reads.size());
+  memos.try_emplace(expression.get(), std::move(memo));
+}
+
+void Parser::Memoize(Nodes& components) {
+  for (auto& component : components)
+    VisitChildren(*component, [this](NodePtr& expression) { Memoize(expression); }, [this](Nodes& body) { Memoize(body); });
+}
+
+std::string Parser::Memoization::ToString() const {
+  const int reads = hits + misses;
+  const int rate = reads ? hits * 100 / reads : 0;
+  return "Memoized: " + std::to_string(hits) + " hits and " + std::to_string(misses) + " misses; " + std::to_string(rate) + "% hit rate";
+}
+
+// API //
+
+void Parser::ParseComponents(AbstractSyntaxTree tree) {
+  program = std::move(tree);
 
   // clear the environment
   stackMachine.Empty();
-  store.Empty();
+  store.Allocate(program.GetSlots(), program.GetOffsets());
+  currentBlock = nullptr;
+
+  memos.clear();
+  memoization = {};
+  printed = 0;
+  executed = 0;
+  if (memoize) Memoize(program.GetTree());
+
+  // each script runs its body in a machine of its own
+  std::vector<int> priorities{ Ast::Script::MIN_PRIORITY };
+  scripts.assign(1, StackMachine{});
+  for (const auto& node : program.GetTree()) {
+    if (node->type != NodeType::SCRIPT) continue;
+    const auto& script = GetNode<Ast::Script>(*node);
+    priorities.push_back(script.priority);
+    scripts.emplace_back().Push(script.components);
+  }
+  scheduler.Reset(priorities);
+
+  if (program.Empty()) return;
 
   // push the top stack
-  stackMachine.Push(program); 
+  stackMachine.Push(program.GetTree());
+}
+
+bool Parser::Switch() {
+  const int running = scheduler.Current();
+  const int next = scheduler.Next();
+  if (next == running) return !scheduler.Idle();
+
+  std::swap(stackMachine, scripts[running]);
+  std::swap(stackMachine, scripts[next]);
+  static const std::vector<int> GLOBALS{};
+  store.SetFrame(stackMachine.GetLocals(), stackMachine.InProcedure() ? stackMachine.GetFrame().procedure->locals : GLOBALS);
+  return true;
 }
 
 bool Parser::Next() {
-  if (Json* component = stackMachine.Next())
+  if (const Node* component = stackMachine.Next())
     return ParseComponent(*component);
   return false;
 }
 
+bool Parser::Run(int instructions) {
+  if (scheduler.Idle() && !Switch()) return true; // every script is still waiting
+  for (; instructions > 0; --instructions) {
+    ++executed;
+    if (Next()) {
+      if (!scheduler.Spend() && !Switch()) return true; // every script is waiting
+      continue;
+    }
+
+    if (!scheduler.Finish()) return false; // every script has finished
+    if (!Switch()) return true;
+  }
+  return true;
+}
+
+std::pair<size_t, int> Parser::Measure() const {
+  auto [bytes, longest] = store.Measure();
+  bytes += stackMachine.GetFrames().Footprint(longest);
+  for (const auto& script : scripts) bytes += script.GetFrames().Footprint(longest); // the running script's machine was swapped out for an empty one
+  return { bytes, longest };
+}
+
 // Construction //
 
-Parser::Parser(Renderer& renderer) : stackMachine(), store(), renderer(renderer) { }
\ No newline at end of file
+Parser::Parser(Renderer& renderer) : stackMachine(), store(), renderer(renderer) { }
@@ -0,0 +1,111 @@
+#include <peephole.hpp>
+#include <print.hpp>
+
+#include <optional>
+
+// Helpers //
+
+// The operand loaded into `reg` by `instruction`, when it is a `LOAD` or `LOAD_CONSTANT`
+static std::optional<int> GetOperand(const Instruction& instruction, const int reg) {
+  if (instruction.a != reg) return std::nullopt;
+  if (instruction.op == Opcode::LOAD) return instruction.b;
+  if (instruction.op == Opcode::LOAD_CONSTANT) return ConstantOperand(instruction.b);
+  return std::nullopt;
+}
+
+static int GetDrawOperands(const Opcode op) {
+  switch (op) {
+    case Opcode::DRAW_LINE:
+    case Opcode::DRAW_RECT:   return 4;
+    case Opcode::DRAW_PIXEL:  return 2;
+    default:                  return 0;
+  }
+}
+
+static NodeType GetDrawType(const Opcode op) {
+  if (op == Opcode::DRAW_LINE) return NodeType::DRAW_LINE;
+  if (op == Opcode::DRAW_RECT) return NodeType::DRAW_RECT;
+  return NodeType::DRAW_PIXEL;
+}
+
+void Peephole::Fused(const Bytecode& bytecode, const int at, const char* name) const {
+  using namespace std::string_literals;
+  const auto* source = bytecode.sources[at];
+  Log("Fused `"s + name + "` at "s + std::to_string(at) + (source ? " for block `"s + source->key + "`"s : ""s));
+}
+
+// Fusions //
+
+// STEP counter; JUMP_COMPARE_INTEGER< counter, bound, loop
+bool Peephole::FuseLoop(Bytecode& bytecode, const int at) {
+  auto& code = bytecode.code;
+  if (at + 1 >= (int)code.size()) return false;
+
+  const auto& step = code[at];
+  const auto& test = code[at + 1];
+  if (step.op != Opcode::STEP || test.op != Opcode::JUMP_COMPARE_INTEGER || test.operation != NodeType::LT || test.a != step.a) return false;
+
+  code[at] = { Opcode::LOOP, NodeType::NONE, test.a, test.b, test.c };
+  ++report.loops;
+  Fused(bytecode, at, "loop");
+  return true;
+}
+
+// LOAD left; LOAD right; JUMP_COMPARE left, right, target
+bool Peephole::FuseComparison(Bytecode& bytecode, const int at) {
+  auto& code = bytecode.code;
+  if (at + 2 >= (int)code.size()) return false;
+
+  const auto& jump = code[at + 2];
+  if (jump.op != Opcode::JUMP_COMPARE && jump.op != Opcode::JUMP_COMPARE_INTEGER) return false;
+
+  const auto left = GetOperand(code[at], jump.a);
+  const auto right = GetOperand(code[at + 1], jump.b);
+  if (!left || !right) return false;
+
+  const auto op = jump.op == Opcode::JUMP_COMPARE ? Opcode::JUMP_COMPARE_OPERANDS : Opcode::JUMP_COMPARE_INTEGER_OPERANDS;
+  code[at] = { op, jump.operation, *left, *right, jump.c };
+  ++report.comparisons;
+  Fused(bytecode, at, "comparison");
+  return true;
+}
+
+// LOAD base; LOAD base + 1; ... DRAW_* base
+bool Peephole::FuseDraw(Bytecode& bytecode, const int at) {
+  auto& code = bytecode.code;
+  const int base = code[at].a;
+
+  // find the draw the loads lead to
+  int end = at;
+  while (end < (int)code.size() && GetOperand(code[end], base + end - at)) ++end;
+  const int loads = end - at;
+  if (end >= (int)code.size() || !loads) return false;
+
+  const auto& draw = code[end];
+  if (GetDrawOperands(draw.op) != loads || draw.a != base) return false;
+
+  const int offset = bytecode.operands.size();
+  for (int i = at; i < end; ++i) bytecode.operands.push_back(*GetOperand(code[i], base + i - at));
+
+  code[at] = { Opcode::DRAW_OPERANDS, GetDrawType(draw.op), offset, loads };
+  ++report.draws;
+  Fused(bytecode, at, "draw");
+  return true;
+}
+
+// API //
+
+std::string Peephole::Report::ToString() const {
+  return "Fused " + std::to_string(loops) + " loops, "
+    + std::to_string(comparisons) + " comparisons, and "
+    + std::to_string(draws) + " draws";
+}
+
+Peephole::Report Peephole::Fuse(Bytecode& bytecode) {
+  report = {};
+  for (int at = 0; at < (int)bytecode.code.size(); ++at)
+    (void)(FuseLoop(bytecode, at) || FuseComparison(bytecode, at) || FuseDraw(bytecode, at));
+
+  Log(report.ToString());
+  return report;
+}
@@ -26,13 +26,21 @@ Renderer& Renderer::operator=(Renderer&& other) noexcept {
   return *this;
 }
 
+void Renderer::Trace(const char* operation, std::initializer_list<int> operands) const {
+  std::cout << operation;
+  for (const int operand : operands) std::cout << ' ' << operand;
+  std::cout << '\n';
+}
+
 void Renderer::DrawLine(const Vec2 a, const Vec2 b, const Color color) {
+  if (trace) Trace("line", { a.x, a.y, b.x, b.y });
   SetColor(color);
   if (SDL_RenderDrawLine(renderer, a.x, a.y, b.x, b.y))
     throw SDL2Exception(SDL_GetError());
 }
 
 void Renderer::DrawRect(const Rec2 rect, const Color color, const Color fill) {
+  if (trace) Trace("rect", { rect.position.x, rect.position.y, rect.size.x, rect.size.y });
   if (color.alpha) {
     SetColor(color);
     const auto r = toSDLRect(rect);
@@ -46,6 +54,7 @@ void Renderer::DrawRect(const Rec2 rect, const Color color, const Color fill) {
 }
 
 void Renderer::DrawPixel(const Vec2 vec, const Color color) {
+  if (trace) Trace("pixel", { vec.x, vec.y });
   SetColor(color);
   if (SDL_RenderDrawPoint(renderer, vec.x, vec.y))
     throw SDL2Exception(SDL_GetError());
@@ -1,20 +1,16 @@
 #include <runtime.hpp>
+#include <messages.hpp>
+#include <thread>
 #ifdef __EMSCRIPTEN__
 #include <emscripten/emscripten.h>
 #include <emscripten/bind.h>
 #endif // __EMSCRIPTEN__
 
-constexpr auto startMessageStart = "<span style=\"color:var(--colors-text2);\">program started at ";
-constexpr auto startMessageEnd = "</span><br/><br/>";
-constexpr auto doneMessageStart = "<span style=\"color:var(--colors-text2);\">program completed in "; 
-constexpr auto doneMessageEnd = "</span><br/><br/>";
-constexpr auto errorMessageStart = "<div style=\"color:var(--colors-onError);background-color:var(--colors-error);border-radius:8px;padding:8px\"><strong>Component</strong> encountered an error:<div style=\"padding:8px;\">";
-constexpr auto errorMessageEnd = "</div></div><br/><br/>";
-
 Runtime::Runtime()
 : window{ "Component", Window::centered, { (int)DEFAULT_RESOLUTION, (int)(DEFAULT_RESOLUTION / DEFAULT_ASPECT_RATIO) }, { .opengl = true } },
   renderer{ window, { } }, 
   parser{ renderer },
+  machine{ renderer },
   running{ false } {
   Log("Constructed runtime");
 }
@@ -24,21 +20,44 @@ Runtime::~Runtime() { Terminate(); }
 void Runtime::Run() {
   running = true;
   runtime.Start();
+  governor.Start();
+  const auto& quotas = governor.GetQuotas(); // the engines enforce these as they append and print
+  if (engine == Engine::bytecode) machine.SetQuotas(quotas.list, quotas.output);
+  else parser.SetQuotas(quotas.list, quotas.output);
   #ifdef __EMSCRIPTEN__
   emscripten_set_main_loop_arg(Cycle, this, USE_BROWSER_FPS, SIMULATE_INFINITE_LOOP);
   #else
-  while (running) Cycle();
+  while (running) {
+    const auto start = Time::Now();
+    Cycle();
+
+    // sleep while every script waits, until the first deadline or the next frame
+    auto& scheduler = GetScheduler();
+    if (running && !deterministic && scheduler.Idle()) std::this_thread::sleep_until(std::min(scheduler.Wakes(), start + FRAME_TIME));
+  }
   #endif // __EMSCRIPTEN__
 }
 
 void Runtime::Cycle() {
   const auto start = Time::Now();
+  auto& scheduler = GetScheduler();
+  scheduler.Frame(FRAME_TIME); // scripts waiting for the next frame resume
 
   try {
-    // process as many instructions as possible in `CLOCK_SPEED` milliseconds
-    while (!Time::Elapsed(start, CLOCK_SPEED)) {
-      if (parser.Next()) continue; // next instruction
+    if (!Govern()) return;
+
+    // process as many instructions as possible in `CLOCK_SPEED` milliseconds, or exactly `INSTRUCTIONS_PER_FRAME` when deterministic; either until every script is waiting
+    for (int budget = INSTRUCTIONS_PER_FRAME; deterministic ? budget > 0 : !Time::Elapsed(start, CLOCK_SPEED); budget -= INSTRUCTIONS_PER_CLOCK_CHECK) {
+      if (Step(INSTRUCTIONS_PER_CLOCK_CHECK)) {
+        if (!governor.Charge(GetExecuted())) { // compiled loops may run more than the batch
+          Stop();
+          break;
+        }
+        if (scheduler.Idle()) break; // nothing to run until a script wakes
+        continue; // next instructions
+      }
 
+      if (!Govern()) break; // lists built without `append` are measured before the program counts as completed
       Terminate();
       ClientPrint(doneMessageStart + runtime.ElapsedTimestamp() + doneMessageEnd); 
 
@@ -46,8 +65,11 @@ void Runtime::Cycle() {
     }
 
     PresentCanvas();
+  } catch (const Governor::Exceeded& e) {
+    governor.Trip(e.reason); // an engine stopped a list or the output from growing past its quota
+    Stop();
   } catch (const std::exception& e) { 
-    const auto message = std::string{errorMessageStart} + "Parsing Block: " + std::string{parser.GetCurrentBlockId()} + "<br/>" + std::string{e.what()} + std::string{errorMessageEnd};
+    const auto message = std::string{errorMessageStart} + "Parsing Block: " + GetCurrentBlockId() + "<br/>" + std::string{e.what()} + std::string{errorMessageEnd};
     ClientPrint(message); 
 
 #ifdef __NOEXCEPT__
@@ -63,18 +85,54 @@ void Runtime::Cycle() {
   }
 }
 
+bool Runtime::Govern() {
+  const auto [memory, longest] = governor.Measures() ? Measure() : std::pair<size_t, int>{ 0, 0 }; // walking the variables is the costly part
+  if (governor.Check(memory, longest, GetPrinted())) return true;
+
+  Stop();
+  return false;
+}
+
+void Runtime::Stop() {
+  Terminate();
+  ClientPrint(stopMessageStart + governor.Describe() + stopMessageEnd);
+}
+
 void Runtime::Terminate() {
 #ifdef __EMSCRIPTEN__
   emscripten_cancel_main_loop();
 #endif // __EMSCRIPTEN__
+  if (running && memoize && engine == Engine::tree) Log(parser.GetMemoization().ToString());
   running = false;
   runtime.Stop();
 }
 
+std::string Runtime::Transpile(const std::string& ast) const {
+  if (ast.empty()) throw std::runtime_error("No program to transpile");
+  auto program = ParseProgram(ast);
+  if (optimize) Optimizer{}.Optimize(program);
+  TypeInference{}.Infer(program); // native types are taken from its proofs
+
+  return Transpiler{}.Transpile(program);
+}
+
 void Runtime::Load(std::string ast) {
   try {
     if (ast.empty()) throw std::runtime_error("No program to load");
-    parser.ParseComponents(ast);
+    governor.Reset(); // a cancel from here on stops this program
+    auto program = ParseProgram(ast);
+    if (optimize) Optimizer{}.Optimize(program);
+    TypeInference{}.Infer(program); // the engines rely on its proofs, so it always runs
+
+    if (engine == Engine::bytecode) {
+      machine.SetTiered(tiered && !deterministic);
+      machine.Load(program);
+    } else {
+      parser.SetMemoize(memoize);
+      parser.ParseComponents(program);
+    }
+    GetScheduler().SetSimulated(deterministic);
+    if (deterministic) Random::Seed(DETERMINISTIC_SEED);
     Log("Load Successful");
   } catch(const std::exception& e) {
     Log(e.what());
@@ -82,3 +140,9 @@ void Runtime::Load(std::string ast) {
     Log("An unhandled exception was thrown while parsing program");
   }
 }
+
+Runtime::Engine Runtime::ParseEngine(const std::string& name) {
+  if (name == "tree") return Engine::tree;
+  if (name == "bytecode") return Engine::bytecode;
+  throw std::invalid_argument("Unknown engine `" + name + "`; expected `tree` or `bytecode`");
+}
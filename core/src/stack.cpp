@@ -1,11 +1,11 @@
 #include <stack.hpp>
 
-Stack::Stack() : componentPointer(0), components(Json::array()) { }
+static const Nodes EMPTY_STACK{};
 
-Stack::Stack(Json& components)
-    : componentPointer(0), components(components) {
-    if (!Check()) throw std::invalid_argument("Stack components must be an array with at least one element");
-}
+Stack::Stack() : componentPointer(0), components(&EMPTY_STACK), loop(nullptr), counter(0), bound(0) { }
+
+Stack::Stack(const Nodes& components, const Node* loop, const int bound)
+    : componentPointer(0), components(&components), loop(loop), counter(0), bound(bound) { }
 
 void Stack::Jump(const int instructions) {
     const bool underflow = componentPointer + instructions < 0;
@@ -13,4 +13,4 @@ void Stack::Jump(const int instructions) {
     if (underflow || overflow) throw std::range_error("JUMP operation out of range");
 
     componentPointer += instructions;
-}
\ No newline at end of file
+}
@@ -1,26 +1,51 @@
 #include <stackMachine.hpp>
 
-[[nodiscard]] Json* StackMachine::Next() { // Get a pointer to the next component
-  if (stacks.empty()) {
+#include <algorithm>
+
+StackMachine::StackMachine() : stacks(INITIAL_STACK_SIZE) { }
+
+[[nodiscard]] const Node* StackMachine::Next() { // Get a pointer to the next component
+  if (!depth) {
     Log("No stacks to process!");
     return nullptr;
   }
 
-  if (Json* component = stacks.top().Next()) return component; // return the next component from the top stack
+  while (true) {
+    auto& top = Top();
+    if (const Node* component = top.Next()) return component; // return the next component from the top stack
+    if (const Node* loop = top.GetLoop()) return loop; // the body of a loop has finished, the loop decides whether to iterate again
 
-  if (stacks.size() > 1) { 
-    Pop(); // the top stack is empty, pop
-    return Next(); // get the next component from the new top stack
+    if (depth == 1) return nullptr; // if there are no more stacks, return nullptr
+    Pop(); // the top stack is empty, pop and get the next component from the new top stack
   }
-
-  return nullptr; // if there are no more stacks, return nullptr
 }
 
-void StackMachine::Push(Json& components) { /// Push a new stack onto the stack machine
+void StackMachine::Grow() {
   OverflowInvariant();
-  stacks.emplace(components); 
+  if (depth == (int)stacks.size()) stacks.resize(std::min((int)stacks.size() * 2, MAX_STACK_SIZE));
 }
+
+void StackMachine::Push(const Nodes& components, const Node* loop, const int bound) { /// Push a new stack onto the stack machine
+  Grow();
+  stacks[depth++] = Stack{ components, loop, bound };
+}
+
 void StackMachine::Push() { // Push an empty stack onto the stack machine
-  OverflowInvariant();
-  stacks.emplace();
-}
\ No newline at end of file
+  Grow();
+  stacks[depth++] = Stack{};
+}
+
+std::optional<Variable>* StackMachine::Call(const Ast::Procedure& procedure, const Ast::Variable* result, const bool required) {
+  Grow();
+  auto* frame = locals.Push(procedure.locals.size());
+  frames.push_back({ &procedure, result, required, depth });
+  stacks[depth++] = Stack{ procedure.components, &procedure }; // the procedure returns once its body is exhausted
+  return frame;
+}
+
+std::optional<Variable>* StackMachine::Return() {
+  const int base = frames.back().depth;
+  while (depth > base) stacks[--depth].iterable = {}; // release lists held by loops left early
+  frames.pop_back();
+  return locals.Pop();
+}
@@ -0,0 +1,104 @@
+#include <threadPool.hpp>
+
+#include <algorithm>
+
+ThreadPool::ThreadPool() {
+#ifdef __EMSCRIPTEN__
+  const int threads = 1;
+#else
+  const int threads = std::max(1u, std::thread::hardware_concurrency());
+#endif // __EMSCRIPTEN__
+
+  for (int i = 0; i < threads; ++i) queues.push_back(std::make_unique<Queue>());
+  for (int i = 0; i + 1 < threads; ++i) workers.emplace_back(&ThreadPool::Work, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard lock{ mutex };
+    stopping = true;
+  }
+  wake.notify_all();
+  for (auto& worker : workers) worker.join();
+}
+
+ThreadPool& ThreadPool::Get() {
+  static ThreadPool pool;
+  return pool;
+}
+
+void ThreadPool::Work(const int self) {
+  unsigned seen = 0;
+  while (true) {
+    {
+      std::unique_lock lock{ mutex };
+      wake.wait(lock, [this, &seen] { return stopping || generation != seen; });
+      if (stopping) return;
+      seen = generation;
+    }
+    Drain(self);
+  }
+}
+
+bool ThreadPool::Take(const int self, Range& range) {
+  const int count = queues.size();
+  for (int i = 0; i < count; ++i) {
+    auto& queue = *queues[(self + i) % count];
+    std::lock_guard lock{ queue.mutex };
+    if (queue.ranges.empty()) continue;
+
+    // the owner works through its ranges in order, thieves take the furthest from it
+    if (i == 0) {
+      range = queue.ranges.front();
+      queue.ranges.pop_front();
+    } else {
+      range = queue.ranges.back();
+      queue.ranges.pop_back();
+    }
+    return true;
+  }
+  return false;
+}
+
+void ThreadPool::Drain(const int self) {
+  Range range;
+  while (Take(self, range)) {
+    (*body)(range.first, range.second);
+    if (pending.fetch_sub(1) != 1) continue;
+
+    std::lock_guard lock{ mutex }; // the last range, the calling thread may be about to wait
+    done.notify_all();
+  }
+}
+
+void ThreadPool::For(const int count, const int grain, const Body& body) {
+  if (count <= 0) return;
+  const int size = std::max(grain, 1);
+  if (workers.empty() || count <= size) {
+    body(0, count);
+    return;
+  }
+
+  // each thread is dealt a stretch of neighbouring ranges
+  const int ranges = (count + size - 1) / size;
+  const int threads = queues.size();
+  ThreadPool::body = &body;
+  pending = ranges;
+  for (int i = 0; i < threads; ++i) {
+    auto& queue = *queues[i];
+    std::lock_guard lock{ queue.mutex };
+    const int first = (long long)ranges * i / threads;
+    const int last = (long long)ranges * (i + 1) / threads;
+    for (int range = first; range < last; ++range) queue.ranges.emplace_back(range * size, std::min(count, (range + 1) * size));
+  }
+
+  {
+    std::lock_guard lock{ mutex };
+    ++generation;
+  }
+  wake.notify_all();
+
+  Drain(threads - 1);
+  std::unique_lock lock{ mutex };
+  done.wait(lock, [this] { return pending == 0; });
+}
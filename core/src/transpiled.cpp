@@ -0,0 +1,36 @@
+#include <transpiled.hpp>
+#include <messages.hpp>
+#include <window.hpp>
+
+#include <string_view>
+
+constexpr double DEFAULT_RESOLUTION = 1024.0; // the `Runtime` canvas
+constexpr double DEFAULT_ASPECT_RATIO = 16.0 / 9.0;
+constexpr int FIRST_OPTION_ARG = 1;
+constexpr std::string_view TRACE_OPTION = "--trace";
+
+int Transpiled::Main(int argc, char* argv[], Program program) {
+  Window window{ "Component", Window::centered, { (int)DEFAULT_RESOLUTION, (int)(DEFAULT_RESOLUTION / DEFAULT_ASPECT_RATIO) }, { .opengl = true } };
+  Renderer renderer{ window, { } };
+  for (int i = FIRST_OPTION_ARG; i < argc; ++i)
+    if (argv[i] == TRACE_OPTION) renderer.SetTrace(true);
+
+  Context context{ renderer };
+  Time::Timer timer;
+  timer.Start();
+
+  try {
+    try {
+      program(context);
+    } catch (const Exit&) { } // finished within a procedure
+    timer.Stop();
+    ClientPrint(doneMessageStart + timer.ElapsedTimestamp() + doneMessageEnd);
+  } catch (const std::exception& e) {
+    ClientPrint(std::string{errorMessageStart} + "Parsing Block: " + context.block + "<br/>" + std::string{e.what()} + std::string{errorMessageEnd});
+    renderer.Present();
+    return EXIT_FAILURE;
+  }
+
+  renderer.Present();
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,682 @@
+#include <transpiler.hpp>
+
+#include <cmath>
+#include <cctype>
+#include <cstdio>
+#include <algorithm>
+
+using namespace std::string_literals;
+
+static std::string Upper(std::string name) {
+  std::transform(name.begin(), name.end(), name.begin(), [](const unsigned char c) { return std::toupper(c); });
+  return name;
+}
+
+static std::string GetNodeTypeName(const NodeType type) { return "NodeType::"s + Upper(GetNodeName(type)); }
+static std::string GetPrimitiveTypeName(const Primitive primitive) { return "Primitive::"s + Upper(GetPrimitiveName(primitive)); }
+
+// Operators that apply to native operands directly, `nullptr` where the `Kernel` is called
+static const char* GetInfix(const NodeType type, const bool integer) {
+  switch (type) {
+    case NodeType::ADD:       return "+";
+    case NodeType::SUBTRACT:  return "-";
+    case NodeType::MULTIPLY:  return "*";
+    case NodeType::DIVIDE:    return "/";
+    case NodeType::MODULO:    return integer ? "%" : nullptr;
+
+    case NodeType::EQ:        return "==";
+    case NodeType::NE:        return "!=";
+    case NodeType::GT:        return ">";
+    case NodeType::GE:        return ">=";
+    case NodeType::LT:        return "<";
+    case NodeType::LE:        return "<=";
+    default:                  return nullptr;
+  }
+}
+
+static std::string Infix(const std::string& lvalue, const char* infix, const std::string& rvalue) {
+  return "("s + lvalue + " " + infix + " " + rvalue + ")";
+}
+
+// Helpers //
+
+Transpiler::Type Transpiler::GetType(const ValueType type) {
+  switch (type) {
+    case ValueType::INTEGER:  return Type::INTEGER;
+    case ValueType::DOUBLE:   return Type::DOUBLE;
+    case ValueType::BOOLEAN:  return Type::BOOLEAN;
+    default:                  return Type::VALUE;
+  }
+}
+
+const char* Transpiler::GetTypeName(const Type type) {
+  switch (type) {
+    case Type::INTEGER: return "int";
+    case Type::DOUBLE:  return "double";
+    case Type::BOOLEAN: return "bool";
+    default:            return "Value";
+  }
+}
+
+std::string Transpiler::Quote(const std::string& text) {
+  std::string quoted = "\"";
+  for (const unsigned char c : text) {
+    switch (c) {
+      case '"':   quoted += "\\\""; break;
+      case '\\':  quoted += "\\\\"; break;
+      case '\n':  quoted += "\\n"; break;
+      case '\r':  quoted += "\\r"; break;
+      case '\t':  quoted += "\\t"; break;
+      default:
+        if (c < ' ' || c == 0x7f) {
+          char escape[8];
+          std::snprintf(escape, sizeof escape, "\\%03o", c); // octal escapes end after three digits
+          quoted += escape;
+        } else quoted += c;
+    }
+  }
+  return quoted + "\"";
+}
+
+bool Transpiler::IsSimple(const Node& expression) {
+  return expression.type == NodeType::LITERAL;
+}
+
+void Transpiler::Line(const std::string& line) {
+  code.append(indent * 2, ' ');
+  code += line;
+  code += '\n';
+}
+
+void Transpiler::Open(const std::string& line) {
+  Line(line.empty() ? "{" : line + " {");
+  ++indent;
+}
+
+void Transpiler::Close(const std::string& line) {
+  --indent;
+  Line(line);
+}
+
+// Expressions //
+
+// Numbers and booleans read from variables and literals convert as `Value`s do, so a mismatch throws as it does in the interpreter
+std::string Transpiler::Convert(const Expression& expression, const Type type) const {
+  const auto& code = expression.code;
+  if (expression.type == type) return code;
+
+  switch (type) {
+    case Type::VALUE: return "Value{"s + code + "}";
+
+    case Type::INTEGER:
+    case Type::DOUBLE: {
+      const auto number = "GetNumber<"s + GetTypeName(type) + ">()";
+      if (expression.type == Type::VALUE) return code + "." + number;
+      if (expression.type == Type::BOOLEAN && !expression.computed) return "Value{"s + code + "}." + number;
+      return "static_cast<"s + GetTypeName(type) + ">(" + code + ")";
+    }
+
+    case Type::BOOLEAN:
+      if (expression.type == Type::VALUE) return code + ".Get<bool>()";
+      if (!expression.computed) return "Value{"s + code + "}.Get<bool>()";
+      return "static_cast<bool>("s + code + ")";
+  }
+  return code;
+}
+
+std::string Transpiler::Sequence(
+  const Node& left, const Node& right, const Type type, const std::string& lvalue, const std::string& rvalue,
+  const std::function<std::string(const std::string&, const std::string&)>& combine
+) {
+  if (IsSimple(left) || IsSimple(right)) return combine(lvalue, rvalue);
+
+  const auto declaration = type == Type::VALUE ? "const auto& l = "s : "const "s + GetTypeName(type) + " l = ";
+  return "[&] { "s + declaration + lvalue + "; return " + combine("l", rvalue) + "; }()";
+}
+
+Transpiler::Expression Transpiler::TranspileLiteral(const Value& value) {
+  switch (value.GetType()) {
+    case Value::Type::INTEGER: {
+      const int integer = value.As<int>();
+      const auto code = std::to_string(integer);
+      return { integer < 0 ? "(" + code + ")" : code, Type::INTEGER, false };
+    }
+
+    case Value::Type::DOUBLE: {
+      const double real = value.As<double>();
+      if (std::isnan(real)) return { "std::numeric_limits<double>::quiet_NaN()", Type::DOUBLE, false };
+      if (std::isinf(real)) return { real > 0 ? "std::numeric_limits<double>::infinity()" : "(-std::numeric_limits<double>::infinity())", Type::DOUBLE, false };
+
+      char buffer[32];
+      std::snprintf(buffer, sizeof buffer, "%.17g", real); // round trips
+      std::string code = buffer;
+      if (code.find_first_of(".e") == std::string::npos) code += ".0";
+      return { std::signbit(real) ? "(" + code + ")" : code, Type::DOUBLE, false };
+    }
+
+    case Value::Type::BOOLEAN:
+      return { value.As<bool>() ? "true" : "false", Type::BOOLEAN, false };
+
+    case Value::Type::STRING: {
+      const auto& text = value.Get<std::string>();
+      auto it = std::find(strings.begin(), strings.end(), text);
+      if (it == strings.end()) it = strings.insert(strings.end(), text);
+      return { "s" + std::to_string(it - strings.begin()), Type::VALUE, false };
+    }
+
+    case Value::Type::LIST: break;
+  }
+  throw std::invalid_argument("Invalid literal type provided!");
+}
+
+Transpiler::Expression Transpiler::TranspileList(const Ast::List& list) {
+  if (list.reserve) {
+    const auto reserve = Transpile(*list.reserve, Type::INTEGER);
+    if (list.uniform) return { "Transpiled::Fill("s + reserve + ", [&] { return " + Transpile(*list.fill, Type::VALUE) + "; })", Type::VALUE, true };
+    return { "Transpiled::Reserve("s + reserve + ", [&] { return " + Transpile(*list.fill, Type::VALUE) + "; })", Type::VALUE, true };
+  }
+
+  std::string elements;
+  for (const auto& element : list.elements) {
+    if (!elements.empty()) elements += ", ";
+    elements += Transpile(*element, Type::VALUE);
+  }
+  return { "Transpiled::List({ "s + elements + " })", Type::VALUE, true };
+}
+
+Transpiler::Expression Transpiler::TranspileOperation(const Ast::Operation& operation) {
+  const auto name = GetNodeTypeName(operation.type);
+  const bool unary = IsUnaryOperation(operation.type);
+  const auto type = GetType(operation.valueType);
+
+  // proven operands take the native kernels
+  if (type == Type::INTEGER || type == Type::DOUBLE) {
+    const std::string kind = GetTypeName(type);
+    const auto lvalue = Transpile(*operation.left, type);
+    if (unary) return { "Kernel::Unary<" + kind + ">(" + name + ", " + lvalue + ")", type, true };
+
+    const auto rvalue = Transpile(*operation.right, type);
+    const char* infix = GetInfix(operation.type, type == Type::INTEGER);
+    return { Sequence(*operation.left, *operation.right, type, lvalue, rvalue, [&](const std::string& l, const std::string& r) {
+      return infix ? Infix(l, infix, r) : "Kernel::Binary<" + kind + ">(" + name + ", " + l + ", " + r + ")";
+    }), type, true };
+  }
+
+  // anything else dispatches on the values it reads
+  const auto lvalue = Transpile(*operation.left, Type::VALUE);
+  if (unary) return { "Transpiled::Arithmetic(" + name + ", " + lvalue + ")", Type::VALUE, true };
+
+  const auto rvalue = Transpile(*operation.right, Type::VALUE);
+  return { Sequence(*operation.left, *operation.right, Type::VALUE, lvalue, rvalue, [&](const std::string& l, const std::string& r) {
+    return "Kernel::Arithmetic(" + name + ", " + l + ", " + r + ")";
+  }), Type::VALUE, true };
+}
+
+Transpiler::Expression Transpiler::TranspileCondition(const Ast::Operation& condition) {
+  const auto& left = *condition.left;
+  const auto lboolean = [&]() { return Transpile(left, Type::BOOLEAN); };
+  const auto rboolean = [&]() { return Transpile(*condition.right, Type::BOOLEAN); };
+
+  switch (condition.type) {
+    case NodeType::NOT: return { "(!" + lboolean() + ")", Type::BOOLEAN, true };
+    case NodeType::AND: return { Infix(lboolean(), "&&", rboolean()), Type::BOOLEAN, true }; // short-circuits as the interpreter does
+    case NodeType::OR:  return { Infix(lboolean(), "||", rboolean()), Type::BOOLEAN, true };
+    case NodeType::XOR: {
+      const auto lvalue = lboolean();
+      return { Sequence(left, *condition.right, Type::BOOLEAN, lvalue, rboolean(), [](const std::string& l, const std::string& r) {
+        return Infix(l, "!=", r);
+      }), Type::BOOLEAN, true };
+    }
+    default: break;
+  }
+
+  // comparisons were specialized by operand type at load time
+  const auto& right = *condition.right;
+  const auto type = GetType(condition.operands);
+  if (type == Type::INTEGER || type == Type::DOUBLE) {
+    const auto lvalue = Transpile(left, type);
+    const char* infix = GetInfix(condition.type, type == Type::INTEGER);
+    return { Sequence(left, right, type, lvalue, Transpile(right, type), [&](const std::string& l, const std::string& r) {
+      return Infix(l, infix, r);
+    }), Type::BOOLEAN, true };
+  }
+
+  const auto name = GetNodeTypeName(condition.type);
+  const auto lvalue = Transpile(left, Type::VALUE);
+  return { Sequence(left, right, Type::VALUE, lvalue, Transpile(right, Type::VALUE), [&](const std::string& l, const std::string& r) {
+    return "Kernel::Compare(" + name + ", " + l + ", " + r + ")";
+  }), Type::BOOLEAN, true };
+}
+
+Transpiler::Expression Transpiler::TranspileExpression(const Node& expression) {
+  const bool operand = listed;
+  listed = false;
+  const auto scalar = [this, operand](const std::string& code) { return parallel && !operand ? "Transpiled::Scalar("s + code + ", " + Quote(parallel->key) + ")" : code; };
+
+  switch (expression.type) {
+    case NodeType::VARIABLE: {
+      const int slot = GetNode<Ast::Variable>(expression).slot;
+      const auto variable = "v" + std::to_string(slot) + ".Get()";
+      return { slots[slot] == Type::VALUE ? scalar(variable) : variable, slots[slot], false };
+    }
+
+    case NodeType::LITERAL:   return TranspileLiteral(GetNode<Ast::Literal>(expression).value);
+    case NodeType::LIST:      return TranspileList(GetNode<Ast::List>(expression));
+
+    case NodeType::SUBSCRIPT: {
+      const auto& subscript = GetNode<Ast::Subscript>(expression);
+      listed = true;
+      const auto list = Transpile(*subscript.list, Type::VALUE);
+      if (subscript.bounded) return { scalar(list + ".At(" + Transpile(*subscript.index, Type::INTEGER) + ")"), Type::VALUE, false }; // reads two variables, in either order
+      return { scalar("Transpiled::Subscript("s + list + ", [&] { return " + Transpile(*subscript.index, Type::INTEGER) + "; })"), Type::VALUE, false };
+    }
+
+    case NodeType::RANGE: {
+      const auto& range = GetNode<Ast::Range>(expression);
+      const auto start = Transpile(*range.start, Type::INTEGER);
+      return { Sequence(*range.start, *range.end, Type::INTEGER, start, Transpile(*range.end, Type::INTEGER), [](const std::string& l, const std::string& r) {
+        return "Transpiled::Range("s + l + ", " + r + ")";
+      }), Type::VALUE, true };
+    }
+
+    case NodeType::SIZE:
+      listed = true;
+      return { "Transpiled::Size("s + Transpile(*GetNode<Ast::Size>(expression).list, Type::VALUE) + ")", Type::INTEGER, true };
+
+    case NodeType::NONE:
+      return { "Transpiled::Missing()", Type::VALUE, false };
+
+    default: break;
+  }
+
+  if (IsOperation(expression.type)) return TranspileOperation(GetNode<Ast::Operation>(expression));
+  if (IsCondition(expression.type)) return TranspileCondition(GetNode<Ast::Operation>(expression));
+
+  throw std::runtime_error("Expected variable or literal expression: `"s + expression.key + "` provided!"s);
+}
+
+// Statements //
+
+bool Transpiler::ListVariable(const Node& list) {
+  if (list.type == NodeType::VARIABLE) return true;
+  Line("throw std::invalid_argument(\"List operand must be a `variable`\");");
+  return false;
+}
+
+void Transpiler::TranspileDraw(const Ast::Draw& draw) {
+  static constexpr const char* LINE[] = { "x1", "y1", "x2", "y2" };
+  static constexpr const char* RECT[] = { "x", "y", "w", "h" };
+  const bool pixel = draw.type == NodeType::DRAW_PIXEL;
+  const auto names = draw.type == NodeType::DRAW_LINE ? LINE : RECT;
+
+  Open("");
+  for (int i = 0; i < (pixel ? 2 : Ast::Draw::MAX_OPERANDS); ++i) // operands are evaluated in order
+    Line("const int "s + names[i] + " = " + Transpile(*draw.operands[i], Type::INTEGER) + ";");
+
+  switch (draw.type) {
+    case NodeType::DRAW_LINE:   Line("context.renderer.DrawLine(Vec2{ x1, y1 }, Vec2{ x2, y2 });"); break;
+    case NodeType::DRAW_RECT:   Line("context.renderer.DrawRect(Rec2{ { x, y }, { w, h } });"); break;
+    default:                    Line("context.renderer.DrawPixel(Vec2{ x, y });"); break;
+  }
+  Close();
+}
+
+// Parallel Loops //
+
+// Transpiled programs run the iterations of a `parallel` block in order, which the engines' results are equal to
+void Transpiler::TranspileParallel(const Ast::Parallel& parallel) {
+  const auto index = std::to_string(labels++);
+  const auto element = "v" + std::to_string(parallel.element->slot);
+  const auto list = "v" + std::to_string(parallel.list->slot);
+  const auto key = Quote(parallel.key);
+  const auto type = slots[parallel.element->slot];
+
+  Open("");
+  Line("const Value l" + index + " = Transpiled::Parallel(" + list + ".Get());");
+  Line("const Primitive p" + index + " = " + element + ".GetPrimitive();");
+  Line("const char* n" + index + " = " + element + ".GetName();");
+  Line("(void)" + element + ".Get();"); // assigned each element, as a `foreach` element is
+  Line("const int t" + index + " = l" + index + ".Size();");
+  Line("Value::List r" + index + "(t" + index + ");");
+  Open("for (int i" + index + " = 0; i" + index + " < t" + index + "; ++i" + index + ")");
+  for (const int slot : parallel.locals) // each iteration holds its own element and definitions
+    Line("Transpiled::Variable<"s + GetTypeName(slots[slot]) + "> v" + std::to_string(slot) + "{ " + Quote((*keys)[slot]) + " };");
+  const auto value = Convert({ "Transpiled::Scalar(l" + index + ".At(i" + index + "), " + key + ")", Type::VALUE, false }, type);
+  Line(element + ".Define(" + value + ", n" + index + ", p" + index + ");");
+
+  const auto outer = Transpiler::parallel;
+  Transpiler::parallel = &parallel;
+  TranspileComponents(parallel.components);
+  Transpiler::parallel = outer;
+
+  Line("r" + index + "[i" + index + "] = " + Convert({ element + ".Get()", type, false }, Type::VALUE) + ";");
+  Line("context.Yield();");
+  Close();
+  Open("if (t" + index + ")");
+  Line(element + ".Set(" + Convert({ "r" + index + ".back()", Type::VALUE, false }, type) + ");");
+  Line(list + ".Set(Value{std::move(r" + index + ")});");
+  Close();
+  Close();
+}
+
+// Procedures //
+
+// A procedure is a lambda called with its arguments, whose locals are declared again for each call
+void Transpiler::TranspileProcedure(const Ast::Procedure& procedure, const std::vector<std::string>& keys) {
+  Transpiler::procedure = &procedure;
+  const auto index = std::to_string(procedure.index);
+  const auto& parameters = procedure.parameters;
+
+  std::string signature;
+  for (int i = 0; i < (int)parameters.size(); ++i) signature += GetTypeName(slots[parameters[i]->slot]) + " a"s + std::to_string(i) + ", ";
+  Open("p" + index + " = [&](" + signature + "bool required) -> std::optional<Value>");
+  Line("const Transpiled::Call call{ context };");
+  Line("c" + index + ":"); // a call replacing its caller's frame starts again here
+  Open("");
+  for (const int slot : procedure.locals)
+    Line("Transpiled::Variable<"s + GetTypeName(slots[slot]) + "> v" + std::to_string(slot) + "{ " + Quote(keys[slot]) + " };");
+  for (int i = 0; i < (int)parameters.size(); ++i) {
+    const auto& parameter = *parameters[i];
+    Line("v" + std::to_string(parameter.slot) + ".Define(a" + std::to_string(i) + ", " + Quote(parameter.name) + ", " + GetPrimitiveTypeName(parameter.primitive) + ");");
+  }
+
+  TranspileComponents(procedure.components);
+  Line("context.block = " + Quote(procedure.key) + ";"); // its body is exhausted
+  TranspileReturn(Ast::Return{ procedure.key, nullptr });
+  Close();
+  Close("};");
+  Transpiler::procedure = nullptr;
+}
+
+void Transpiler::TranspileCall(const Ast::Call& call) {
+  const auto* callee = call.procedure;
+  if (!callee) {
+    Line("throw std::invalid_argument(" + Quote("Procedure `" + call.procedureId + "` is not defined!") + ");");
+    return;
+  }
+  const int count = callee->parameters.size();
+  if ((int)call.arguments.size() != count) {
+    Line("throw std::invalid_argument(" + Quote("Procedure `" + callee->name + "` takes " + std::to_string(count) + " arguments!") + ");");
+    return;
+  }
+
+  // arguments are evaluated in order before the call
+  const auto name = "p" + std::to_string(callee->index);
+  std::string arguments;
+  Open("");
+  for (int i = 0; i < count; ++i) {
+    const auto type = slots[callee->parameters[i]->slot];
+    const auto argument = "x" + std::to_string(i);
+    Line("const "s + GetTypeName(type) + " " + argument + " = " + Transpile(*call.arguments[i], type) + ";");
+    arguments += argument + ", ";
+  }
+
+  // the caller returns what the callee does, so the callee replaces it; a procedure calling itself starts again
+  const bool result = call.result != nullptr;
+  if (call.tail) {
+    Open(result ? "" : "if (!required)");
+    if (callee == procedure) {
+      for (int i = 0; i < count; ++i) Line("a" + std::to_string(i) + " = x" + std::to_string(i) + ";");
+      if (result) Line("required = true;");
+      Line("goto c" + std::to_string(callee->index) + ";");
+    } else {
+      Line("const Transpiled::Tail tail{ context };");
+      if (result) Line("return " + name + "(" + arguments + "true);");
+      else {
+        Line(name + "(" + arguments + "false);");
+        Line("return {};");
+      }
+    }
+    Close();
+  }
+
+  if (!call.tail || !result) {
+    if (!result) Line("(void)" + name + "(" + arguments + "false);");
+    else {
+      const int slot = call.result->slot;
+      Line("v" + std::to_string(slot) + ".Set(" + Convert({ "(*" + name + "(" + arguments + "true))", Type::VALUE, false }, slots[slot]) + ");");
+    }
+  }
+  Close();
+}
+
+void Transpiler::TranspileReturn(const Ast::Return& ret) {
+  if (!procedure) {
+    Line("throw std::runtime_error(\"RETURN outside of a procedure!\");");
+    return;
+  }
+  if (ret.expression) {
+    Line("return " + Transpile(*ret.expression, Type::VALUE) + ";");
+    return;
+  }
+
+  Line("if (required) throw std::runtime_error(" + Quote("Procedure `" + procedure->name + "` did not return a value!") + ");");
+  Line("return {};");
+}
+
+void Transpiler::TranspileJump(const Ast::Jump& jump, const std::string& label, const bool backward) {
+  std::string statement;
+  if (label.empty()) {
+    const auto message = jump.expression->type == NodeType::LITERAL ? "JUMP operation out of range" : "Only literal JUMP distances can be transpiled!";
+    statement = "throw std::range_error(\""s + message + "\");";
+  }
+  else if (backward) statement = "{ context.Yield(); goto " + label + "; }"; // a loop
+  else statement = "goto " + label + ";";
+
+  Line("context.block = " + Quote(jump.key) + ";");
+  if (jump.condition) Line("if (" + Transpile(*jump.condition, Type::BOOLEAN) + ") " + statement);
+  else Line(statement);
+}
+
+void Transpiler::TranspileComponents(const Nodes& components) {
+  const int count = components.size();
+  const auto label = [body = labels++](const int index) { return "j" + std::to_string(body) + "_" + std::to_string(index); };
+
+  // jumps move within their body, by a literal distance from the following statement
+  std::vector<int> targets(count, -1);
+  std::vector<bool> targeted(count + 1, false);
+  for (int i = 0; i < count; ++i) {
+    const auto& component = *components[i];
+    if (component.type != NodeType::JUMP && component.type != NodeType::CONDITIONAL_JUMP) continue;
+
+    const auto& distance = *GetNode<Ast::Jump>(component).expression;
+    if (distance.type != NodeType::LITERAL || !GetNode<Ast::Literal>(distance).value.IsNumber()) continue;
+
+    const int target = i + 1 + GetNode<Ast::Literal>(distance).value.GetNumber<int>();
+    if (target < 0 || target > count) continue;
+    targets[i] = target;
+    targeted[target] = true;
+  }
+
+  for (int i = 0; i < count; ++i) {
+    if (targeted[i]) Line(label(i) + ": ;");
+    const auto& component = *components[i];
+    if (component.type == NodeType::JUMP || component.type == NodeType::CONDITIONAL_JUMP)
+      TranspileJump(GetNode<Ast::Jump>(component), targets[i] < 0 ? "" : label(targets[i]), targets[i] <= i);
+    else TranspileComponent(component);
+  }
+  if (targeted[count]) Line(label(count) + ": ;");
+}
+
+void Transpiler::TranspileComponent(const Node& component) {
+  if (component.type == NodeType::COMMENT || component.type == NodeType::PROCEDURE) return; // procedures are declared before the program
+  if (component.type == NodeType::YIELD) return; // a transpiled program runs alone, there is no other script to run
+  Line("context.block = " + Quote(component.key) + ";");
+
+  switch (component.type) {
+    case NodeType::EXIT: Line(procedure ? "throw Transpiled::Exit{};" : "return;"); break;
+
+    case NodeType::DEFINITION: {
+      const auto& definition = GetNode<Ast::Definition>(component);
+      const auto type = slots[definition.slot];
+      const auto primitive = GetPrimitiveTypeName(definition.primitive);
+      const auto value = definition.expression->type == NodeType::NONE
+        ? Convert({ "Transpiled::Default(" + primitive + ")", Type::VALUE, false }, type) // default value of the primitive
+        : Transpile(*definition.expression, type);
+      Line("v" + std::to_string(definition.slot) + ".Define(" + value + ", " + Quote(definition.name) + ", " + primitive + ");");
+      break;
+    }
+
+    case NodeType::ASSIGNMENT: {
+      const auto& assignment = GetNode<Ast::Assignment>(component);
+      const int slot = assignment.lvalue->slot;
+      Line("v" + std::to_string(slot) + ".Set(" + Transpile(*assignment.rvalue, slots[slot]) + ");");
+      break;
+    }
+
+    case NodeType::INCREMENT:
+    case NodeType::DECREMENT: {
+      const auto amount = component.type == NodeType::INCREMENT ? "1" : "-1";
+      Line("Transpiled::Step(v" + std::to_string(GetNode<Ast::Increment>(component).variable->slot) + ", " + amount + ");");
+      break;
+    }
+
+    case NodeType::BRANCH: {
+      const auto& branch = GetNode<Ast::Branch>(component);
+      Open("if (" + Transpile(*branch.condition, Type::BOOLEAN) + ")");
+      TranspileComponents(branch.consequent);
+      if (branch.alternative.empty()) Close();
+      else {
+        Close("} else {");
+        ++indent;
+        TranspileComponents(branch.alternative);
+        Close();
+      }
+      break;
+    }
+
+    case NodeType::REPEAT: {
+      const auto& repeat = GetNode<Ast::Loop>(component);
+      const auto index = std::to_string(labels++);
+      Open("");
+      Line("const int t" + index + " = Transpiled::Repeat(" + Transpile(*repeat.expression, Type::INTEGER) + ");");
+      Open("for (int i" + index + " = 0; i" + index + " < t" + index + "; ++i" + index + ")");
+      TranspileComponents(repeat.components);
+      Line("context.Yield();");
+      Close();
+      Close();
+      break;
+    }
+
+    case NodeType::WHILE: {
+      const auto& loop = GetNode<Ast::Loop>(component);
+      Open("do"); // the body runs before the condition is first tested
+      TranspileComponents(loop.components);
+      Line("context.Yield();");
+      Close("} while ((context.block = " + Quote(loop.key) + ", " + Transpile(*loop.expression, Type::BOOLEAN) + "));");
+      break;
+    }
+
+    case NodeType::FOREVER:
+      Open("for (;;)");
+      TranspileComponents(GetNode<Ast::Loop>(component).components);
+      Line("context.Yield();");
+      Close();
+      break;
+
+    case NodeType::FOREACH: {
+      const auto& foreach = GetNode<Ast::Loop>(component);
+      const int slot = foreach.element->slot;
+      const auto index = std::to_string(labels++);
+      Open("");
+      Line("const Value l" + index + " = Transpiled::Iterate(" + Transpile(*foreach.expression, Type::VALUE) + ");");
+      Line("const int t" + index + " = l" + index + ".Size();");
+      Open("for (int i" + index + " = 0; i" + index + " < t" + index + "; ++i" + index + ")");
+      Line("v" + std::to_string(slot) + ".Set(" + Convert({ "l" + index + ".At(i" + index + ")", Type::VALUE, false }, slots[slot]) + ");");
+      TranspileComponents(foreach.components);
+      Line("context.Yield();");
+      Close();
+      Close();
+      break;
+    }
+
+    case NodeType::PARALLEL: TranspileParallel(GetNode<Ast::Parallel>(component)); break;
+
+    case NodeType::APPEND: {
+      const auto& append = GetNode<Ast::Append>(component);
+      if (!ListVariable(*append.list)) break;
+      const auto slot = std::to_string(GetNode<Ast::Variable>(*append.list).slot);
+      Open("");
+      Line("auto item = " + Transpile(*append.item, Type::VALUE) + ";"); // evaluate before editing, the item may read the list
+      Line("Transpiled::Append(v" + slot + ", std::move(item));");
+      Close();
+      break;
+    }
+
+    case NodeType::REMOVE: {
+      const auto& remove = GetNode<Ast::Remove>(component);
+      if (!ListVariable(*remove.list)) break;
+      const auto slot = std::to_string(GetNode<Ast::Variable>(*remove.list).slot);
+      Line("Transpiled::Remove(v" + slot + ", " + Transpile(*remove.index, Type::INTEGER) + ");");
+      break;
+    }
+
+    case NodeType::SIZE: Line("(void)" + TranspileExpression(component).code + ";"); break;
+
+    case NodeType::DRAW_LINE:
+    case NodeType::DRAW_RECT:
+    case NodeType::DRAW_PIXEL:
+      TranspileDraw(GetNode<Ast::Draw>(component));
+      break;
+
+    case NodeType::CLEAR_SCREEN:
+      Line("context.renderer.Clear();");
+      Line("context.renderer.Present();");
+      break;
+
+    case NodeType::PRINT: Line("PrintValue(" + Transpile(*GetNode<Ast::Print>(component).expression, Type::VALUE) + ");"); break;
+    case NodeType::WAIT: Line("context.Wait(" + Transpile(*GetNode<Ast::Wait>(component).duration, Type::INTEGER) + ");"); break;
+    case NodeType::WAIT_FRAME: Line("context.WaitFrame();"); break;
+    case NodeType::CLEAR_OUTPUT: break; // todo: some native clear implementation
+
+    case NodeType::CALL:    TranspileCall(GetNode<Ast::Call>(component)); break;
+    case NodeType::RETURN:  TranspileReturn(GetNode<Ast::Return>(component)); break;
+
+    default: Line("throw std::invalid_argument(" + Quote("Invalid TYPE provided for component: `" + component.key + "`") + ");"); break;
+  }
+}
+
+// API //
+
+std::string Transpiler::Transpile(const AbstractSyntaxTree& program) {
+  const auto& keys = program.GetSlots();
+  for (const auto& component : program.GetTree()) // native code runs to completion, it can not take turns
+    if (component->type == NodeType::SCRIPT) throw std::invalid_argument("Script `" + component->key + "` can not be transpiled, only programs without scripts can be!");
+  Transpiler::keys = &keys;
+  strings.clear();
+  code.clear();
+  indent = 1;
+  labels = 0;
+
+  // variables are stored as the type inferred for every read of them
+  slots.assign(keys.size(), Type::VALUE);
+  std::function<void(Node&)> visit = [&](Node& node) {
+    if (node.type == NodeType::VARIABLE) slots[GetNode<Ast::Variable>(node).slot] = GetType(node.valueType);
+    VisitChildren(node, [&](NodePtr& child) { visit(*child); }, [&](Nodes& body) { for (auto& component : body) visit(*component); });
+  };
+  for (const auto& component : program.GetTree()) visit(*component);
+
+  // procedures may be called before they are defined, so each is declared first
+  std::string declarations;
+  for (const auto& component : program.GetTree()) {
+    if (component->type != NodeType::PROCEDURE) continue;
+    const auto& procedure = GetNode<Ast::Procedure>(*component);
+    std::string signature;
+    for (const auto& parameter : procedure.parameters) signature += GetTypeName(slots[parameter->slot]) + ", "s;
+    declarations += "  std::function<std::optional<Value>("s + signature + "bool)> p" + std::to_string(procedure.index) + ";\n";
+    TranspileProcedure(procedure, keys);
+  }
+  if (!declarations.empty()) code = declarations + "\n" + code + "\n";
+
+  TranspileComponents(program.GetTree());
+
+  std::string source = "// Generated from a Component program by the `Transpiler`\n\n#define SDL_MAIN_HANDLED\n\n#include <limits>\n#include <transpiled.hpp>\n\n";
+  for (int i = 0; i < (int)strings.size(); ++i)
+    source += "static const Value s" + std::to_string(i) + "{ " + Quote(strings[i]) + " };\n";
+
+  source += "\nstatic void Program(Transpiled::Context& context) {\n";
+  for (int i = 0; i < (int)keys.size(); ++i)
+    if (!program.IsLocal(i)) source += "  Transpiled::Variable<"s + GetTypeName(slots[i]) + "> v" + std::to_string(i) + "{ " + Quote(keys[i]) + " };\n";
+  source += "\n" + code + "}\n\nint main(int argc, char* argv[]) { return Transpiled::Main(argc, argv, Program); }\n";
+  return source;
+}
@@ -0,0 +1,151 @@
+#include <typeInference.hpp>
+
+#include <algorithm>
+
+// Lattice //
+
+ValueType TypeInference::Join(const ValueType a, const ValueType b) {
+  if (a == ValueType::NONE) return b;
+  if (b == ValueType::NONE || a == b) return a;
+  return ValueType::ANY; // includes integers mixed with doubles, whose width is only known at runtime
+}
+
+ValueType TypeInference::GetDefault(const Primitive primitive) {
+  switch (primitive) {
+    case Primitive::NUMBER:   return ValueType::INTEGER;
+    case Primitive::STRING:   return ValueType::STRING;
+    case Primitive::BOOLEAN:  return ValueType::BOOLEAN;
+    case Primitive::LIST:     return ValueType::LIST;
+  }
+  return ValueType::ANY;
+}
+
+// Can a variable of `primitive` hold a value of `type`; the runtime does not convert definitions
+static bool Admits(const Primitive primitive, const ValueType type) {
+  switch (primitive) {
+    case Primitive::NUMBER:   return type == ValueType::INTEGER || type == ValueType::DOUBLE;
+    case Primitive::STRING:   return type == ValueType::STRING;
+    case Primitive::BOOLEAN:  return type == ValueType::BOOLEAN;
+    case Primitive::LIST:     return type == ValueType::LIST;
+  }
+  return false;
+}
+
+void TypeInference::Write(const int slot, const ValueType type) {
+  if (slot == Ast::UNRESOLVED) return;
+  const auto joined = Join(slots[slot], type);
+  if (joined == slots[slot]) return;
+  slots[slot] = joined;
+  changed = true;
+}
+
+void TypeInference::Return(const int procedure, const ValueType type) {
+  auto& returned = returns[procedure];
+  const auto joined = Join(returned, type);
+  if (joined == returned) return;
+  returned = joined;
+  changed = true;
+}
+
+// Expressions //
+
+static ValueType InferArithmetic(const ValueType left, const ValueType right) {
+  if (left == ValueType::NONE || right == ValueType::NONE) return ValueType::NONE; // an operand is not yet inferred
+  if (left == ValueType::INTEGER && right == ValueType::INTEGER) return ValueType::INTEGER;
+  const auto isNumber = [](const ValueType type) { return type == ValueType::INTEGER || type == ValueType::DOUBLE; };
+  if (isNumber(left) && isNumber(right)) return ValueType::DOUBLE;
+  return ValueType::ANY;
+}
+
+ValueType TypeInference::InferExpression(Node& expression) {
+  std::vector<ValueType> children;
+  VisitChildren(expression,
+    [this, &children](NodePtr& child) { children.push_back(InferExpression(*child)); },
+    [this](Nodes& body) { InferComponents(body); }
+  );
+
+  const auto type = expression.type;
+  ValueType inferred = ValueType::ANY;
+  if (type == NodeType::LITERAL) inferred = GetValueType(GetNode<Ast::Literal>(expression).value);
+  else if (type == NodeType::VARIABLE) {
+    const int slot = GetNode<Ast::Variable>(expression).slot;
+    inferred = slot == Ast::UNRESOLVED ? ValueType::ANY : slots[slot];
+  }
+  else if (type == NodeType::LIST || type == NodeType::RANGE) inferred = ValueType::LIST;
+  else if (type == NodeType::SIZE) inferred = ValueType::INTEGER;
+  else if (IsCondition(type)) {
+    inferred = ValueType::BOOLEAN;
+    if (IsComparison(type)) GetNode<Ast::Operation>(expression).operands = InferArithmetic(children[0], children[1]); // numbers compare as they would add
+  }
+  else if (IsUnaryOperation(type)) inferred = InferArithmetic(children[0], children[0]);
+  else if (IsOperation(type)) inferred = InferArithmetic(children[0], children[1]);
+
+  expression.valueType = inferred;
+  return inferred;
+}
+
+// Statements //
+
+void TypeInference::InferComponents(Nodes& components) {
+  for (auto& component : components) {
+    if (component->type == NodeType::PROCEDURE) {
+      procedure = &GetNode<Ast::Procedure>(*component);
+      InferExpression(*component);
+      procedure = nullptr;
+      continue;
+    }
+
+    InferExpression(*component); // annotates every child expression
+
+    if (component->type == NodeType::DEFINITION) {
+      const auto& definition = GetNode<Ast::Definition>(*component);
+      const auto value = definition.expression->type == NodeType::NONE ? GetDefault(definition.primitive) : definition.expression->valueType;
+      Write(definition.slot, value == ValueType::NONE || Admits(definition.primitive, value) ? value : ValueType::ANY); // proofs imply the primitive
+    } else if (component->type == NodeType::ASSIGNMENT) {
+      const auto& assignment = GetNode<Ast::Assignment>(*component);
+      Write(assignment.lvalue->slot, assignment.rvalue->valueType);
+    } else if (component->type == NodeType::FOREACH) {
+      const auto& loop = GetNode<Ast::Loop>(*component);
+      Write(loop.element->slot, loop.expression->type == NodeType::RANGE ? ValueType::INTEGER : ValueType::ANY); // only a range proves its elements
+    } else if (component->type == NodeType::PARALLEL) {
+      const auto& parallel = GetNode<Ast::Parallel>(*component);
+      Write(parallel.list->slot, ValueType::LIST);
+      Write(parallel.element->slot, ValueType::ANY); // the last element, read from the list or computed by the body
+    } else if (component->type == NodeType::CALL) {
+      const auto& call = GetNode<Ast::Call>(*component);
+      const auto* callee = call.procedure;
+      if (!callee || call.arguments.size() != callee->parameters.size()) continue; // fails when called
+
+      // parameters are defined with their arguments
+      for (int i = 0; i < (int)call.arguments.size(); ++i) {
+        const auto& parameter = *callee->parameters[i];
+        const auto value = call.arguments[i]->valueType;
+        Write(parameter.slot, value == ValueType::NONE || Admits(parameter.primitive, value) ? value : ValueType::ANY);
+      }
+      if (call.result) Write(call.result->slot, returns[callee->index]);
+    } else if (component->type == NodeType::RETURN) {
+      const auto& value = GetNode<Ast::Return>(*component).expression;
+      if (procedure && value) Return(procedure->index, value->valueType);
+    }
+  }
+}
+
+// API //
+
+void TypeInference::Infer(AbstractSyntaxTree& program) {
+  slots.assign(program.GetSlots().size(), ValueType::NONE);
+  int procedures = 0;
+  for (const auto& node : program.GetTree())
+    if (node->type == NodeType::PROCEDURE) procedures = std::max(procedures, GetNode<Ast::Procedure>(*node).index + 1);
+  returns.assign(procedures, ValueType::NONE);
+
+  // writes only widen a slot, so this settles within a few passes
+  do {
+    changed = false;
+    InferComponents(program.GetTree());
+  } while (changed);
+
+  // slots never written are read before their definition and fail at runtime
+  for (auto& slot : slots) if (slot == ValueType::NONE) slot = ValueType::ANY;
+  InferComponents(program.GetTree());
+}
@@ -0,0 +1,122 @@
+#include <value.hpp>
+#include <print.hpp>
+
+#include <algorithm>
+
+const std::string Value::EMPTY_STRING{};
+
+// Lifetime //
+
+void Value::Destroy() {
+  if (type == Type::STRING && string && --string->references == 0) delete string;
+  else if (type == Type::LIST && --list->references == 0) delete list;
+}
+
+void Value::Materialize() const {
+  auto& array = *list;
+  if (array.kind == Array::Kind::RANGE) {
+    array.value.reserve(array.size);
+    for (int i = 0; i < array.size; ++i) array.value.emplace_back(array.start + i);
+  } else if (array.kind == Array::Kind::FILL) {
+    const Value element = array.value.front(); // copied, assigning reallocates the element
+    array.value.assign(array.size, element);
+  }
+  array.kind = Array::Kind::ELEMENTS;
+}
+
+Value::List& Value::EditList() {
+  if (type != Type::LIST) BadAccess();
+  if (list->kind != Array::Kind::ELEMENTS) Materialize();
+  if (list->references > 1) {
+    --list->references;
+    list = new Array{list->value};
+  }
+  return list->value;
+}
+
+// Lazy Lists //
+
+Value Value::Range(const int start, const int size) {
+  Value range{List{}};
+  if (size <= 0) return range;
+
+  range.list->kind = Array::Kind::RANGE;
+  range.list->size = size;
+  range.list->start = start;
+  return range;
+}
+
+Value Value::Fill(Value element, const int size) {
+  if (size <= 0) return Value{List{}};
+
+  Value fill{List{std::move(element)}};
+  fill.list->kind = Array::Kind::FILL;
+  fill.list->size = size;
+  return fill;
+}
+
+// Measurement //
+
+size_t Value::Footprint(int& longest) const {
+  size_t bytes = sizeof(Value);
+  if (type == Type::STRING && string) bytes += sizeof(String) + string->value.capacity();
+  if (type != Type::LIST) return bytes;
+
+  // lazy lists hold one element at most
+  longest = std::max(longest, Size());
+  bytes += sizeof(Array) + (list->value.capacity() - list->value.size()) * sizeof(Value);
+  for (const auto& element : list->value) bytes += element.Footprint(longest);
+  return bytes;
+}
+
+// Comparison //
+
+bool operator==(const Value& lvalue, const Value& rvalue) {
+  if (lvalue.type != rvalue.type) return lvalue.IsNumber() && rvalue.IsNumber() && lvalue.GetNumber<double>() == rvalue.GetNumber<double>();
+  switch (lvalue.type) {
+    case Value::Type::INTEGER:  return lvalue.integer == rvalue.integer;
+    case Value::Type::DOUBLE:   return lvalue.real == rvalue.real;
+    case Value::Type::BOOLEAN:  return lvalue.boolean == rvalue.boolean;
+    case Value::Type::STRING:   return lvalue.string == rvalue.string || lvalue.Get<std::string>() == rvalue.Get<std::string>();
+    case Value::Type::LIST:     return lvalue.list == rvalue.list || lvalue.Get<Value::List>() == rvalue.Get<Value::List>();
+  }
+  return false;
+}
+
+bool operator<(const Value& lvalue, const Value& rvalue) {
+  if (lvalue.type != rvalue.type) {
+    if (lvalue.IsNumber() && rvalue.IsNumber()) return lvalue.GetNumber<double>() < rvalue.GetNumber<double>();
+    return lvalue.type < rvalue.type;
+  }
+  switch (lvalue.type) {
+    case Value::Type::INTEGER:  return lvalue.integer < rvalue.integer;
+    case Value::Type::DOUBLE:   return lvalue.real < rvalue.real;
+    case Value::Type::BOOLEAN:  return lvalue.boolean < rvalue.boolean;
+    case Value::Type::STRING:   return lvalue.Get<std::string>() < rvalue.Get<std::string>();
+    case Value::Type::LIST: {
+      const auto& a = lvalue.Get<Value::List>();
+      const auto& b = rvalue.Get<Value::List>();
+      return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end());
+    }
+  }
+  return false;
+}
+
+// Output //
+
+int PrintValue(const Value& value) {
+  switch (value.GetType()) {
+    case Value::Type::STRING:   ClientPrint(value.Get<std::string>()); break;
+    case Value::Type::INTEGER:  ClientPrint(value.Get<int>()); break;
+    case Value::Type::DOUBLE:   ClientPrint(value.Get<double>()); break;
+    case Value::Type::BOOLEAN:  ClientPrint(value.Get<bool>() ? "true" : "false"); break;
+    case Value::Type::LIST: {
+      // recursively print each item in the list
+      int printed = 0;
+      for (const auto& item : value.Get<Value::List>())
+        printed += PrintValue(item);
+      return printed;
+    }
+  }
+  return 1;
+}
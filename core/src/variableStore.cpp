@@ -2,34 +2,105 @@
 
 // Variable //
 
-void Variable::Invariant(const std::string name, const std::string primitive) const {
-  if (primitive != "string" && primitive != "number" && primitive != "boolean" && primitive != "list" || name.empty())
-    throw BadDefinition(name, primitive);
+Primitive ParsePrimitive(const std::string& name, const std::string& primitive) {
+  if (name.empty()) throw BadDefinition(name, primitive);
+
+  if (primitive == "string") return Primitive::STRING;
+  if (primitive == "number") return Primitive::NUMBER;
+  if (primitive == "boolean") return Primitive::BOOLEAN;
+  if (primitive == "list") return Primitive::LIST;
+  throw BadDefinition(name, primitive);
+}
+
+const char* GetPrimitiveName(const Primitive primitive) {
+  switch (primitive) {
+    case Primitive::STRING:   return "string";
+    case Primitive::NUMBER:   return "number";
+    case Primitive::BOOLEAN:  return "boolean";
+    case Primitive::LIST:     return "list";
+  }
+  return "";
+}
+
+void Variable::Invariant(const std::string& name) const {
+  if (name.empty()) throw BadDefinition(name, "");
 }
 
-Variable::Variable(const std::string key, const std::string name, const std::string primitive)
+Variable::Variable(const std::string key, const std::string name, const Primitive primitive)
 : key(key), name(name), primitive(primitive) {
-  Invariant(name, primitive);
-  if (primitive == "string") value = std::string();
-  else if (primitive == "number") value = 0;
-  else if (primitive == "boolean") value = false;
-  else if (primitive == "list") value = Json::array(); // todo: use std::vector when we have a better value abstraction
+  Invariant(name);
+  switch (primitive) {
+    case Primitive::STRING:   value = std::string(); break;
+    case Primitive::NUMBER:   value = 0; break;
+    case Primitive::BOOLEAN:  value = false; break;
+    case Primitive::LIST:     value = Value{Value::List{}}; break;
+  }
 }
 
-Variable::Variable(const std::string key, const std::string name, const std::string primitive, const Any value)
+Variable::Variable(const std::string key, const std::string name, const Primitive primitive, const Value value)
 : key(key), name(name), primitive(primitive), value(value) {
-  Invariant(name, primitive);
+  Invariant(name);
+}
+
+Value::List& Variable::EditList() {
+  if (primitive != Primitive::LIST || !value.Is<Value::List>())
+    throw std::invalid_argument("Variable `" + name + "` must be of `list` primitive!");
+  return value.EditList();
 }
 
 // Store //
 
-VariableStore::VariableStore()
-  : stored(0) {
+void VariableStore::Allocate(const std::vector<std::string>& keys, const std::vector<int>& offsets) {
+  VariableStore::keys = keys;
+  slots.assign(keys.size(), std::nullopt);
+  versions.assign(keys.size(), 0);
+  VariableStore::offsets = offsets;
+  VariableStore::offsets.resize(keys.size(), GLOBAL);
+  frame = nullptr;
+  WriteCheck();
+}
+
+void VariableStore::Add(const int slot, Variable variable) {
+  auto& stored = Cell(slot);
+  if (stored) return; // does not overwrite existing values... todo: catch this?
+
+  stored.emplace(std::move(variable));
+  ++versions[slot];
+}
+
+std::pair<size_t, int> VariableStore::Measure() const {
+  size_t bytes = 0;
+  int longest = 0;
+  for (const auto& variable : slots) if (variable) bytes += variable->Get().Footprint(longest); // locals live in their frames instead
+  return { bytes, longest };
+}
+
+void VariableStore::SetFrame(std::optional<Variable>* frame, const std::vector<int>& locals) {
+  VariableStore::frame = frame;
+  for (const int slot : locals) ++versions[slot];
+}
+
+// Locals //
+
+std::optional<Variable>* Locals::Push(const int size) {
+  if (Depth() >= MAX_CALL_DEPTH) throw std::overflow_error("Procedure calls have exceeded MAX_CALL_DEPTH!");
+
+  bases.push_back(used);
+  used += size;
+  if (used > (int)cells.size()) cells.resize(used); // may move the frames of callers, which are found again on return
+  return cells.data() + bases.back();
+}
 
+size_t Locals::Footprint(int& longest) const {
+  size_t bytes = 0;
+  for (int cell = 0; cell < used; ++cell) if (cells[cell]) bytes += cells[cell]->Get().Footprint(longest);
+  return bytes;
 }
 
-void VariableStore::Add(const std::string key, Variable variable) {
-  if (stored > MAX_VARIABLE_STORE) throw std::overflow_error("Variable store is full!"); 
-  store.try_emplace(key, variable); // does not overwrite existing values... todo: catch this?
-  ++stored;
+std::optional<Variable>* Locals::Pop() {
+  const int base = bases.back();
+  for (int cell = base; cell < used; ++cell) cells[cell].reset(); // releases the lists it held
+  used = base;
+  bases.pop_back();
+  return Top();
 }
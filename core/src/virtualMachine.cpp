@@ -0,0 +1,396 @@
+#include <virtualMachine.hpp>
+#include <kernel.hpp>
+#include <vec2.hpp>
+#include <governor.hpp>
+
+// Instructions //
+
+void VirtualMachine::Define(const Instruction& instruction) {
+  const auto& definition = *bytecode.definitions[instruction.a];
+  const auto& key = definition.key;
+
+  if (instruction.op == Opcode::DEFINE_DEFAULT)
+    store.Add(definition.slot, { key, definition.name, definition.primitive });
+  else
+    store.Add(definition.slot, { key, definition.name, definition.primitive, Register(instruction.b) });
+}
+
+void VirtualMachine::Step(const Instruction& instruction, const int amount) {
+  const auto& variable = store.Get(instruction.a);
+  if (variable.GetPrimitive() != Primitive::NUMBER)
+    throw std::invalid_argument("Invalid TYPE for UNARY ARITHMETIC expression!");
+
+  const auto& value = variable.Get();
+  if (value.Is<double>()) store.Set(instruction.a, value.As<double>() + amount);
+  else store.Set(instruction.a, value.Get<int>() + amount);
+}
+
+void VirtualMachine::Index(const Instruction& instruction) {
+  const auto& value = Register(instruction.b);
+  if (!value.Is<Value::List>()) throw std::runtime_error("value subscription must be `list`!");
+  const int size = value.Size();
+  const auto index = Integer(instruction.c);
+  if (std::abs(index) >= size) throw std::out_of_range("Subscript INDEX is out of range!");
+
+  Register(instruction.a) = value.At(index >= 0 ? index : size + index);
+}
+
+void VirtualMachine::Append(const Instruction& instruction) {
+  auto& list = store.EditList(instruction.a);
+  if ((int)list.size() >= MAX_ARRAY_SIZE) throw std::range_error("Append would exceed MAX_LIST_LENGTH!");
+  if (listQuota > 0 && (int)list.size() >= listQuota) throw Governor::Exceeded(Governor::Reason::LIST);
+  list.push_back(Register(instruction.b));
+}
+
+void VirtualMachine::Remove(const Instruction& instruction) {
+  auto& list = store.EditList(instruction.a);
+  const int size = list.size();
+  const auto index = Integer(instruction.b);
+  if (std::abs(index) >= size) throw std::out_of_range("Remove INDEX is out of range!");
+
+  list.erase(list.begin() + (index >= 0 ? index : size + index));
+}
+
+void VirtualMachine::Size(const Instruction& instruction) {
+  const auto& value = Register(instruction.b);
+  if (!value.Is<Value::List>()) throw std::invalid_argument("Size operand must be a `list`!");
+  Register(instruction.a) = value.Size();
+}
+
+void VirtualMachine::Range(const Instruction& instruction) {
+  const auto start = Integer(instruction.b);
+  const auto end = Integer(instruction.c);
+
+  const long long size = (long long)end - start; // empty when `end` is not after `start`
+  if (size > MAX_ARRAY_SIZE) throw std::range_error("Range is longer than MAX_LIST_LENGTH!");
+  Register(instruction.a) = Value::Range(start, size > 0 ? (int)size : 0);
+}
+
+void VirtualMachine::Draw(const Instruction& instruction) {
+  const int* operands = bytecode.operands.data() + instruction.a;
+  const auto at = [this, operands](const int i) { return Operand(operands[i]).GetNumber<int>(); };
+
+  switch (instruction.operation) {
+    case NodeType::DRAW_LINE:   renderer.DrawLine({ at(0), at(1) }, { at(2), at(3) }); break;
+    case NodeType::DRAW_RECT:   renderer.DrawRect({ { at(0), at(1) }, { at(2), at(3) } }); break;
+    default:                    renderer.DrawPixel({ at(0), at(1) }); break;
+  }
+}
+
+// Procedures //
+
+void VirtualMachine::Call(const Instruction& instruction) {
+  const auto& call = *bytecode.calls[instruction.a];
+  const auto& procedure = *call.procedure;
+  const int arguments = base + instruction.b;
+  const Ast::Variable* result = call.result.get();
+
+  // the caller returns what the callee does, so the callee replaces it
+  if (instruction.c && (result || !frames.back().required)) {
+    auto& frame = frames.back();
+    store.SetFrame(locals.Pop(), frame.procedure->locals);
+    store.SetFrame(locals.Push(procedure.locals.size()), procedure.locals);
+    frame.procedure = &procedure;
+    frame.required = frame.required || result;
+    Bind(procedure, arguments);
+    pc = bytecode.entries[procedure.index];
+    return;
+  }
+
+  auto* cells = locals.Push(procedure.locals.size()); // throws past `MAX_CALL_DEPTH`
+  frames.push_back({ &procedure, result, (bool)result, pc, base });
+  store.SetFrame(cells, procedure.locals);
+  if ((int)registers.size() < arguments + bytecode.registers) registers.resize(arguments + bytecode.registers);
+  Bind(procedure, arguments);
+
+  base = arguments;
+  pc = bytecode.entries[procedure.index];
+}
+
+// Define the parameters of `procedure` in its frame from the registers at `arguments`
+void VirtualMachine::Bind(const Ast::Procedure& procedure, const int arguments) {
+  const int count = procedure.parameters.size();
+  for (int i = 0; i < count; ++i) {
+    const auto& parameter = *procedure.parameters[i];
+    store.Add(parameter.slot, { parameter.key, parameter.name, parameter.primitive, registers[arguments + i] });
+  }
+}
+
+void VirtualMachine::Return(const Instruction& instruction) {
+  const auto frame = frames.back();
+  if (!instruction.b && frame.required) throw std::runtime_error("Procedure `" + frame.procedure->name + "` did not return a value!");
+
+  Value value = instruction.b ? Register(instruction.a) : Value{};
+  frames.pop_back();
+  store.SetFrame(locals.Pop(), frame.procedure->locals);
+  if (frame.result) store.Set(frame.result->slot, std::move(value));
+
+  pc = frame.pc;
+  base = frame.base;
+}
+
+// Scripts //
+
+void VirtualMachine::Exchange(Thread& thread) {
+  std::swap(pc, thread.pc);
+  std::swap(base, thread.base);
+  std::swap(registers, thread.registers);
+  std::swap(frames, thread.frames);
+  std::swap(locals, thread.locals);
+}
+
+bool VirtualMachine::Switch() {
+  const int running = scheduler.Current();
+  const int next = scheduler.Next();
+  if (next == running) return !scheduler.Idle();
+
+  Exchange(scripts[running]);
+  Exchange(scripts[next]);
+  static const std::vector<int> GLOBALS{};
+  store.SetFrame(locals.Top(), frames.empty() ? GLOBALS : frames.back().procedure->locals);
+  return true;
+}
+
+// Dispatch //
+
+template<bool TIERED>
+bool VirtualMachine::Interpret(int instructions) {
+  const auto* code = bytecode.code.data();
+  auto* r = registers.data() + base;
+
+  for (; instructions > 0; --instructions) {
+    if constexpr (TIERED) ++executed; // compiled code runs the others, counted from its fuel
+    const int at = pc;
+    const auto& instruction = code[pc++];
+    const int a = instruction.a;
+    const int b = instruction.b;
+    const int c = instruction.c;
+
+    switch (instruction.op) {
+      // Values //
+      case Opcode::LOAD_CONSTANT:   r[a] = bytecode.constants[b]; break;
+      case Opcode::LOAD:            r[a] = store.Get(b).Get(); break;
+      case Opcode::STORE:           store.Set(a, r[b]); break;
+      case Opcode::DEFINE:
+      case Opcode::DEFINE_DEFAULT:  Define(instruction); break;
+      case Opcode::INCREMENT:       Step(instruction, 1); break;
+      case Opcode::DECREMENT:       Step(instruction, -1); break;
+      case Opcode::INCREMENT_INTEGER: {
+        auto& value = store.Edit(a);
+        value = value.As<int>() + b;
+        break;
+      }
+
+      // Lists //
+      case Opcode::NEW_LIST:        r[a] = Value{Value::List{}}; break;
+      case Opcode::PUSH:            r[a].EditList().push_back(r[b]); break;
+      case Opcode::RESERVE:
+        r[a] = Integer(a); // compared as an integer by the fill loop
+        if (Proven(a) < MIN_ARRAY_SIZE) throw std::range_error("List reserve is less than 0!");
+        if (Proven(a) > MAX_ARRAY_SIZE) throw std::range_error("List reserve is greater than MAX_LIST_LENGTH!");
+        break;
+      case Opcode::FILL:            r[a] = Value::Fill(r[b], Proven(c)); break;
+      case Opcode::RANGE:           Range(instruction); break;
+      case Opcode::INDEX:           Index(instruction); break;
+      case Opcode::ELEMENT:         r[a] = r[b].At(Proven(c)); break;
+      case Opcode::ITERATE:
+        if (!r[a].Is<Value::List>()) throw std::invalid_argument("Foreach LIST must be a `list`!");
+        r[b] = r[a].Size();
+        break;
+      case Opcode::APPEND:          Append(instruction); break;
+      case Opcode::REMOVE:          Remove(instruction); break;
+      case Opcode::SIZE:            Size(instruction); break;
+
+      // Arithmetic //
+      case Opcode::ADD:             r[a] = Proven(b) + Proven(c); break;
+      case Opcode::SUBTRACT:        r[a] = Proven(b) - Proven(c); break;
+      case Opcode::MULTIPLY:        r[a] = Proven(b) * Proven(c); break;
+      case Opcode::DIVIDE:          r[a] = Proven(b) / Proven(c); break;
+      case Opcode::MODULO:          r[a] = Proven(b) % Proven(c); break;
+      case Opcode::EXPONENT:        r[a] = Kernel::Binary(NodeType::EXPONENT, Proven(b), Proven(c)); break;
+      case Opcode::MIN:             r[a] = std::min(Proven(b), Proven(c)); break;
+      case Opcode::MAX:             r[a] = std::max(Proven(b), Proven(c)); break;
+      case Opcode::RANDOM:          r[a] = Random::generate(Proven(b), Proven(c)); break;
+      case Opcode::MATH:            r[a] = Kernel::Unary(instruction.operation, Proven(b)); break;
+      case Opcode::NUMERIC:         r[a] = Kernel::Arithmetic(instruction.operation, r[b], r[c]); break;
+      case Opcode::REAL:
+        r[a] = IsUnaryOperation(instruction.operation)
+          ? Kernel::Unary<double>(instruction.operation, Real(b))
+          : Kernel::Binary<double>(instruction.operation, Real(b), Real(c));
+        break;
+      case Opcode::PROMOTE:         r[a] = (double)Proven(a); break;
+
+      // Conditions //
+      case Opcode::EQ:              r[a] = r[b] == r[c]; break;
+      case Opcode::NE:              r[a] = r[b] != r[c]; break;
+      case Opcode::GT:              r[a] = r[b] > r[c]; break;
+      case Opcode::GE:              r[a] = r[b] >= r[c]; break;
+      case Opcode::LT:              r[a] = r[b] < r[c]; break;
+      case Opcode::LE:              r[a] = r[b] <= r[c]; break;
+      case Opcode::AND:             r[a] = Boolean(b) && Boolean(c); break;
+      case Opcode::OR:              r[a] = Boolean(b) || Boolean(c); break;
+      case Opcode::XOR:             r[a] = Boolean(b) != Boolean(c); break;
+      case Opcode::NOT:             r[a] = !Boolean(b); break;
+      case Opcode::COMPARE_INTEGER: r[a] = Kernel::Compare(instruction.operation, Proven(b), Proven(c)); break;
+
+      // Control Flow //
+      case Opcode::JUMP:            pc = a; break;
+      case Opcode::JUMP_IF:         if (Boolean(a)) pc = b; break;
+      case Opcode::JUMP_UNLESS:     if (!Boolean(a)) pc = b; break;
+      case Opcode::JUMP_COMPARE:    if (Kernel::Compare(instruction.operation, r[a], r[b])) pc = c; break;
+      case Opcode::JUMP_COMPARE_INTEGER: if (Kernel::Compare(instruction.operation, Proven(a), Proven(b))) pc = c; break;
+      case Opcode::REPEAT:
+        r[a] = Integer(a); // compared as an integer by the loop
+        if (Proven(a) < 0) throw std::range_error("Repeat TIMES is less than 0!");
+        if (Proven(a) > MAX_REPEAT_LENGTH) throw std::range_error("Repeat TIMES is greater than MAX_REPEAT_LENGTH!");
+        break;
+      case Opcode::STEP:            r[a] = Proven(a) + 1; break;
+      case Opcode::PARALLEL:        RunParallel(*bytecode.parallels[a], store); break;
+      case Opcode::HALT:            --pc; scheduler.Stop(); return false; // stay halted
+      case Opcode::FAIL:            throw std::runtime_error(bytecode.constants[a].Get<std::string>());
+
+      // Procedures //
+      case Opcode::CALL:            Call(instruction); r = registers.data() + base; break; // the registers may have grown
+      case Opcode::RETURN:          Return(instruction); r = registers.data() + base; break;
+
+      // Scripts //
+      case Opcode::YIELD:           scheduler.Yield(); return true;
+      case Opcode::WAIT:            scheduler.Sleep(scheduler.After(Integer(a))); return true;
+      case Opcode::WAIT_FRAME:      scheduler.WaitFrame(); return true;
+      case Opcode::END:             --pc; return false; // stay finished
+
+      // Rendering //
+      case Opcode::DRAW_LINE:       renderer.DrawLine({ Integer(a), Integer(a + 1) }, { Integer(a + 2), Integer(a + 3) }); break;
+      case Opcode::DRAW_RECT:       renderer.DrawRect({ { Integer(a), Integer(a + 1) }, { Integer(a + 2), Integer(a + 3) } }); break;
+      case Opcode::DRAW_PIXEL:      renderer.DrawPixel({ Integer(a), Integer(a + 1) }); break;
+      case Opcode::CLEAR_SCREEN:
+        renderer.Clear();
+        renderer.Present();
+        break;
+
+      // I/O //
+      case Opcode::PRINT:
+        if (outputQuota > 0 && printed >= outputQuota) throw Governor::Exceeded(Governor::Reason::OUTPUT);
+        printed += PrintValue(r[a]);
+        break;
+      case Opcode::CLEAR_OUTPUT:
+#ifdef __EMSCRIPTEN__
+        ClientClearOutput();
+#endif // __EMSCRIPTEN__
+        break;
+
+      // Superinstructions //
+      case Opcode::LOOP:            r[a] = Proven(a) + 1; pc = Proven(a) < Proven(b) ? c : pc + 1; break;
+      case Opcode::JUMP_COMPARE_OPERANDS: {
+        const auto& left = Operand(a); // loaded in order
+        pc = Kernel::Compare(instruction.operation, left, Operand(b)) ? c : pc + 2;
+        break;
+      }
+      case Opcode::JUMP_COMPARE_INTEGER_OPERANDS: {
+        const int left = Operand(a).As<int>();
+        pc = Kernel::Compare(instruction.operation, left, Operand(b).As<int>()) ? c : pc + 2;
+        break;
+      }
+      case Opcode::DRAW_OPERANDS:   Draw(instruction); pc += b; break;
+    }
+
+#if __JIT__
+    if constexpr (TIERED) if (pc <= at && tiered) Tier(instructions); // a back-edge
+#endif // __JIT__
+  }
+
+  return true;
+}
+
+bool VirtualMachine::Run(int instructions) {
+  if (bytecode.code.empty()) return false; // nothing loaded
+
+  // the running script is given what is left of its quantum
+  if (scheduler.Idle() && !Switch()) return true; // every script is still waiting
+  while (instructions > 0) {
+    const int quantum = std::min(instructions, scheduler.Remaining());
+    instructions -= quantum;
+    if (Interpret<true>(quantum)) {
+      if (!scheduler.Spend(quantum) && !Switch()) return true; // every script is waiting
+      continue;
+    }
+
+    if (!scheduler.Finish()) return false; // every script has finished
+    if (!Switch()) return true;
+  }
+  return true;
+}
+
+// Tiering //
+
+void VirtualMachine::Tier(int& instructions) {
+#if __JIT__
+  auto* trace = jit.Find(pc);
+  if (!trace) {
+    if (!jit.Heat(pc)) return;
+    trace = jit.Compile(bytecode, pc, store, Execute, this);
+    if (!trace) return;
+  }
+  auto* window = registers.data() + base;
+  if (!jit.Enter(pc, window, store)) return;
+
+  const int64_t budget = (int64_t)instructions * NATIVE_SPEEDUP;
+  int64_t fuel = budget;
+  pc = trace->entry(window, &fuel);
+  executed += budget - fuel; // each iteration spends the instructions of the loop
+  instructions = fuel / NATIVE_SPEEDUP;
+#endif // __JIT__
+}
+
+int VirtualMachine::Execute(Jit::MachinePtr machine, const int at) {
+  auto& vm = *static_cast<VirtualMachine*>(machine);
+  try {
+    vm.pc = at;
+    vm.Interpret<false>(1);
+    return vm.pc;
+  } catch (...) {
+    return Jit::FAILED; // compiled code leaves at the instruction, which the interpreter runs again to throw
+  }
+}
+
+// API //
+
+std::pair<size_t, int> VirtualMachine::Measure() const {
+  auto [bytes, longest] = store.Measure();
+  bytes += locals.Footprint(longest);
+  for (const auto& script : scripts) bytes += script.locals.Footprint(longest); // the running script's thread was swapped out for an empty one
+  return { bytes, longest };
+}
+
+void VirtualMachine::Load(AbstractSyntaxTree tree) {
+  program = std::move(tree);
+  bytecode = Compiler{}.Compile(program);
+  Peephole{}.Fuse(bytecode);
+
+  registers.assign(bytecode.registers, Value{});
+  store.Allocate(program.GetSlots(), program.GetOffsets());
+  pc = 0;
+  base = 0;
+  frames.clear();
+  locals.Empty();
+  jit.Reset(bytecode.code.size());
+  printed = 0;
+  executed = 0;
+
+  // each script starts at its body in registers of its own
+  std::vector<int> priorities{ Ast::Script::MIN_PRIORITY };
+  scripts.assign(1, Thread{});
+  for (const auto& node : program.GetTree()) {
+    if (node->type != NodeType::SCRIPT) continue;
+    const auto& script = GetNode<Ast::Script>(*node);
+    priorities.push_back(script.priority);
+    scripts.push_back({ .pc = bytecode.starts[script.index], .base = 0, .registers = std::vector<Value>(bytecode.registers), .frames = {}, .locals = {} });
+  }
+  scheduler.Reset(priorities);
+
+  Log("Compiled " + std::to_string(bytecode.code.size()) + " instructions using " + std::to_string(bytecode.registers) + " registers");
+}
+
+// Construction //
+
+VirtualMachine::VirtualMachine(Renderer& renderer) : renderer(renderer), store() { }